@@ -0,0 +1,81 @@
+/* Copyright (c) 2014 Vyacheslav Slinko
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/* Prints LINES alternating strings and numbers through the printLine of the
+ * generated C runtime, or through puts, and reports the lines per second to
+ * stderr:
+ *
+ *     print_lines buffered|unbuffered|puts LINES > output
+ *
+ * Unbuffered output is flushed after every line, as on a terminal. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "joint_runtime.h"
+
+static double print_lines_now(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (double) now.tv_sec + (double) now.tv_nsec / 1e9;
+}
+
+int main(int argc, char ** argv) {
+    if (argc != 3) {
+        fprintf(stderr, "Usage: %s buffered|unbuffered|puts LINES\n", argv[0]);
+        return 1;
+    }
+
+    const char * mode = argv[1];
+    long lines = atol(argv[2]);
+    double started_at = print_lines_now();
+
+    if (strcmp(mode, "puts") == 0) {
+        char buffer[32];
+
+        for (long i = 0; i < lines; i++) {
+            if (i % 2 == 0) {
+                puts("Hello, World!");
+            } else {
+                snprintf(buffer, sizeof(buffer), "%.17g", (double) i);
+                puts(buffer);
+            }
+        }
+
+        fflush(stdout);
+    } else {
+        joint_output_state.terminal = strcmp(mode, "unbuffered") == 0;
+
+        for (long i = 0; i < lines; i++) {
+            joint_io_printLine(i % 2 == 0 ? joint_string("Hello, World!") : joint_number((double) i));
+        }
+
+        if (joint_exit() != 0) {
+            return 1;
+        }
+    }
+
+    fprintf(stderr, "%.1f M lines/s\n", (double) lines / (print_lines_now() - started_at) / 1e6);
+
+    return 0;
+}
@@ -0,0 +1,74 @@
+#!/bin/sh
+# Runs the benchmarks against a built tree:
+#
+#     bench/run.sh [STATEMENTS]
+#
+# JOINT names the compiler, ./build/Default/joint by default. The generated
+# program is a straight-line script of STATEMENTS bindings, each printed
+# once, as the scripts the backends were written for.
+
+set -e
+
+JOINT=${JOINT:-./build/Default/joint}
+STATEMENTS=${1:-100000}
+DIRECTORY=$(mktemp -d)
+trap 'rm -rf "$DIRECTORY"' EXIT
+
+awk -v statements="$STATEMENTS" 'BEGIN {
+    print "import {printLine} from \"io\";"
+    for (i = 0; i < statements; i++) {
+        printf "let value%d:Number = %d;\nprintLine(value%d);\n", i, i, i
+    }
+}' > "$DIRECTORY/script.joint"
+
+# Best wall time of five runs in milliseconds. --stats is left off since it
+# makes the JIT call builtins through the counting path, and the output goes
+# to a file so that the terminal is not measured.
+wall_time() {
+    for run in 1 2 3 4 5; do
+        start=$(date +%s%N)
+        "$JOINT" run "$@" "$DIRECTORY/script.joint" > "$DIRECTORY/output.txt"
+        end=$(date +%s%N)
+        echo $(((end - start) / 1000000))
+    done | sort -n | head -n 1
+}
+
+# Compile time is part of startup, so it is included for both engines.
+echo "$STATEMENTS statements, milliseconds:"
+echo "interpreter: $(wall_time)"
+echo "JIT: $(wall_time --jit)"
+
+# printLine of the generated C runtime against plain puts, best of five
+# runs written to a file.
+cc -O2 -I runtime bench/print_lines.c -o "$DIRECTORY/print_lines"
+
+echo
+echo "printLine, 2000000 lines:"
+
+for mode in buffered unbuffered puts; do
+    for run in 1 2 3 4 5; do
+        "$DIRECTORY/print_lines" $mode 2000000 2>&1 > "$DIRECTORY/lines.txt"
+    done | sort -n | tail -n 1 | sed "s/^/$mode: /"
+done
+
+# printLine of the interpreter, which buffers its output when it does not go
+# to a terminal, on STATEMENTS calls alternating the same string and numbers
+# as above. The rate comes from the run time of --stats so that compiling
+# the script is left out, best of five runs written to a file.
+awk -v lines="$STATEMENTS" 'BEGIN {
+    print "import {printLine} from \"io\";"
+    for (i = 0; i < lines; i++) {
+        if (i % 2 == 0) {
+            print "printLine(\"Hello, World!\");"
+        } else {
+            printf "printLine(%d);\n", i
+        }
+    }
+}' > "$DIRECTORY/lines.joint"
+
+echo
+echo "printLine of joint run, $STATEMENTS lines:"
+
+for run in 1 2 3 4 5; do
+    "$JOINT" run --stats "$DIRECTORY/lines.joint" 2>&1 > "$DIRECTORY/lines.txt" | awk '$1 == "run" && $2 == "time:" { print $3 }'
+done | sort -n | head -n 1 | awk -v lines="$STATEMENTS" '{ printf "interpreter: %.1f M lines/s\n", lines / $1 }'
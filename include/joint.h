@@ -0,0 +1,47 @@
+/* Copyright (c) 2014 Vyacheslav Slinko
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef joint_h
+#define joint_h
+
+/* Public interface of libjoint. A tool compiles snippets held in its own
+ * memory through a reusable context:
+ *
+ *     joint_context_t * context = joint_context_alloc(NULL);
+ *     joint_node_t * program = joint_context_compile(context, "snippet.joint", data, length);
+ *     if (program == NULL) {
+ *         fprintf(stderr, "%s\n", context->error);
+ *     }
+ *     ...
+ *     joint_context_free(context);
+ *
+ * The AST and tokens can be walked with the node API or written out with
+ * the dump API. */
+
+#include "allocator.h"
+#include "context.h"
+#include "dump.h"
+#include "node.h"
+#include "parser.h"
+#include "tokenizer.h"
+#include "writer.h"
+
+#endif
@@ -1,14 +1,71 @@
 {
     "targets": [
         {
-            "target_name": "joint",
-            "type": "executable",
+            "target_name": "libjoint",
+            "product_name": "joint",
+            "type": "<(library)",
             "sources": [
-                "src/joint.c",
                 "src/source_file.c",
-                "src/string.c",
+                "src/joint_string.c",
                 "src/tokenizer.c",
-                "src/parser.c"
+                "src/parser.c",
+                "src/node.c",
+                "src/writer.c",
+                "src/dump.c",
+                "src/hash.c",
+                "src/stats.c",
+                "src/cache.c",
+                "src/server.c",
+                "src/incremental.c",
+                "src/module.c",
+                "src/watch.c",
+                "src/intern.c",
+                "src/value.c",
+                "src/builtins.c",
+                "src/bytecode.c",
+                "src/interpreter.c",
+                "src/jit.c",
+                "src/c_backend.c",
+                "src/symbol_table.c",
+                "src/semantic.c",
+                "src/interface.c",
+                "src/optimizer.c",
+                "src/passes.c",
+                "src/parallel_tokenizer.c",
+                "src/parallel_parser.c",
+                "src/allocator.c",
+                "src/context.c",
+                "src/utf8.c",
+                "src/constants.c",
+                "src/loader.c"
+            ],
+            "direct_dependent_settings": {
+                "include_dirs": [
+                    "include",
+                    "src"
+                ]
+            },
+            "conditions": [
+                ["OS!='mac'", {
+                    "cflags": [
+                        "-fPIC"
+                    ],
+                    "link_settings": {
+                        "libraries": [
+                            "-lpthread"
+                        ]
+                    }
+                }]
+            ]
+        },
+        {
+            "target_name": "joint",
+            "type": "executable",
+            "dependencies": [
+                "libjoint"
+            ],
+            "sources": [
+                "src/joint.c"
             ],
             "conditions": [
                 ["OS=='mac'", {
@@ -22,6 +79,36 @@
                     }
                 }]
             ]
+        },
+        {
+            "target_name": "large_source",
+            "type": "executable",
+            "dependencies": [
+                "libjoint"
+            ],
+            "sources": [
+                "tests/large_source.c"
+            ]
+        },
+        {
+            "target_name": "deep_nesting",
+            "type": "executable",
+            "dependencies": [
+                "libjoint"
+            ],
+            "sources": [
+                "tests/deep_nesting.c"
+            ]
+        },
+        {
+            "target_name": "incremental",
+            "type": "executable",
+            "dependencies": [
+                "libjoint"
+            ],
+            "sources": [
+                "tests/incremental.c"
+            ]
         }
     ]
 }
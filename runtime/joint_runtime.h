@@ -0,0 +1,274 @@
+/* Copyright (c) 2014 Vyacheslav Slinko
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/* Runtime of C translation units produced by `joint --emit=c`. */
+
+#ifndef joint_runtime_h
+#define joint_runtime_h
+
+#include <errno.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+/* Generated programs keep every binding, used or not. */
+#if defined(__GNUC__)
+#pragma GCC diagnostic ignored "-Wunused-variable"
+#endif
+
+typedef struct joint_builtin joint_builtin;
+
+typedef struct joint_value {
+    enum {
+        JOINT_NULL,
+        JOINT_NUMBER,
+        JOINT_BOOLEAN,
+        JOINT_CHARACTER,
+        JOINT_STRING,
+        JOINT_FUNCTION
+    } type;
+
+    union {
+        double number;
+        bool boolean;
+        char character;
+        const char * string;
+        const joint_builtin * function;
+    } as;
+} joint_value;
+
+struct joint_builtin {
+    const char * name;
+    int arguments_length;
+    joint_value (* function)(const joint_value * arguments);
+};
+
+static inline joint_value joint_null(void) {
+    joint_value value = {.type = JOINT_NULL};
+    return value;
+}
+
+static inline joint_value joint_number(double number) {
+    joint_value value = {.type = JOINT_NUMBER, .as.number = number};
+    return value;
+}
+
+static inline joint_value joint_boolean(bool boolean) {
+    joint_value value = {.type = JOINT_BOOLEAN, .as.boolean = boolean};
+    return value;
+}
+
+static inline joint_value joint_character(char character) {
+    joint_value value = {.type = JOINT_CHARACTER, .as.character = character};
+    return value;
+}
+
+static inline joint_value joint_string(const char * string) {
+    joint_value value = {.type = JOINT_STRING, .as.string = string};
+    return value;
+}
+
+static inline joint_value joint_function(const joint_builtin * function) {
+    joint_value value = {.type = JOINT_FUNCTION, .as.function = function};
+    return value;
+}
+
+/* Standard output is buffered here rather than in stdio, the buffer is
+ * written with writev, together with strings too long to copy into it. */
+
+#define JOINT_OUTPUT_CAPACITY (1 << 16)
+
+typedef struct joint_output {
+    size_t length;
+    int terminal;
+    int failed;
+    char buffer[JOINT_OUTPUT_CAPACITY];
+} joint_output;
+
+static joint_output joint_output_state = {.length = 0, .terminal = -1, .failed = 0};
+
+static inline void joint_output_writev(struct iovec * iov, int iovcnt) {
+    while (iovcnt > 0 && !joint_output_state.failed) {
+        ssize_t written = writev(STDOUT_FILENO, iov, iovcnt);
+
+        if (written < 0) {
+            joint_output_state.failed = errno != EINTR;
+            continue;
+        }
+
+        while (iovcnt > 0 && (size_t) written >= iov->iov_len) {
+            written -= (ssize_t) iov->iov_len;
+            iov++;
+            iovcnt--;
+        }
+
+        if (iovcnt > 0) {
+            iov->iov_base = (char *) iov->iov_base + written;
+            iov->iov_len -= (size_t) written;
+        }
+    }
+}
+
+static inline int joint_output_flush(void) {
+    struct iovec iov = {.iov_base = joint_output_state.buffer, .iov_len = joint_output_state.length};
+    joint_output_state.length = 0;
+    joint_output_writev(&iov, iov.iov_len > 0 ? 1 : 0);
+
+    return !joint_output_state.failed;
+}
+
+static inline void joint_output_write(const char * data, size_t length) {
+    if (JOINT_OUTPUT_CAPACITY - joint_output_state.length >= length) {
+        memcpy(joint_output_state.buffer + joint_output_state.length, data, length);
+        joint_output_state.length += length;
+        return;
+    }
+
+    struct iovec iov[2] = {
+        {.iov_base = joint_output_state.buffer, .iov_len = joint_output_state.length},
+        {.iov_base = (void *) data, .iov_len = length}
+    };
+
+    joint_output_state.length = 0;
+    joint_output_writev(iov, 2);
+}
+
+static inline void joint_output_reserve(size_t length) {
+    if (JOINT_OUTPUT_CAPACITY - joint_output_state.length < length) {
+        joint_output_flush();
+    }
+}
+
+static inline void joint_output_number(double number) {
+    joint_output_reserve(32);
+
+    char * target = joint_output_state.buffer + joint_output_state.length;
+
+    if (number > -9e18 && number < 9e18 && number == (double) (int64_t) number) {
+        char digits[20];
+        int length = 0;
+        int64_t integer = (int64_t) number;
+        uint64_t magnitude = integer < 0 ? -(uint64_t) integer : (uint64_t) integer;
+
+        do {
+            digits[sizeof(digits) - ++length] = (char) ('0' + magnitude % 10);
+            magnitude /= 10;
+        } while (magnitude > 0);
+
+        if (integer < 0) {
+            *target++ = '-';
+            joint_output_state.length++;
+        }
+
+        memcpy(target, digits + sizeof(digits) - length, (size_t) length);
+        joint_output_state.length += (size_t) length;
+    } else {
+        joint_output_state.length += (size_t) snprintf(target, 32, "%.17g", number);
+    }
+}
+
+static inline void joint_print(joint_value value) {
+    switch (value.type) {
+        case JOINT_NULL:
+            joint_output_write("null", 4);
+            break;
+
+        case JOINT_NUMBER:
+            joint_output_number(value.as.number);
+            break;
+
+        case JOINT_BOOLEAN:
+            if (value.as.boolean) {
+                joint_output_write("true", 4);
+            } else {
+                joint_output_write("false", 5);
+            }
+            break;
+
+        case JOINT_CHARACTER:
+            joint_output_write(&value.as.character, 1);
+            break;
+
+        case JOINT_STRING:
+            joint_output_write(value.as.string, strlen(value.as.string));
+            break;
+
+        case JOINT_FUNCTION:
+            joint_output_write("[function ", 10);
+            joint_output_write(value.as.function->name, strlen(value.as.function->name));
+            joint_output_write("]", 1);
+            break;
+    }
+}
+
+static inline void joint_fail(const char * message) {
+    joint_output_flush();
+    fprintf(stderr, "Runtime error: %s\n", message);
+    exit(1);
+}
+
+static inline joint_value joint_call(joint_value callee, int arguments_length, const joint_value * arguments) {
+    if (callee.type != JOINT_FUNCTION) {
+        joint_fail("value is not a function");
+    }
+
+    if (arguments_length != callee.as.function->arguments_length) {
+        joint_output_flush();
+        fprintf(stderr, "Runtime error: %s expects %d arguments, %d given\n", callee.as.function->name, callee.as.function->arguments_length, arguments_length);
+        exit(1);
+    }
+
+    return callee.as.function->function(arguments);
+}
+
+static inline int joint_exit(void) {
+    return joint_output_flush() ? 0 : 1;
+}
+
+/* io */
+
+static inline joint_value joint_io_printLine(joint_value value) {
+    joint_print(value);
+    joint_output_write("\n", 1);
+
+    if (joint_output_state.terminal < 0) {
+        joint_output_state.terminal = isatty(STDOUT_FILENO);
+    }
+
+    if (joint_output_state.terminal) {
+        joint_output_flush();
+    }
+
+    return joint_null();
+}
+
+static inline joint_value joint_io_printLine_function(const joint_value * arguments) {
+    return joint_io_printLine(arguments[0]);
+}
+
+static const joint_builtin joint_io_printLine_builtin = {"printLine", 1, joint_io_printLine_function};
+
+#endif
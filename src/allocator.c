@@ -0,0 +1,807 @@
+/* Copyright (c) 2014 Vyacheslav Slinko
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "allocator.h"
+
+#define JOINT_ALLOCATOR_ALIGNMENT 16
+#define JOINT_POOL_ALLOCATOR_CLASSES 9
+#define JOINT_POOL_ALLOCATOR_LARGE ((size_t) -1)
+#define JOINT_POOL_ALLOCATOR_SLAB_SIZE (64 * 1024)
+
+/* Precedes every allocation of the arena, pool and tracking allocators and
+ * keeps the payload aligned like malloc does. */
+typedef struct joint_allocator_header {
+    size_t size;
+    size_t tag;
+} joint_allocator_header_t;
+
+typedef struct joint_arena_allocator {
+    joint_allocator_t allocator;
+    pthread_mutex_t mutex;
+
+    size_t block_size;
+    char * block;
+    size_t block_used;
+    char * last;
+
+    size_t blocks_length;
+    size_t blocks_capacity;
+    void ** blocks;
+} joint_arena_allocator_t;
+
+/* Allocations above the largest size class come from malloc and are linked
+ * in front of their header, so that destroying the pool frees them too. */
+typedef struct joint_pool_allocator_large {
+    struct joint_pool_allocator_large * previous;
+    struct joint_pool_allocator_large * next;
+} joint_pool_allocator_large_t;
+
+typedef struct joint_pool_allocator {
+    joint_allocator_t allocator;
+    pthread_mutex_t mutex;
+
+    void * free_lists[JOINT_POOL_ALLOCATOR_CLASSES];
+    joint_pool_allocator_large_t * large;
+
+    char * slab;
+    size_t slab_used;
+
+    size_t slabs_length;
+    size_t slabs_capacity;
+    void ** slabs;
+} joint_pool_allocator_t;
+
+typedef struct joint_tracking_allocator_site {
+    const char * site;
+    uint64_t calls;
+    uint64_t bytes;
+    char * calls_name;
+    char * bytes_name;
+} joint_tracking_allocator_site_t;
+
+typedef struct joint_tracking_allocator {
+    joint_allocator_t allocator;
+    pthread_mutex_t mutex;
+    joint_allocator_t * parent;
+
+    uint64_t live_bytes;
+    uint64_t peak_bytes;
+
+    size_t sites_length;
+    size_t sites_capacity;
+    joint_tracking_allocator_site_t * sites;
+} joint_tracking_allocator_t;
+
+static inline size_t joint_allocator_round(size_t size) {
+    return (size + JOINT_ALLOCATOR_ALIGNMENT - 1) & ~((size_t) JOINT_ALLOCATOR_ALIGNMENT - 1);
+}
+
+static inline joint_allocator_header_t * joint_allocator_header(void * pointer) {
+    return (joint_allocator_header_t *) pointer - 1;
+}
+
+static void * joint_system_allocator_allocate(joint_allocator_t * allocator, size_t size, const char * site) {
+    return malloc(size);
+}
+
+static void * joint_system_allocator_reallocate(joint_allocator_t * allocator, void * pointer, size_t size, const char * site) {
+    return realloc(pointer, size);
+}
+
+static void joint_system_allocator_deallocate(joint_allocator_t * allocator, void * pointer) {
+    free(pointer);
+}
+
+static void joint_system_allocator_destroy(joint_allocator_t * allocator) {
+}
+
+static joint_allocator_t joint_system_allocator = {
+    .allocate = joint_system_allocator_allocate,
+    .reallocate = joint_system_allocator_reallocate,
+    .deallocate = joint_system_allocator_deallocate,
+    .destroy = joint_system_allocator_destroy
+};
+
+joint_allocator_t * joint_allocator_system(void) {
+    return &joint_system_allocator;
+}
+
+static size_t joint_arena_allocator_add_block(joint_arena_allocator_t * arena, void * block) {
+    if (arena->blocks_length == arena->blocks_capacity) {
+        arena->blocks_capacity = arena->blocks_capacity == 0 ? 16 : arena->blocks_capacity * 2;
+        arena->blocks = realloc(arena->blocks, sizeof(void *) * arena->blocks_capacity);
+        assert(arena->blocks);
+    }
+
+    arena->blocks[arena->blocks_length] = block;
+
+    return arena->blocks_length++;
+}
+
+/* Requests above a quarter of the block size get a block of their own,
+ * tagged with its index plus one so it can be resized and freed alone. The
+ * header of the others holds the rounded up size they can grow to in
+ * place. */
+static void * joint_arena_allocator_allocate_locked(joint_arena_allocator_t * arena, size_t size) {
+    size_t length = sizeof(joint_allocator_header_t) + joint_allocator_round(size);
+    joint_allocator_header_t * header;
+
+    if (length > arena->block_size / 4) {
+        header = malloc(length);
+
+        if (header == NULL) {
+            return NULL;
+        }
+
+        header->size = size;
+        header->tag = joint_arena_allocator_add_block(arena, header) + 1;
+    } else {
+        if (arena->block == NULL || arena->block_used + length > arena->block_size) {
+            char * block = malloc(arena->block_size);
+
+            if (block == NULL) {
+                return NULL;
+            }
+
+            joint_arena_allocator_add_block(arena, block);
+            arena->block = block;
+            arena->block_used = 0;
+        }
+
+        header = (joint_allocator_header_t *) (arena->block + arena->block_used);
+        header->size = length - sizeof(joint_allocator_header_t);
+        header->tag = 0;
+        arena->block_used += length;
+        arena->last = (char *) (header + 1);
+    }
+
+    return header + 1;
+}
+
+static void * joint_arena_allocator_allocate(joint_allocator_t * allocator, size_t size, const char * site) {
+    joint_arena_allocator_t * arena = (joint_arena_allocator_t *) allocator;
+
+    pthread_mutex_lock(&arena->mutex);
+    void * pointer = joint_arena_allocator_allocate_locked(arena, size);
+    pthread_mutex_unlock(&arena->mutex);
+
+    return pointer;
+}
+
+static void * joint_arena_allocator_reallocate(joint_allocator_t * allocator, void * pointer, size_t size, const char * site) {
+    joint_arena_allocator_t * arena = (joint_arena_allocator_t *) allocator;
+
+    if (pointer == NULL) {
+        return joint_arena_allocator_allocate(allocator, size, site);
+    }
+
+    pthread_mutex_lock(&arena->mutex);
+
+    joint_allocator_header_t * header = joint_allocator_header(pointer);
+    void * reallocated = NULL;
+
+    if (header->tag != 0) {
+        size_t index = header->tag - 1;
+        header = realloc(header, sizeof(joint_allocator_header_t) + joint_allocator_round(size));
+
+        if (header != NULL) {
+            arena->blocks[index] = header;
+            header->size = size;
+            reallocated = header + 1;
+        }
+    } else if (size <= header->size) {
+        reallocated = pointer;
+    } else if (pointer == arena->last && (size_t) (arena->last - arena->block) + joint_allocator_round(size) <= arena->block_size) {
+        arena->block_used = (size_t) (arena->last - arena->block) + joint_allocator_round(size);
+        header->size = joint_allocator_round(size);
+        reallocated = pointer;
+    } else {
+        /* Moving doubles the room so arrays grown one element at a time do
+         * not copy themselves over the whole arena. */
+        reallocated = joint_arena_allocator_allocate_locked(arena, size > header->size * 2 ? size : header->size * 2);
+
+        if (reallocated != NULL) {
+            memcpy(reallocated, pointer, header->size);
+        }
+    }
+
+    pthread_mutex_unlock(&arena->mutex);
+
+    return reallocated;
+}
+
+static void joint_arena_allocator_deallocate(joint_allocator_t * allocator, void * pointer) {
+    joint_arena_allocator_t * arena = (joint_arena_allocator_t *) allocator;
+
+    if (pointer == NULL) {
+        return;
+    }
+
+    pthread_mutex_lock(&arena->mutex);
+
+    joint_allocator_header_t * header = joint_allocator_header(pointer);
+
+    if (header->tag != 0) {
+        arena->blocks[header->tag - 1] = NULL;
+        free(header);
+    } else if (pointer == arena->last) {
+        arena->block_used = (size_t) ((char *) header - arena->block);
+        arena->last = NULL;
+    }
+
+    pthread_mutex_unlock(&arena->mutex);
+}
+
+static void joint_arena_allocator_destroy(joint_allocator_t * allocator) {
+    joint_arena_allocator_t * arena = (joint_arena_allocator_t *) allocator;
+
+    for (size_t i = 0; i < arena->blocks_length; i++) {
+        free(arena->blocks[i]);
+    }
+
+    free(arena->blocks);
+    pthread_mutex_destroy(&arena->mutex);
+    free(arena);
+}
+
+joint_allocator_t * joint_allocator_arena_alloc(size_t block_size) {
+    joint_arena_allocator_t * arena = malloc(sizeof(joint_arena_allocator_t));
+    assert(arena);
+
+    arena->allocator.allocate = joint_arena_allocator_allocate;
+    arena->allocator.reallocate = joint_arena_allocator_reallocate;
+    arena->allocator.deallocate = joint_arena_allocator_deallocate;
+    arena->allocator.destroy = joint_arena_allocator_destroy;
+    pthread_mutex_init(&arena->mutex, NULL);
+
+    arena->block_size = block_size;
+    arena->block = NULL;
+    arena->block_used = 0;
+    arena->last = NULL;
+
+    arena->blocks_length = 0;
+    arena->blocks_capacity = 0;
+    arena->blocks = NULL;
+
+    return &arena->allocator;
+}
+
+/* Blocks of from move to arena as they are. A large block is told apart by
+ * its tag, the first header of a shared block is always untagged, and gets
+ * the tag of its new index. */
+static void joint_arena_allocator_merge(joint_arena_allocator_t * arena, joint_arena_allocator_t * from) {
+    pthread_mutex_lock(&arena->mutex);
+
+    for (size_t i = 0; i < from->blocks_length; i++) {
+        if (from->blocks[i] == NULL) {
+            continue;
+        }
+
+        joint_allocator_header_t * header = from->blocks[i];
+        size_t index = joint_arena_allocator_add_block(arena, header);
+
+        if (header->tag != 0) {
+            header->tag = index + 1;
+        }
+    }
+
+    pthread_mutex_unlock(&arena->mutex);
+
+    free(from->blocks);
+    pthread_mutex_destroy(&from->mutex);
+    free(from);
+}
+
+static size_t joint_pool_allocator_class(size_t size) {
+    size_t length = sizeof(joint_allocator_header_t) + size;
+
+    for (size_t size_class = 0; size_class < JOINT_POOL_ALLOCATOR_CLASSES; size_class++) {
+        if (length <= (size_t) JOINT_ALLOCATOR_ALIGNMENT << size_class) {
+            return size_class;
+        }
+    }
+
+    return JOINT_POOL_ALLOCATOR_LARGE;
+}
+
+static void joint_pool_allocator_link(joint_pool_allocator_t * pool, joint_pool_allocator_large_t * large) {
+    pthread_mutex_lock(&pool->mutex);
+    large->previous = NULL;
+    large->next = pool->large;
+
+    if (pool->large != NULL) {
+        pool->large->previous = large;
+    }
+
+    pool->large = large;
+    pthread_mutex_unlock(&pool->mutex);
+}
+
+static void joint_pool_allocator_unlink(joint_pool_allocator_t * pool, joint_pool_allocator_large_t * large) {
+    if (large->previous != NULL) {
+        large->previous->next = large->next;
+    } else {
+        pool->large = large->next;
+    }
+
+    if (large->next != NULL) {
+        large->next->previous = large->previous;
+    }
+}
+
+static void * joint_pool_allocator_allocate(joint_allocator_t * allocator, size_t size, const char * site) {
+    joint_pool_allocator_t * pool = (joint_pool_allocator_t *) allocator;
+    size_t size_class = joint_pool_allocator_class(size);
+    joint_allocator_header_t * header;
+
+    if (size_class == JOINT_POOL_ALLOCATOR_LARGE) {
+        joint_pool_allocator_large_t * large = malloc(sizeof(joint_pool_allocator_large_t) + sizeof(joint_allocator_header_t) + size);
+
+        if (large == NULL) {
+            return NULL;
+        }
+
+        joint_pool_allocator_link(pool, large);
+        header = (joint_allocator_header_t *) (large + 1);
+    } else {
+        size_t length = (size_t) JOINT_ALLOCATOR_ALIGNMENT << size_class;
+
+        pthread_mutex_lock(&pool->mutex);
+
+        if (pool->free_lists[size_class] != NULL) {
+            header = pool->free_lists[size_class];
+            pool->free_lists[size_class] = *(void **) header;
+        } else {
+            if (pool->slab == NULL || pool->slab_used + length > JOINT_POOL_ALLOCATOR_SLAB_SIZE) {
+                char * slab = malloc(JOINT_POOL_ALLOCATOR_SLAB_SIZE);
+
+                if (slab == NULL) {
+                    pthread_mutex_unlock(&pool->mutex);
+                    return NULL;
+                }
+
+                if (pool->slabs_length == pool->slabs_capacity) {
+                    pool->slabs_capacity = pool->slabs_capacity == 0 ? 16 : pool->slabs_capacity * 2;
+                    pool->slabs = realloc(pool->slabs, sizeof(void *) * pool->slabs_capacity);
+                    assert(pool->slabs);
+                }
+
+                pool->slabs[pool->slabs_length++] = slab;
+                pool->slab = slab;
+                pool->slab_used = 0;
+            }
+
+            header = (joint_allocator_header_t *) (pool->slab + pool->slab_used);
+            pool->slab_used += length;
+        }
+
+        pthread_mutex_unlock(&pool->mutex);
+    }
+
+    header->size = size;
+    header->tag = size_class;
+
+    return header + 1;
+}
+
+static void joint_pool_allocator_deallocate(joint_allocator_t * allocator, void * pointer) {
+    joint_pool_allocator_t * pool = (joint_pool_allocator_t *) allocator;
+
+    if (pointer == NULL) {
+        return;
+    }
+
+    joint_allocator_header_t * header = joint_allocator_header(pointer);
+
+    if (header->tag == JOINT_POOL_ALLOCATOR_LARGE) {
+        joint_pool_allocator_large_t * large = (joint_pool_allocator_large_t *) header - 1;
+
+        pthread_mutex_lock(&pool->mutex);
+        joint_pool_allocator_unlink(pool, large);
+        pthread_mutex_unlock(&pool->mutex);
+
+        free(large);
+        return;
+    }
+
+    pthread_mutex_lock(&pool->mutex);
+    *(void **) header = pool->free_lists[header->tag];
+    pool->free_lists[header->tag] = header;
+    pthread_mutex_unlock(&pool->mutex);
+}
+
+static void * joint_pool_allocator_reallocate(joint_allocator_t * allocator, void * pointer, size_t size, const char * site) {
+    joint_pool_allocator_t * pool = (joint_pool_allocator_t *) allocator;
+
+    if (pointer == NULL) {
+        return joint_pool_allocator_allocate(allocator, size, site);
+    }
+
+    joint_allocator_header_t * header = joint_allocator_header(pointer);
+
+    if (header->tag == JOINT_POOL_ALLOCATOR_LARGE && joint_pool_allocator_class(size) == JOINT_POOL_ALLOCATOR_LARGE) {
+        joint_pool_allocator_large_t * large = (joint_pool_allocator_large_t *) header - 1;
+
+        /* The block may move, so it leaves the list until it is linked
+         * again at its new address. */
+        pthread_mutex_lock(&pool->mutex);
+        joint_pool_allocator_unlink(pool, large);
+        pthread_mutex_unlock(&pool->mutex);
+
+        joint_pool_allocator_large_t * reallocated = realloc(large, sizeof(joint_pool_allocator_large_t) + sizeof(joint_allocator_header_t) + size);
+
+        if (reallocated == NULL) {
+            joint_pool_allocator_link(pool, large);
+            return NULL;
+        }
+
+        joint_pool_allocator_link(pool, reallocated);
+        header = (joint_allocator_header_t *) (reallocated + 1);
+        header->size = size;
+
+        return header + 1;
+    }
+
+    if (header->tag != JOINT_POOL_ALLOCATOR_LARGE && sizeof(joint_allocator_header_t) + size <= (size_t) JOINT_ALLOCATOR_ALIGNMENT << header->tag) {
+        header->size = size;
+        return pointer;
+    }
+
+    void * reallocated = joint_pool_allocator_allocate(allocator, size, site);
+
+    if (reallocated != NULL) {
+        memcpy(reallocated, pointer, header->size < size ? header->size : size);
+        joint_pool_allocator_deallocate(allocator, pointer);
+    }
+
+    return reallocated;
+}
+
+static void joint_pool_allocator_destroy(joint_allocator_t * allocator) {
+    joint_pool_allocator_t * pool = (joint_pool_allocator_t *) allocator;
+
+    for (size_t i = 0; i < pool->slabs_length; i++) {
+        free(pool->slabs[i]);
+    }
+
+    free(pool->slabs);
+
+    while (pool->large != NULL) {
+        joint_pool_allocator_large_t * next = pool->large->next;
+        free(pool->large);
+        pool->large = next;
+    }
+
+    pthread_mutex_destroy(&pool->mutex);
+    free(pool);
+}
+
+joint_allocator_t * joint_allocator_pool_alloc(void) {
+    joint_pool_allocator_t * pool = malloc(sizeof(joint_pool_allocator_t));
+    assert(pool);
+
+    pool->allocator.allocate = joint_pool_allocator_allocate;
+    pool->allocator.reallocate = joint_pool_allocator_reallocate;
+    pool->allocator.deallocate = joint_pool_allocator_deallocate;
+    pool->allocator.destroy = joint_pool_allocator_destroy;
+    pthread_mutex_init(&pool->mutex, NULL);
+
+    for (int i = 0; i < JOINT_POOL_ALLOCATOR_CLASSES; i++) {
+        pool->free_lists[i] = NULL;
+    }
+
+    pool->large = NULL;
+
+    pool->slab = NULL;
+    pool->slab_used = 0;
+
+    pool->slabs_length = 0;
+    pool->slabs_capacity = 0;
+    pool->slabs = NULL;
+
+    return &pool->allocator;
+}
+
+/* Slabs, free chunks and large blocks of from move to pool, the rest of the
+ * current slab of from is left unused. */
+static void joint_pool_allocator_merge(joint_pool_allocator_t * pool, joint_pool_allocator_t * from) {
+    pthread_mutex_lock(&pool->mutex);
+
+    for (size_t i = 0; i < from->slabs_length; i++) {
+        if (pool->slabs_length == pool->slabs_capacity) {
+            pool->slabs_capacity = pool->slabs_capacity == 0 ? 16 : pool->slabs_capacity * 2;
+            pool->slabs = realloc(pool->slabs, sizeof(void *) * pool->slabs_capacity);
+            assert(pool->slabs);
+        }
+
+        pool->slabs[pool->slabs_length++] = from->slabs[i];
+    }
+
+    for (int i = 0; i < JOINT_POOL_ALLOCATOR_CLASSES; i++) {
+        while (from->free_lists[i] != NULL) {
+            void * chunk = from->free_lists[i];
+            from->free_lists[i] = *(void **) chunk;
+            *(void **) chunk = pool->free_lists[i];
+            pool->free_lists[i] = chunk;
+        }
+    }
+
+    while (from->large != NULL) {
+        joint_pool_allocator_large_t * large = from->large;
+        from->large = large->next;
+
+        large->previous = NULL;
+        large->next = pool->large;
+
+        if (pool->large != NULL) {
+            pool->large->previous = large;
+        }
+
+        pool->large = large;
+    }
+
+    pthread_mutex_unlock(&pool->mutex);
+
+    free(from->slabs);
+    pthread_mutex_destroy(&from->mutex);
+    free(from);
+}
+
+static size_t joint_tracking_allocator_hash(const char * site, size_t capacity) {
+    return (size_t) (((uintptr_t) site >> 3) * 0x9E3779B97F4A7C15ull) & (capacity - 1);
+}
+
+static void joint_tracking_allocator_grow(joint_tracking_allocator_t * tracking) {
+    size_t capacity = tracking->sites_capacity == 0 ? 64 : tracking->sites_capacity * 2;
+    joint_tracking_allocator_site_t * sites = calloc(capacity, sizeof(joint_tracking_allocator_site_t));
+    assert(sites);
+
+    for (size_t i = 0; i < tracking->sites_capacity; i++) {
+        if (tracking->sites[i].site == NULL) {
+            continue;
+        }
+
+        size_t slot = joint_tracking_allocator_hash(tracking->sites[i].site, capacity);
+
+        while (sites[slot].site != NULL) {
+            slot = (slot + 1) & (capacity - 1);
+        }
+
+        sites[slot] = tracking->sites[i];
+    }
+
+    free(tracking->sites);
+    tracking->sites = sites;
+    tracking->sites_capacity = capacity;
+}
+
+static void joint_tracking_allocator_count(joint_tracking_allocator_t * tracking, const char * site, size_t size, size_t released) {
+    if ((tracking->sites_length + 1) * 2 > tracking->sites_capacity) {
+        joint_tracking_allocator_grow(tracking);
+    }
+
+    size_t slot = joint_tracking_allocator_hash(site, tracking->sites_capacity);
+
+    while (tracking->sites[slot].site != NULL && tracking->sites[slot].site != site) {
+        slot = (slot + 1) & (tracking->sites_capacity - 1);
+    }
+
+    if (tracking->sites[slot].site == NULL) {
+        tracking->sites[slot].site = site;
+        tracking->sites_length++;
+    }
+
+    tracking->sites[slot].calls++;
+    tracking->sites[slot].bytes += size;
+
+    tracking->live_bytes += size - released;
+
+    if (tracking->live_bytes > tracking->peak_bytes) {
+        tracking->peak_bytes = tracking->live_bytes;
+    }
+}
+
+static void * joint_tracking_allocator_allocate(joint_allocator_t * allocator, size_t size, const char * site) {
+    joint_tracking_allocator_t * tracking = (joint_tracking_allocator_t *) allocator;
+    joint_allocator_header_t * header = tracking->parent->allocate(tracking->parent, sizeof(joint_allocator_header_t) + size, site);
+
+    if (header == NULL) {
+        return NULL;
+    }
+
+    header->size = size;
+
+    pthread_mutex_lock(&tracking->mutex);
+    joint_tracking_allocator_count(tracking, site, size, 0);
+    pthread_mutex_unlock(&tracking->mutex);
+
+    return header + 1;
+}
+
+static void * joint_tracking_allocator_reallocate(joint_allocator_t * allocator, void * pointer, size_t size, const char * site) {
+    joint_tracking_allocator_t * tracking = (joint_tracking_allocator_t *) allocator;
+
+    if (pointer == NULL) {
+        return joint_tracking_allocator_allocate(allocator, size, site);
+    }
+
+    joint_allocator_header_t * header = joint_allocator_header(pointer);
+    size_t released = header->size;
+
+    header = tracking->parent->reallocate(tracking->parent, header, sizeof(joint_allocator_header_t) + size, site);
+
+    if (header == NULL) {
+        return NULL;
+    }
+
+    header->size = size;
+
+    pthread_mutex_lock(&tracking->mutex);
+    joint_tracking_allocator_count(tracking, site, size, released);
+    pthread_mutex_unlock(&tracking->mutex);
+
+    return header + 1;
+}
+
+static void joint_tracking_allocator_deallocate(joint_allocator_t * allocator, void * pointer) {
+    joint_tracking_allocator_t * tracking = (joint_tracking_allocator_t *) allocator;
+
+    if (pointer == NULL) {
+        return;
+    }
+
+    joint_allocator_header_t * header = joint_allocator_header(pointer);
+
+    pthread_mutex_lock(&tracking->mutex);
+    tracking->live_bytes -= header->size;
+    pthread_mutex_unlock(&tracking->mutex);
+
+    tracking->parent->deallocate(tracking->parent, header);
+}
+
+static void joint_tracking_allocator_destroy(joint_allocator_t * allocator) {
+    joint_tracking_allocator_t * tracking = (joint_tracking_allocator_t *) allocator;
+
+    for (size_t i = 0; i < tracking->sites_capacity; i++) {
+        free(tracking->sites[i].calls_name);
+        free(tracking->sites[i].bytes_name);
+    }
+
+    free(tracking->sites);
+    pthread_mutex_destroy(&tracking->mutex);
+    free(tracking);
+}
+
+joint_allocator_t * joint_allocator_tracking_alloc(joint_allocator_t * parent) {
+    joint_tracking_allocator_t * tracking = malloc(sizeof(joint_tracking_allocator_t));
+    assert(tracking);
+
+    tracking->allocator.allocate = joint_tracking_allocator_allocate;
+    tracking->allocator.reallocate = joint_tracking_allocator_reallocate;
+    tracking->allocator.deallocate = joint_tracking_allocator_deallocate;
+    tracking->allocator.destroy = joint_tracking_allocator_destroy;
+    pthread_mutex_init(&tracking->mutex, NULL);
+    tracking->parent = parent;
+
+    tracking->live_bytes = 0;
+    tracking->peak_bytes = 0;
+
+    tracking->sites_length = 0;
+    tracking->sites_capacity = 0;
+    tracking->sites = NULL;
+
+    return &tracking->allocator;
+}
+
+static int joint_tracking_allocator_compare_sites(const void * left, const void * right) {
+    return strcmp((*(const joint_tracking_allocator_site_t * const *) left)->site, (*(const joint_tracking_allocator_site_t * const *) right)->site);
+}
+
+static char * joint_tracking_allocator_name(const char * prefix, const char * site) {
+    size_t length = strlen(prefix) + strlen(site) + 1;
+    char * name = malloc(sizeof(char) * length);
+    assert(name);
+    snprintf(name, length, "%s%s", prefix, site);
+    return name;
+}
+
+void joint_allocator_tracking_add_stats(joint_allocator_t * allocator, joint_stats_t * stats) {
+    joint_tracking_allocator_t * tracking = (joint_tracking_allocator_t *) allocator;
+
+    pthread_mutex_lock(&tracking->mutex);
+
+    joint_stats_add(stats, "peak allocated bytes", tracking->peak_bytes);
+
+    joint_tracking_allocator_site_t ** sites = malloc(sizeof(joint_tracking_allocator_site_t *) * (tracking->sites_length + 1));
+    assert(sites);
+
+    size_t sites_length = 0;
+
+    for (size_t i = 0; i < tracking->sites_capacity; i++) {
+        if (tracking->sites[i].site != NULL) {
+            sites[sites_length++] = &tracking->sites[i];
+        }
+    }
+
+    qsort(sites, sites_length, sizeof(joint_tracking_allocator_site_t *), joint_tracking_allocator_compare_sites);
+
+    for (size_t i = 0; i < sites_length; i++) {
+        if (sites[i]->calls_name == NULL) {
+            sites[i]->calls_name = joint_tracking_allocator_name("allocations at ", sites[i]->site);
+            sites[i]->bytes_name = joint_tracking_allocator_name("bytes allocated at ", sites[i]->site);
+        }
+
+        joint_stats_add(stats, sites[i]->calls_name, sites[i]->calls);
+        joint_stats_add(stats, sites[i]->bytes_name, sites[i]->bytes);
+    }
+
+    free(sites);
+
+    pthread_mutex_unlock(&tracking->mutex);
+}
+
+bool joint_allocator_parse(const char * name, joint_allocator_t ** allocator) {
+    if (strcmp(name, "system") == 0) {
+        *allocator = joint_allocator_system();
+    } else if (strcmp(name, "arena") == 0) {
+        *allocator = joint_allocator_arena_alloc(1024 * 1024);
+    } else if (strcmp(name, "pool") == 0) {
+        *allocator = joint_allocator_pool_alloc();
+    } else {
+        return false;
+    }
+
+    return true;
+}
+
+joint_allocator_t * joint_allocator_fork(joint_allocator_t * allocator) {
+    if (allocator->allocate == joint_arena_allocator_allocate) {
+        return joint_allocator_arena_alloc(((joint_arena_allocator_t *) allocator)->block_size);
+    }
+
+    if (allocator->allocate == joint_pool_allocator_allocate) {
+        return joint_allocator_pool_alloc();
+    }
+
+    return allocator;
+}
+
+void joint_allocator_merge(joint_allocator_t * allocator, joint_allocator_t * forked) {
+    if (forked == allocator) {
+        return;
+    }
+
+    if (forked->allocate == joint_arena_allocator_allocate) {
+        joint_arena_allocator_merge((joint_arena_allocator_t *) allocator, (joint_arena_allocator_t *) forked);
+    } else {
+        joint_pool_allocator_merge((joint_pool_allocator_t *) allocator, (joint_pool_allocator_t *) forked);
+    }
+}
+
+void joint_allocator_free(joint_allocator_t * allocator) {
+    allocator->destroy(allocator);
+}
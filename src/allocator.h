@@ -0,0 +1,78 @@
+/* Copyright (c) 2014 Vyacheslav Slinko
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef joint_allocator_h
+#define joint_allocator_h
+
+#include <stddef.h>
+#include "stats.h"
+
+/* Memory strategy of the source file, string, tokenizer and parser objects.
+ * site names the file and line the request comes from, only the tracking
+ * allocator looks at it. Every bundled allocator is safe to share between
+ * threads. */
+typedef struct joint_allocator {
+    void * (* allocate)(struct joint_allocator * allocator, size_t size, const char * site);
+    void * (* reallocate)(struct joint_allocator * allocator, void * pointer, size_t size, const char * site);
+    void (* deallocate)(struct joint_allocator * allocator, void * pointer);
+    void (* destroy)(struct joint_allocator * allocator);
+} joint_allocator_t;
+
+#define JOINT_ALLOCATOR_STRINGIFY(value) #value
+#define JOINT_ALLOCATOR_LINE(line) JOINT_ALLOCATOR_STRINGIFY(line)
+#define JOINT_ALLOCATOR_SITE __FILE__ ":" JOINT_ALLOCATOR_LINE(__LINE__)
+
+#define JOINT_ALLOCATE(allocator, size) ((allocator)->allocate((allocator), (size), JOINT_ALLOCATOR_SITE))
+#define JOINT_REALLOCATE(allocator, pointer, size) ((allocator)->reallocate((allocator), (pointer), (size), JOINT_ALLOCATOR_SITE))
+#define JOINT_DEALLOCATE(allocator, pointer) ((allocator)->deallocate((allocator), (pointer)))
+
+/* Plain malloc, realloc and free. The returned allocator is shared and
+ * joint_allocator_free does nothing to it. */
+joint_allocator_t * joint_allocator_system(void);
+
+/* Bump allocator carving blocks of block_size bytes. Deallocation only
+ * reclaims the latest allocation, everything else is released at once by
+ * joint_allocator_free. */
+joint_allocator_t * joint_allocator_arena_alloc(size_t block_size);
+
+/* Free lists of power of two size classes from 16 to 4096 bytes, larger
+ * requests go to malloc. */
+joint_allocator_t * joint_allocator_pool_alloc(void);
+
+/* Forwards to parent and counts calls and bytes requested per call site. */
+joint_allocator_t * joint_allocator_tracking_alloc(joint_allocator_t * parent);
+
+void joint_allocator_tracking_add_stats(joint_allocator_t * allocator, joint_stats_t * stats);
+
+bool joint_allocator_parse(const char * name, joint_allocator_t ** allocator);
+
+/* An empty allocator of the same kind as allocator for the use of one
+ * thread, or allocator itself when it has no memory of its own to hand
+ * over. */
+joint_allocator_t * joint_allocator_fork(joint_allocator_t * allocator);
+
+/* Hands the memory of forked over to allocator and frees forked. What was
+ * allocated from forked is released through allocator from then on. */
+void joint_allocator_merge(joint_allocator_t * allocator, joint_allocator_t * forked);
+
+void joint_allocator_free(joint_allocator_t * allocator);
+
+#endif
@@ -0,0 +1,121 @@
+/* Copyright (c) 2014 Vyacheslav Slinko
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "builtins.h"
+
+#define JOINT_BUILTINS_OUTPUT_CAPACITY (1 << 16)
+
+/* Standard output of the io module, one buffer per thread so printing
+ * never takes a lock. */
+typedef struct joint_builtins_output {
+    joint_writer_t * writer;
+    bool terminal;
+} joint_builtins_output_t;
+
+static pthread_key_t joint_builtins_output_key;
+static pthread_once_t joint_builtins_output_once = PTHREAD_ONCE_INIT;
+
+static void joint_builtins_output_free(void * data) {
+    joint_builtins_output_t * output = data;
+
+    joint_writer_free(output->writer);
+    free(output);
+}
+
+/* Thread-specific destructors do not run on exit, the exiting thread flushes
+ * its own buffer here. */
+static void joint_builtins_output_exit(void) {
+    joint_builtins_flush();
+}
+
+static void joint_builtins_output_init(void) {
+    int created = pthread_key_create(&joint_builtins_output_key, joint_builtins_output_free);
+    assert(created == 0);
+    atexit(joint_builtins_output_exit);
+}
+
+static joint_builtins_output_t * joint_builtins_output(void) {
+    pthread_once(&joint_builtins_output_once, joint_builtins_output_init);
+
+    joint_builtins_output_t * output = pthread_getspecific(joint_builtins_output_key);
+
+    if (output == NULL) {
+        output = malloc(sizeof(joint_builtins_output_t));
+        assert(output);
+
+        output->writer = joint_writer_alloc(STDOUT_FILENO, JOINT_BUILTINS_OUTPUT_CAPACITY);
+        output->terminal = isatty(STDOUT_FILENO);
+        pthread_setspecific(joint_builtins_output_key, output);
+    }
+
+    return output;
+}
+
+static joint_value_t joint_builtins_print_line(const joint_value_t * arguments) {
+    joint_builtins_output_t * output = joint_builtins_output();
+
+    joint_value_write(output->writer, arguments[0]);
+    joint_writer_write_character(output->writer, '\n');
+
+    /* Lines show up as they are printed only when someone is watching. */
+    if (output->terminal) {
+        joint_writer_flush(output->writer);
+    }
+
+    return JOINT_VALUE_NULL;
+}
+
+static const joint_builtin_t joint_builtins[] = {
+    {"io", "printLine", 1, joint_builtins_print_line}
+};
+
+const joint_builtin_t * joint_builtins_find(const char * module, const char * name) {
+    for (size_t i = 0; i < sizeof(joint_builtins) / sizeof(joint_builtins[0]); i++) {
+        if (strcmp(joint_builtins[i].module, module) == 0 && strcmp(joint_builtins[i].name, name) == 0) {
+            return &joint_builtins[i];
+        }
+    }
+
+    return NULL;
+}
+
+bool joint_builtins_has_module(const char * module) {
+    for (size_t i = 0; i < sizeof(joint_builtins) / sizeof(joint_builtins[0]); i++) {
+        if (strcmp(joint_builtins[i].module, module) == 0) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool joint_builtins_flush(void) {
+    pthread_once(&joint_builtins_output_once, joint_builtins_output_init);
+
+    joint_builtins_output_t * output = pthread_getspecific(joint_builtins_output_key);
+
+    return output == NULL || joint_writer_flush(output->writer);
+}
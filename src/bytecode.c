@@ -0,0 +1,511 @@
+/* Copyright (c) 2014 Vyacheslav Slinko
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "builtins.h"
+#include "bytecode.h"
+#include "module.h"
+
+typedef struct joint_bytecode_binding {
+    const joint_intern_string_t * name;
+    uint32_t register_index;
+} joint_bytecode_binding_t;
+
+/* A call chain being compiled: the callee was loaded into base, and calls
+ * are compiled from the innermost one, argument by argument. */
+typedef struct joint_bytecode_call_frame {
+    const joint_node_t ** calls;
+    int calls_length;
+    int next_call;
+    int next_children;
+    uint32_t arguments_length;
+    uint32_t base;
+    uint32_t target;
+    uint32_t saved_register;
+} joint_bytecode_call_frame_t;
+
+typedef struct joint_bytecode_compiler {
+    joint_bytecode_t * bytecode;
+    int instructions_capacity;
+    bool pooled;
+
+    int bindings_length;
+    int bindings_capacity;
+    joint_bytecode_binding_t * bindings;
+
+    /* Nested calls are compiled with an explicit stack rather than native
+     * recursion, so deeply nested arguments cannot overflow the C stack. */
+    int frames_length;
+    int frames_capacity;
+    joint_bytecode_call_frame_t * frames;
+
+    /* Imported modules run before the program, in the order they were
+     * loaded. The top-level bindings of each stay in their own table. */
+    int modules_length;
+    joint_module_t ** modules;
+    int compiled_length;
+    int * compiled_capacities;
+    joint_bytecode_binding_t ** compiled;
+
+    uint32_t next_register;
+    bool failed;
+} joint_bytecode_compiler_t;
+
+static void joint_bytecode_error(joint_bytecode_compiler_t * compiler, const joint_node_t * node, const char * message, const char * subject) {
+    fprintf(stderr, "%s:%zu:%zu: %s \"%s\"\n", node->start_position->path, node->start_position->line + 1, node->start_position->code_point_column + 1, message, subject);
+    compiler->failed = true;
+}
+
+static const joint_node_children_t * joint_bytecode_children(const joint_node_t * node, const char * name) {
+    for (int i = 0; i < node->childrens_length; i++) {
+        if (strcmp(node->childrens[i]->name, name) == 0) {
+            return node->childrens[i];
+        }
+    }
+
+    return NULL;
+}
+
+static void joint_bytecode_emit(joint_bytecode_compiler_t * compiler, enum joint_opcode opcode, uint32_t a, uint32_t b) {
+    joint_bytecode_t * bytecode = compiler->bytecode;
+
+    if (bytecode->instructions_length == compiler->instructions_capacity) {
+        compiler->instructions_capacity *= 2;
+        bytecode->instructions = realloc(bytecode->instructions, sizeof(joint_instruction_t) * compiler->instructions_capacity);
+        assert(bytecode->instructions);
+    }
+
+    joint_instruction_t * instruction = &bytecode->instructions[bytecode->instructions_length++];
+    instruction->opcode = opcode;
+    instruction->a = a;
+    instruction->b = b;
+}
+
+static uint32_t joint_bytecode_add_constant(joint_bytecode_compiler_t * compiler, joint_value_t value) {
+    return (uint32_t) joint_constants_add(compiler->bytecode->constants, value);
+}
+
+static uint32_t joint_bytecode_reserve_register(joint_bytecode_compiler_t * compiler) {
+    uint32_t register_index = compiler->next_register++;
+    assert(compiler->next_register < (1 << 24));
+
+    if ((int) compiler->next_register > compiler->bytecode->registers_length) {
+        compiler->bytecode->registers_length = (int) compiler->next_register;
+    }
+
+    return register_index;
+}
+
+static void joint_bytecode_bind(joint_bytecode_compiler_t * compiler, const char * name, uint32_t register_index) {
+    if ((compiler->bindings_length + 1) * 2 > compiler->bindings_capacity) {
+        joint_bytecode_binding_t * bindings = compiler->bindings;
+        int capacity = compiler->bindings_capacity;
+
+        compiler->bindings_capacity *= 2;
+        compiler->bindings = calloc(compiler->bindings_capacity, sizeof(joint_bytecode_binding_t));
+        assert(compiler->bindings);
+        compiler->bindings_length = 0;
+
+        for (int i = 0; i < capacity; i++) {
+            if (bindings[i].name != NULL) {
+                joint_bytecode_bind(compiler, bindings[i].name->characters, bindings[i].register_index);
+            }
+        }
+
+        free(bindings);
+    }
+
+    const joint_intern_string_t * interned = joint_intern_cstring(name);
+    int slot = (int) (interned->hash & (uint64_t) (compiler->bindings_capacity - 1));
+
+    while (compiler->bindings[slot].name != NULL && compiler->bindings[slot].name != interned) {
+        slot = (slot + 1) & (compiler->bindings_capacity - 1);
+    }
+
+    if (compiler->bindings[slot].name == NULL) {
+        compiler->bindings_length++;
+    }
+
+    compiler->bindings[slot].name = interned;
+    compiler->bindings[slot].register_index = register_index;
+}
+
+static bool joint_bytecode_find(const joint_bytecode_binding_t * bindings, int bindings_capacity, const char * name, uint32_t * register_index) {
+    const joint_intern_string_t * interned = joint_intern_cstring(name);
+    int slot = (int) (interned->hash & (uint64_t) (bindings_capacity - 1));
+
+    while (bindings[slot].name != NULL) {
+        if (bindings[slot].name == interned) {
+            *register_index = bindings[slot].register_index;
+            return true;
+        }
+
+        slot = (slot + 1) & (bindings_capacity - 1);
+    }
+
+    return false;
+}
+
+static bool joint_bytecode_lookup(const joint_bytecode_compiler_t * compiler, const char * name, uint32_t * register_index) {
+    return joint_bytecode_find(compiler->bindings, compiler->bindings_capacity, name, register_index);
+}
+
+static void joint_bytecode_compile_literal(joint_bytecode_compiler_t * compiler, const joint_node_t * literal, uint32_t target) {
+    const joint_node_children_t * value = literal->childrens[0];
+    joint_value_t constant;
+
+    if (compiler->pooled && value->constant >= 0) {
+        joint_bytecode_emit(compiler, LOAD_CONSTANT_OPCODE, target, (uint32_t) value->constant);
+        return;
+    }
+
+    switch (value->type) {
+        case NUMBER_CHILDREN:
+            constant = joint_value_number((double) value->number);
+            break;
+
+        case BOOLEAN_CHILDREN:
+            constant = joint_value_boolean(value->boolean);
+            break;
+
+        case CHARACTER_CHILDREN:
+            constant = joint_value_character(value->character);
+            break;
+
+        case STRING_CHILDREN:
+            constant = joint_value_string(joint_intern_cstring(value->string));
+            break;
+
+        default:
+            constant = JOINT_VALUE_NULL;
+            break;
+    }
+
+    joint_bytecode_emit(compiler, LOAD_CONSTANT_OPCODE, target, joint_bytecode_add_constant(compiler, constant));
+}
+
+static void joint_bytecode_compile_operand(joint_bytecode_compiler_t * compiler, const joint_node_t * expression, uint32_t target) {
+    uint32_t source;
+
+    switch (expression->type) {
+        case LITERAL_NODE:
+            joint_bytecode_compile_literal(compiler, expression, target);
+            break;
+
+        case IDENTIFIER_NODE:
+            if (!joint_bytecode_lookup(compiler, expression->childrens[0]->string, &source)) {
+                joint_bytecode_error(compiler, expression, "Undefined identifier", expression->childrens[0]->string);
+            } else if (source != target) {
+                joint_bytecode_emit(compiler, MOVE_OPCODE, target, source);
+            }
+            break;
+
+        default:
+            joint_bytecode_error(compiler, expression, "Unsupported expression", joint_node_type_name(expression->type));
+            break;
+    }
+}
+
+static void joint_bytecode_push_call(joint_bytecode_compiler_t * compiler, const joint_node_t * expression, uint32_t target) {
+    if (compiler->frames_length == compiler->frames_capacity) {
+        compiler->frames_capacity *= 2;
+        compiler->frames = realloc(compiler->frames, sizeof(joint_bytecode_call_frame_t) * compiler->frames_capacity);
+        assert(compiler->frames);
+    }
+
+    joint_bytecode_call_frame_t * frame = &compiler->frames[compiler->frames_length++];
+    const joint_node_t * callee = expression;
+
+    frame->calls_length = 0;
+
+    while (callee->type == CALL_EXPRESSION_NODE) {
+        frame->calls_length++;
+        callee = joint_bytecode_children(callee, "callee")->node;
+    }
+
+    frame->calls = malloc(sizeof(joint_node_t *) * frame->calls_length);
+    assert(frame->calls);
+
+    callee = expression;
+
+    for (int i = frame->calls_length - 1; i >= 0; i--) {
+        frame->calls[i] = callee;
+        callee = joint_bytecode_children(callee, "callee")->node;
+    }
+
+    frame->next_call = 0;
+    frame->next_children = 0;
+    frame->arguments_length = 0;
+    frame->target = target;
+    frame->saved_register = compiler->next_register;
+    frame->base = joint_bytecode_reserve_register(compiler);
+
+    joint_bytecode_compile_operand(compiler, callee, frame->base);
+}
+
+static void joint_bytecode_compile_expression(joint_bytecode_compiler_t * compiler, const joint_node_t * expression, uint32_t target) {
+    if (expression->type != CALL_EXPRESSION_NODE) {
+        joint_bytecode_compile_operand(compiler, expression, target);
+        return;
+    }
+
+    joint_bytecode_push_call(compiler, expression, target);
+
+    while (compiler->frames_length > 0) {
+        joint_bytecode_call_frame_t * frame = &compiler->frames[compiler->frames_length - 1];
+
+        if (frame->next_call == frame->calls_length) {
+            if (frame->base != frame->target) {
+                joint_bytecode_emit(compiler, MOVE_OPCODE, frame->target, frame->base);
+            }
+
+            compiler->next_register = frame->saved_register;
+            free(frame->calls);
+            compiler->frames_length--;
+            continue;
+        }
+
+        const joint_node_t * call = frame->calls[frame->next_call];
+
+        while (frame->next_children < call->childrens_length && strcmp(call->childrens[frame->next_children]->name, "argument") != 0) {
+            frame->next_children++;
+        }
+
+        if (frame->next_children == call->childrens_length) {
+            joint_bytecode_emit(compiler, CALL_OPCODE, frame->base, frame->arguments_length);
+            compiler->next_register = frame->base + 1;
+            frame->next_call++;
+            frame->next_children = 0;
+            frame->arguments_length = 0;
+            continue;
+        }
+
+        const joint_node_t * argument = call->childrens[frame->next_children++]->node;
+        uint32_t argument_register = joint_bytecode_reserve_register(compiler);
+        frame->arguments_length++;
+
+        if (argument->type == CALL_EXPRESSION_NODE) {
+            joint_bytecode_push_call(compiler, argument, argument_register);
+        } else {
+            joint_bytecode_compile_operand(compiler, argument, argument_register);
+        }
+    }
+}
+
+/* The bindings of an imported module share the registers it set up. */
+static void joint_bytecode_compile_module_import(joint_bytecode_compiler_t * compiler, const joint_node_t * import_declaration, const joint_node_t * source) {
+    const char * module = source->childrens[0]->string;
+    char * path = joint_module_resolve_import(source->start_position->path, module);
+    int index = -1;
+
+    for (int i = 0; path != NULL && i < compiler->compiled_length; i++) {
+        if (strcmp(compiler->modules[i]->path, path) == 0) {
+            index = i;
+        }
+    }
+
+    free(path);
+
+    if (index < 0) {
+        joint_bytecode_error(compiler, source, "Unknown module", module);
+        return;
+    }
+
+    for (int i = 0; i < import_declaration->childrens_length; i++) {
+        if (strcmp(import_declaration->childrens[i]->name, "specifier") != 0) {
+            continue;
+        }
+
+        const joint_node_t * specifier = import_declaration->childrens[i]->node;
+        const char * name = specifier->childrens[0]->string;
+        uint32_t register_index;
+
+        if (!joint_bytecode_find(compiler->compiled[index], compiler->compiled_capacities[index], name, &register_index)) {
+            joint_bytecode_error(compiler, specifier, "Unknown import", name);
+            continue;
+        }
+
+        joint_bytecode_bind(compiler, name, register_index);
+    }
+}
+
+static void joint_bytecode_compile_import(joint_bytecode_compiler_t * compiler, const joint_node_t * import_declaration) {
+    const joint_node_t * source = joint_bytecode_children(import_declaration, "source")->node;
+    const char * module = source->childrens[0]->string;
+
+    if (!joint_builtins_has_module(module)) {
+        joint_bytecode_compile_module_import(compiler, import_declaration, source);
+        return;
+    }
+
+    for (int i = 0; i < import_declaration->childrens_length; i++) {
+        if (strcmp(import_declaration->childrens[i]->name, "specifier") != 0) {
+            continue;
+        }
+
+        const joint_node_t * specifier = import_declaration->childrens[i]->node;
+        const char * name = specifier->childrens[0]->string;
+        const joint_builtin_t * builtin = joint_builtins_find(module, name);
+
+        if (builtin == NULL) {
+            joint_bytecode_error(compiler, specifier, "Unknown import", name);
+            continue;
+        }
+
+        uint32_t register_index = joint_bytecode_reserve_register(compiler);
+        uint32_t constant = joint_bytecode_add_constant(compiler, joint_value_function(builtin));
+        joint_bytecode_emit(compiler, LOAD_CONSTANT_OPCODE, register_index, constant);
+        joint_bytecode_bind(compiler, name, register_index);
+    }
+}
+
+static void joint_bytecode_compile_variable_declaration(joint_bytecode_compiler_t * compiler, const joint_node_t * variable_declaration) {
+    const joint_node_t * id = joint_bytecode_children(variable_declaration, "id")->node;
+    const joint_node_t * init = joint_bytecode_children(variable_declaration, "init")->node;
+    uint32_t register_index = joint_bytecode_reserve_register(compiler);
+
+    joint_bytecode_compile_expression(compiler, init, register_index);
+    joint_bytecode_bind(compiler, id->childrens[0]->string, register_index);
+}
+
+static void joint_bytecode_compile_elements(joint_bytecode_compiler_t * compiler, const joint_node_t * program) {
+    for (int i = 0; i < program->childrens_length; i++) {
+        const joint_node_t * element = program->childrens[i]->node;
+        uint32_t saved_register;
+
+        switch (element->type) {
+            case COMMENT_NODE:
+                break;
+
+            case IMPORT_DECLARATION_NODE:
+                joint_bytecode_compile_import(compiler, element);
+                break;
+
+            case VARIABLE_DECLARATION_NODE:
+                joint_bytecode_compile_variable_declaration(compiler, element);
+                break;
+
+            default:
+                saved_register = compiler->next_register;
+                joint_bytecode_compile_expression(compiler, element, joint_bytecode_reserve_register(compiler));
+                compiler->next_register = saved_register;
+                break;
+        }
+    }
+}
+
+/* Literals of imported modules were pooled by parsers of their own, so
+ * they are added to the constants one by one. */
+static void joint_bytecode_compile_module(joint_bytecode_compiler_t * compiler, const joint_module_t * module) {
+    joint_bytecode_binding_t * bindings = compiler->bindings;
+    int bindings_length = compiler->bindings_length;
+    int bindings_capacity = compiler->bindings_capacity;
+    bool pooled = compiler->pooled;
+
+    compiler->bindings_length = 0;
+    compiler->bindings_capacity = 64;
+    compiler->bindings = calloc(compiler->bindings_capacity, sizeof(joint_bytecode_binding_t));
+    assert(compiler->bindings);
+    compiler->pooled = false;
+
+    joint_bytecode_compile_elements(compiler, module->program);
+
+    compiler->compiled[compiler->compiled_length] = compiler->bindings;
+    compiler->compiled_capacities[compiler->compiled_length++] = compiler->bindings_capacity;
+
+    compiler->bindings = bindings;
+    compiler->bindings_length = bindings_length;
+    compiler->bindings_capacity = bindings_capacity;
+    compiler->pooled = pooled;
+}
+
+joint_bytecode_t * joint_bytecode_compile(const joint_node_t * program, const joint_constants_t * constants) {
+    joint_bytecode_t * bytecode = malloc(sizeof(joint_bytecode_t));
+    assert(bytecode);
+
+    bytecode->instructions_length = 0;
+    bytecode->instructions = malloc(sizeof(joint_instruction_t) * 64);
+    assert(bytecode->instructions);
+    bytecode->constants = constants != NULL ? joint_constants_clone(constants) : joint_constants_alloc();
+    bytecode->registers_length = 0;
+
+    joint_bytecode_compiler_t compiler = {
+        .bytecode = bytecode,
+        .instructions_capacity = 64,
+        .pooled = constants != NULL,
+        .bindings_length = 0,
+        .bindings_capacity = 64,
+        .frames_length = 0,
+        .frames_capacity = 16,
+        .modules_length = 0,
+        .modules = NULL,
+        .compiled_length = 0,
+        .next_register = 0,
+        .failed = false
+    };
+
+    compiler.bindings = calloc(compiler.bindings_capacity, sizeof(joint_bytecode_binding_t));
+    assert(compiler.bindings);
+
+    compiler.frames = malloc(sizeof(joint_bytecode_call_frame_t) * compiler.frames_capacity);
+    assert(compiler.frames);
+
+    compiler.failed = !joint_module_load_imports(program, &compiler.modules, &compiler.modules_length);
+    compiler.compiled = malloc(sizeof(joint_bytecode_binding_t *) * (compiler.modules_length + 1));
+    compiler.compiled_capacities = malloc(sizeof(int) * (compiler.modules_length + 1));
+    assert(compiler.compiled && compiler.compiled_capacities);
+
+    if (!compiler.failed) {
+        for (int i = 0; i < compiler.modules_length; i++) {
+            joint_bytecode_compile_module(&compiler, compiler.modules[i]);
+        }
+
+        joint_bytecode_compile_elements(&compiler, program);
+    }
+
+    joint_bytecode_emit(&compiler, HALT_OPCODE, 0, 0);
+    free(compiler.bindings);
+    free(compiler.frames);
+
+    for (int i = 0; i < compiler.compiled_length; i++) {
+        free(compiler.compiled[i]);
+    }
+
+    free(compiler.compiled);
+    free(compiler.compiled_capacities);
+    joint_module_free_all(compiler.modules, compiler.modules_length);
+
+    if (compiler.failed) {
+        joint_bytecode_free(bytecode);
+        return NULL;
+    }
+
+    return bytecode;
+}
+
+void joint_bytecode_free(joint_bytecode_t * bytecode) {
+    joint_constants_free(bytecode->constants);
+    free(bytecode->instructions);
+    free(bytecode);
+}
@@ -0,0 +1,65 @@
+/* Copyright (c) 2014 Vyacheslav Slinko
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef joint_bytecode_h
+#define joint_bytecode_h
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "constants.h"
+#include "node.h"
+#include "value.h"
+
+enum joint_opcode {
+    LOAD_CONSTANT_OPCODE,
+    MOVE_OPCODE,
+    CALL_OPCODE,
+    HALT_OPCODE
+};
+
+/* LOAD_CONSTANT: R[a] = K[b]
+ * MOVE: R[a] = R[b]
+ * CALL: R[a] = R[a](R[a + 1], ..., R[a + b])
+ * HALT: stop execution */
+typedef struct joint_instruction {
+    uint32_t opcode : 8;
+    uint32_t a : 24;
+    uint32_t b;
+} joint_instruction_t;
+
+typedef struct joint_bytecode {
+    int instructions_length;
+    joint_instruction_t * instructions;
+
+    /* Starts as a copy of the constant pool of the program, so literals
+     * load their pool index as is. */
+    joint_constants_t * constants;
+
+    int registers_length;
+} joint_bytecode_t;
+
+/* constants is the pool the program was parsed with, or NULL when its
+ * literals are not pooled, as for programs loaded from a dump. */
+joint_bytecode_t * joint_bytecode_compile(const joint_node_t * program, const joint_constants_t * constants);
+
+void joint_bytecode_free(joint_bytecode_t * bytecode);
+
+#endif
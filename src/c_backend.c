@@ -0,0 +1,703 @@
+/* Copyright (c) 2014 Vyacheslav Slinko
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <assert.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "builtins.h"
+#include "c_backend.h"
+#include "intern.h"
+#include "module.h"
+
+/* Variables of imported modules are named after the index of their module,
+ * module is -1 for those of the program. */
+typedef struct joint_c_backend_binding {
+    const joint_intern_string_t * name;
+    const joint_builtin_t * builtin;
+    int module;
+} joint_c_backend_binding_t;
+
+/* A call whose nested calls are being hoisted. Its callee is visited first,
+ * then the arguments, and its own temporary goes to slot of the call below. */
+typedef struct joint_c_backend_frame {
+    const joint_node_t * call;
+    int * temporaries;
+    int next_children;
+    int next_temporary;
+    int slot;
+} joint_c_backend_frame_t;
+
+typedef struct joint_c_backend {
+    /* NULL during the first pass, which only reports errors. */
+    joint_writer_t * writer;
+    bool failed;
+    int temporaries_length;
+
+    int bindings_length;
+    int bindings_capacity;
+    joint_c_backend_binding_t * bindings;
+
+    /* Variables that already have a C declaration. */
+    int declared_length;
+    int declared_capacity;
+    const joint_intern_string_t ** declared;
+
+    int frames_length;
+    int frames_capacity;
+    joint_c_backend_frame_t * frames;
+
+    /* Imported modules are written before the program in the order they
+     * were loaded, module is the one being written. */
+    int modules_length;
+    joint_module_t ** modules;
+    int module;
+    int compiled_length;
+    int * compiled_capacities;
+    joint_c_backend_binding_t ** compiled;
+} joint_c_backend_t;
+
+static const char * joint_c_backend_reserved[] = {
+    "auto", "bool", "break", "case", "char", "const", "continue", "default", "do", "double", "else", "enum",
+    "extern", "false", "float", "for", "goto", "if", "inline", "int", "long", "main", "register", "restrict",
+    "return", "short", "signed", "sizeof", "static", "struct", "switch", "true", "typedef", "union",
+    "unsigned", "void", "volatile", "while", "_Bool", "_Complex", "_Imaginary", "NULL", "EOF", "errno",
+    "stdin", "stdout", "stderr", "exit", "printf", "putchar", "fputs", "fflush", "fprintf", "HUGE_VAL",
+    "snprintf", "memcpy", "strlen", "write", "writev", "isatty", "STDOUT_FILENO"
+};
+
+static const joint_node_children_t * joint_c_backend_children(const joint_node_t * node, const char * name) {
+    for (int i = 0; i < node->childrens_length; i++) {
+        if (strcmp(node->childrens[i]->name, name) == 0) {
+            return node->childrens[i];
+        }
+    }
+
+    return NULL;
+}
+
+static void joint_c_backend_error(joint_c_backend_t * backend, const joint_node_t * node, const char * message, const char * subject) {
+    fprintf(stderr, "%s:%zu:%zu: %s \"%s\"\n", node->start_position->path, node->start_position->line + 1, node->start_position->column + 1, message, subject);
+    backend->failed = true;
+}
+
+static void joint_c_backend_write(joint_c_backend_t * backend, const char * string) {
+    if (backend->writer != NULL) {
+        joint_writer_write_string(backend->writer, string);
+    }
+}
+
+static void joint_c_backend_write_integer(joint_c_backend_t * backend, int64_t value) {
+    if (backend->writer != NULL) {
+        joint_writer_write_integer(backend->writer, value);
+    }
+}
+
+static void joint_c_backend_write_name(joint_c_backend_t * backend, const char * name) {
+    joint_c_backend_write(backend, name);
+
+    if (strncmp(name, "joint_", 6) == 0) {
+        joint_c_backend_write(backend, "_");
+        return;
+    }
+
+    for (size_t i = 0; i < sizeof(joint_c_backend_reserved) / sizeof(joint_c_backend_reserved[0]); i++) {
+        if (strcmp(name, joint_c_backend_reserved[i]) == 0) {
+            joint_c_backend_write(backend, "_");
+            return;
+        }
+    }
+}
+
+static void joint_c_backend_write_quoted(joint_c_backend_t * backend, const char * characters, size_t length, char quote) {
+    char escape[5];
+
+    joint_c_backend_write(backend, (char []) {quote, '\0'});
+
+    for (size_t i = 0; i < length; i++) {
+        unsigned char character = (unsigned char) characters[i];
+
+        if (character == '\\' || character == (unsigned char) quote) {
+            snprintf(escape, sizeof(escape), "\\%c", character);
+        } else if (character == '\n') {
+            snprintf(escape, sizeof(escape), "\\n");
+        } else if (character == '\t') {
+            snprintf(escape, sizeof(escape), "\\t");
+        } else if (character < 0x20 || character == 0x7F || (character == '?' && i > 0 && characters[i - 1] == '?')) {
+            /* Octal escapes never run into the next character, escaping the
+             * second '?' rules out trigraphs. */
+            snprintf(escape, sizeof(escape), "\\%03o", character);
+        } else {
+            snprintf(escape, sizeof(escape), "%c", character);
+        }
+
+        joint_c_backend_write(backend, escape);
+    }
+
+    joint_c_backend_write(backend, (char []) {quote, '\0'});
+}
+
+static void joint_c_backend_indent(joint_c_backend_t * backend) {
+    joint_c_backend_write(backend, "    ");
+}
+
+static void joint_c_backend_bind(joint_c_backend_t * backend, const char * name, const joint_builtin_t * builtin, int module) {
+    if ((backend->bindings_length + 1) * 2 > backend->bindings_capacity) {
+        joint_c_backend_binding_t * bindings = backend->bindings;
+        int capacity = backend->bindings_capacity;
+
+        backend->bindings_capacity *= 2;
+        backend->bindings = calloc(backend->bindings_capacity, sizeof(joint_c_backend_binding_t));
+        assert(backend->bindings);
+        backend->bindings_length = 0;
+
+        for (int i = 0; i < capacity; i++) {
+            if (bindings[i].name != NULL) {
+                joint_c_backend_bind(backend, bindings[i].name->characters, bindings[i].builtin, bindings[i].module);
+            }
+        }
+
+        free(bindings);
+    }
+
+    const joint_intern_string_t * interned = joint_intern_cstring(name);
+    int slot = (int) (interned->hash & (uint64_t) (backend->bindings_capacity - 1));
+
+    while (backend->bindings[slot].name != NULL && backend->bindings[slot].name != interned) {
+        slot = (slot + 1) & (backend->bindings_capacity - 1);
+    }
+
+    if (backend->bindings[slot].name == NULL) {
+        backend->bindings_length++;
+    }
+
+    backend->bindings[slot].name = interned;
+    backend->bindings[slot].builtin = builtin;
+    backend->bindings[slot].module = module;
+}
+
+static const joint_c_backend_binding_t * joint_c_backend_find(const joint_c_backend_binding_t * bindings, int bindings_capacity, const char * name) {
+    const joint_intern_string_t * interned = joint_intern_cstring(name);
+    int slot = (int) (interned->hash & (uint64_t) (bindings_capacity - 1));
+
+    while (bindings[slot].name != NULL) {
+        if (bindings[slot].name == interned) {
+            return &bindings[slot];
+        }
+
+        slot = (slot + 1) & (bindings_capacity - 1);
+    }
+
+    return NULL;
+}
+
+static const joint_c_backend_binding_t * joint_c_backend_lookup(const joint_c_backend_t * backend, const char * name) {
+    return joint_c_backend_find(backend->bindings, backend->bindings_capacity, name);
+}
+
+static void joint_c_backend_write_variable(joint_c_backend_t * backend, int module, const char * name) {
+    if (module < 0) {
+        joint_c_backend_write_name(backend, name);
+        return;
+    }
+
+    joint_c_backend_write(backend, "joint_m");
+    joint_c_backend_write_integer(backend, module);
+    joint_c_backend_write(backend, "_");
+    joint_c_backend_write(backend, name);
+}
+
+/* Returns true when the variable was declared before and marks it declared. */
+static bool joint_c_backend_declare(joint_c_backend_t * backend, const char * name) {
+    if ((backend->declared_length + 1) * 2 > backend->declared_capacity) {
+        const joint_intern_string_t ** declared = backend->declared;
+        int capacity = backend->declared_capacity;
+
+        backend->declared_capacity *= 2;
+        backend->declared = calloc(backend->declared_capacity, sizeof(joint_intern_string_t *));
+        assert(backend->declared);
+        backend->declared_length = 0;
+
+        for (int i = 0; i < capacity; i++) {
+            if (declared[i] != NULL) {
+                joint_c_backend_declare(backend, declared[i]->characters);
+            }
+        }
+
+        free(declared);
+    }
+
+    const joint_intern_string_t * interned = joint_intern_cstring(name);
+    int slot = (int) (interned->hash & (uint64_t) (backend->declared_capacity - 1));
+
+    while (backend->declared[slot] != NULL) {
+        if (backend->declared[slot] == interned) {
+            return true;
+        }
+
+        slot = (slot + 1) & (backend->declared_capacity - 1);
+    }
+
+    backend->declared[slot] = interned;
+    backend->declared_length++;
+
+    return false;
+}
+
+static void joint_c_backend_write_builtin(joint_c_backend_t * backend, const joint_builtin_t * builtin, const char * suffix) {
+    joint_c_backend_write(backend, "joint_");
+    joint_c_backend_write(backend, builtin->module);
+    joint_c_backend_write(backend, "_");
+    joint_c_backend_write(backend, builtin->name);
+    joint_c_backend_write(backend, suffix);
+}
+
+static void joint_c_backend_write_literal(joint_c_backend_t * backend, const joint_node_t * literal) {
+    const joint_node_children_t * value = literal->childrens[0];
+    char number[32];
+
+    switch (value->type) {
+        case NUMBER_CHILDREN:
+            joint_c_backend_write(backend, "joint_number(");
+
+            if (isinf((double) value->number)) {
+                joint_c_backend_write(backend, value->number < 0 ? "-HUGE_VAL" : "HUGE_VAL");
+            } else {
+                snprintf(number, sizeof(number), "%.17g", (double) value->number);
+                joint_c_backend_write(backend, number);
+            }
+
+            joint_c_backend_write(backend, ")");
+            break;
+
+        case BOOLEAN_CHILDREN:
+            joint_c_backend_write(backend, value->boolean ? "joint_boolean(true)" : "joint_boolean(false)");
+            break;
+
+        case CHARACTER_CHILDREN:
+            joint_c_backend_write(backend, "joint_character(");
+            joint_c_backend_write_quoted(backend, &value->character, 1, '\'');
+            joint_c_backend_write(backend, ")");
+            break;
+
+        case STRING_CHILDREN:
+            joint_c_backend_write(backend, "joint_string(");
+            joint_c_backend_write_quoted(backend, value->string, strlen(value->string), '"');
+            joint_c_backend_write(backend, ")");
+            break;
+
+        default:
+            joint_c_backend_write(backend, "joint_null()");
+            break;
+    }
+}
+
+static void joint_c_backend_write_identifier(joint_c_backend_t * backend, const joint_node_t * identifier) {
+    const char * name = identifier->childrens[0]->string;
+    const joint_c_backend_binding_t * binding = joint_c_backend_lookup(backend, name);
+
+    if (binding == NULL) {
+        joint_c_backend_error(backend, identifier, "Undefined identifier", name);
+    } else if (binding->builtin != NULL) {
+        joint_c_backend_write(backend, "joint_function(&");
+        joint_c_backend_write_builtin(backend, binding->builtin, "_builtin)");
+    } else {
+        joint_c_backend_write_variable(backend, binding->module, name);
+    }
+}
+
+static int joint_c_backend_arguments_length(const joint_node_t * call) {
+    int arguments_length = 0;
+
+    for (int i = 0; i < call->childrens_length; i++) {
+        if (strcmp(call->childrens[i]->name, "argument") == 0) {
+            arguments_length++;
+        }
+    }
+
+    return arguments_length;
+}
+
+static void joint_c_backend_write_operand(joint_c_backend_t * backend, const joint_node_t * operand, int temporary) {
+    if (temporary >= 0) {
+        joint_c_backend_write(backend, "joint_t");
+        joint_c_backend_write_integer(backend, temporary);
+    } else if (operand->type == IDENTIFIER_NODE) {
+        joint_c_backend_write_identifier(backend, operand);
+    } else if (operand->type == LITERAL_NODE) {
+        joint_c_backend_write_literal(backend, operand);
+    } else {
+        joint_c_backend_error(backend, operand, "Unsupported expression", joint_node_type_name(operand->type));
+    }
+}
+
+static void joint_c_backend_write_call(joint_c_backend_t * backend, const joint_node_t * call, const int * temporaries) {
+    const joint_node_t * callee = joint_c_backend_children(call, "callee")->node;
+    int arguments_length = joint_c_backend_arguments_length(call);
+    const joint_c_backend_binding_t * binding = NULL;
+
+    if (callee->type == IDENTIFIER_NODE) {
+        binding = joint_c_backend_lookup(backend, callee->childrens[0]->string);
+    }
+
+    bool direct = binding != NULL && binding->builtin != NULL && binding->builtin->arguments_length == arguments_length;
+
+    if (direct) {
+        joint_c_backend_write_builtin(backend, binding->builtin, "(");
+    } else {
+        joint_c_backend_write(backend, "joint_call(");
+        joint_c_backend_write_operand(backend, callee, temporaries[0]);
+        joint_c_backend_write(backend, ", ");
+        joint_c_backend_write_integer(backend, arguments_length);
+        joint_c_backend_write(backend, arguments_length > 0 ? ", (joint_value []) {" : ", NULL");
+    }
+
+    for (int i = 0, j = 1; i < call->childrens_length; i++) {
+        if (strcmp(call->childrens[i]->name, "argument") == 0) {
+            if (j > 1) {
+                joint_c_backend_write(backend, ", ");
+            }
+
+            joint_c_backend_write_operand(backend, call->childrens[i]->node, temporaries[j++]);
+        }
+    }
+
+    joint_c_backend_write(backend, direct || arguments_length == 0 ? ")" : "})");
+}
+
+static int joint_c_backend_write_temporary(joint_c_backend_t * backend, const joint_node_t * call, const int * temporaries) {
+    int temporary = backend->temporaries_length++;
+
+    joint_c_backend_indent(backend);
+    joint_c_backend_write(backend, "joint_value joint_t");
+    joint_c_backend_write_integer(backend, temporary);
+    joint_c_backend_write(backend, " = ");
+    joint_c_backend_write_call(backend, call, temporaries);
+    joint_c_backend_write(backend, ";\n");
+
+    return temporary;
+}
+
+static void joint_c_backend_push_call(joint_c_backend_t * backend, const joint_node_t * call, int slot) {
+    if (backend->frames_length == backend->frames_capacity) {
+        backend->frames_capacity *= 2;
+        backend->frames = realloc(backend->frames, sizeof(joint_c_backend_frame_t) * backend->frames_capacity);
+        assert(backend->frames);
+    }
+
+    joint_c_backend_frame_t * frame = &backend->frames[backend->frames_length++];
+    frame->call = call;
+    frame->temporaries = malloc(sizeof(int) * (joint_c_backend_arguments_length(call) + 1));
+    assert(frame->temporaries);
+    frame->next_children = -1;
+    frame->next_temporary = 1;
+    frame->slot = slot;
+}
+
+/* Nested calls are hoisted into temporaries before the statement using them,
+ * C leaves the evaluation order of arguments unspecified while Joint
+ * evaluates them from left to right. Returns the temporaries of the callee
+ * and the arguments, -1 where the operand is used as is. Calls nest as deep
+ * as the source does, so they are visited with a stack of frames. */
+static int * joint_c_backend_write_temporaries(joint_c_backend_t * backend, const joint_node_t * call) {
+    joint_c_backend_push_call(backend, call, -1);
+
+    while (true) {
+        joint_c_backend_frame_t * frame = &backend->frames[backend->frames_length - 1];
+        const joint_node_t * operand;
+        int slot;
+
+        if (frame->next_children < 0) {
+            operand = joint_c_backend_children(frame->call, "callee")->node;
+            slot = 0;
+            frame->next_children = 0;
+        } else if (frame->next_children < frame->call->childrens_length) {
+            const joint_node_children_t * children = frame->call->childrens[frame->next_children++];
+
+            if (strcmp(children->name, "argument") != 0) {
+                continue;
+            }
+
+            operand = children->node;
+            slot = frame->next_temporary++;
+        } else if (backend->frames_length > 1) {
+            int temporary = joint_c_backend_write_temporary(backend, frame->call, frame->temporaries);
+
+            free(frame->temporaries);
+            backend->frames_length--;
+            backend->frames[backend->frames_length - 1].temporaries[frame->slot] = temporary;
+            continue;
+        } else {
+            backend->frames_length--;
+            return frame->temporaries;
+        }
+
+        if (operand->type == CALL_EXPRESSION_NODE) {
+            joint_c_backend_push_call(backend, operand, slot);
+        } else {
+            frame->temporaries[slot] = -1;
+        }
+    }
+}
+
+/* Writes the statement prefix, then the expression and the terminator. */
+static void joint_c_backend_write_statement(joint_c_backend_t * backend, const char * prefix, const char * name, const joint_node_t * expression) {
+    int * temporaries = NULL;
+
+    if (expression->type == CALL_EXPRESSION_NODE) {
+        temporaries = joint_c_backend_write_temporaries(backend, expression);
+    }
+
+    joint_c_backend_indent(backend);
+    joint_c_backend_write(backend, prefix);
+
+    if (name != NULL) {
+        joint_c_backend_write_variable(backend, backend->module, name);
+        joint_c_backend_write(backend, " = ");
+    }
+
+    if (temporaries != NULL) {
+        joint_c_backend_write_call(backend, expression, temporaries);
+        free(temporaries);
+    } else if (name == NULL) {
+        /* A bare literal or identifier has no effect. */
+        joint_c_backend_write(backend, "(void) ");
+        joint_c_backend_write_operand(backend, expression, -1);
+    } else {
+        joint_c_backend_write_operand(backend, expression, -1);
+    }
+
+    joint_c_backend_write(backend, ";\n");
+}
+
+static void joint_c_backend_write_comment(joint_c_backend_t * backend, const joint_node_t * comment) {
+    const char * text = comment->childrens[0]->string;
+
+    joint_c_backend_indent(backend);
+    joint_c_backend_write(backend, "/*");
+
+    for (const char * end = strstr(text, "*/"); end != NULL; text = end + 1, end = strstr(text, "*/")) {
+        if (backend->writer != NULL) {
+            joint_writer_write(backend->writer, text, end - text);
+        }
+
+        joint_c_backend_write(backend, "* ");
+    }
+
+    joint_c_backend_write(backend, text);
+    joint_c_backend_write(backend, " */\n");
+}
+
+static void joint_c_backend_write_module_import(joint_c_backend_t * backend, const joint_node_t * import_declaration, const joint_node_t * source) {
+    const char * module = source->childrens[0]->string;
+    char * path = joint_module_resolve_import(source->start_position->path, module);
+    int index = -1;
+
+    for (int i = 0; path != NULL && i < backend->compiled_length; i++) {
+        if (strcmp(backend->modules[i]->path, path) == 0) {
+            index = i;
+        }
+    }
+
+    free(path);
+
+    if (index < 0) {
+        joint_c_backend_error(backend, source, "Unknown module", module);
+        return;
+    }
+
+    for (int i = 0; i < import_declaration->childrens_length; i++) {
+        if (strcmp(import_declaration->childrens[i]->name, "specifier") != 0) {
+            continue;
+        }
+
+        const joint_node_t * specifier = import_declaration->childrens[i]->node;
+        const char * name = specifier->childrens[0]->string;
+        const joint_c_backend_binding_t * binding = joint_c_backend_find(backend->compiled[index], backend->compiled_capacities[index], name);
+
+        if (binding == NULL) {
+            joint_c_backend_error(backend, specifier, "Unknown import", name);
+            continue;
+        }
+
+        joint_c_backend_bind(backend, name, binding->builtin, binding->module);
+    }
+}
+
+static void joint_c_backend_write_import(joint_c_backend_t * backend, const joint_node_t * import_declaration) {
+    const joint_node_t * source = joint_c_backend_children(import_declaration, "source")->node;
+    const char * module = source->childrens[0]->string;
+
+    if (!joint_builtins_has_module(module)) {
+        joint_c_backend_write_module_import(backend, import_declaration, source);
+        return;
+    }
+
+    for (int i = 0; i < import_declaration->childrens_length; i++) {
+        if (strcmp(import_declaration->childrens[i]->name, "specifier") != 0) {
+            continue;
+        }
+
+        const joint_node_t * specifier = import_declaration->childrens[i]->node;
+        const char * name = specifier->childrens[0]->string;
+        const joint_builtin_t * builtin = joint_builtins_find(module, name);
+
+        if (builtin == NULL) {
+            joint_c_backend_error(backend, specifier, "Unknown import", name);
+            continue;
+        }
+
+        joint_c_backend_bind(backend, name, builtin, -1);
+    }
+}
+
+static void joint_c_backend_write_variable_declaration(joint_c_backend_t * backend, const joint_node_t * variable_declaration) {
+    const char * name = joint_c_backend_children(variable_declaration, "id")->node->childrens[0]->string;
+    const joint_node_t * init = joint_c_backend_children(variable_declaration, "init")->node;
+
+    /* The initializer still sees the previous binding of the name. */
+    joint_c_backend_write_statement(backend, joint_c_backend_declare(backend, name) ? "" : "joint_value ", name, init);
+    joint_c_backend_bind(backend, name, NULL, backend->module);
+}
+
+static void joint_c_backend_write_elements(joint_c_backend_t * backend, const joint_node_t * program) {
+    for (int i = 0; i < program->childrens_length; i++) {
+        const joint_node_t * element = program->childrens[i]->node;
+
+        switch (element->type) {
+            case COMMENT_NODE:
+                joint_c_backend_write_comment(backend, element);
+                break;
+
+            case IMPORT_DECLARATION_NODE:
+                joint_c_backend_write_import(backend, element);
+                break;
+
+            case VARIABLE_DECLARATION_NODE:
+                joint_c_backend_write_variable_declaration(backend, element);
+                break;
+
+            default:
+                joint_c_backend_write_statement(backend, "", NULL, element);
+                break;
+        }
+    }
+}
+
+/* A module is written with binding and declaration tables of its own,
+ * which then serve its importers. */
+static void joint_c_backend_write_module(joint_c_backend_t * backend, int module) {
+    joint_c_backend_binding_t * bindings = backend->bindings;
+    int bindings_length = backend->bindings_length;
+    int bindings_capacity = backend->bindings_capacity;
+    const joint_intern_string_t ** declared = backend->declared;
+    int declared_length = backend->declared_length;
+    int declared_capacity = backend->declared_capacity;
+
+    backend->bindings_length = 0;
+    backend->bindings_capacity = 64;
+    backend->bindings = calloc(backend->bindings_capacity, sizeof(joint_c_backend_binding_t));
+    backend->declared_length = 0;
+    backend->declared_capacity = 64;
+    backend->declared = calloc(backend->declared_capacity, sizeof(joint_intern_string_t *));
+    assert(backend->bindings && backend->declared);
+    backend->module = module;
+
+    joint_c_backend_write_elements(backend, backend->modules[module]->program);
+
+    backend->compiled[backend->compiled_length] = backend->bindings;
+    backend->compiled_capacities[backend->compiled_length++] = backend->bindings_capacity;
+    free(backend->declared);
+
+    backend->bindings = bindings;
+    backend->bindings_length = bindings_length;
+    backend->bindings_capacity = bindings_capacity;
+    backend->declared = declared;
+    backend->declared_length = declared_length;
+    backend->declared_capacity = declared_capacity;
+    backend->module = -1;
+}
+
+static void joint_c_backend_write_program(joint_c_backend_t * backend, const joint_node_t * program) {
+    joint_c_backend_write(backend, "/* Generated by joint from ");
+    joint_c_backend_write(backend, program->start_position->path);
+    joint_c_backend_write(backend, " */\n\n#include \"joint_runtime.h\"\n\nint main(void) {\n");
+
+    for (int i = 0; i < backend->modules_length; i++) {
+        joint_c_backend_write_module(backend, i);
+    }
+
+    joint_c_backend_write_elements(backend, program);
+    joint_c_backend_write(backend, "\n    return joint_exit();\n}\n");
+}
+
+bool joint_c_backend_emit(joint_writer_t * writer, const joint_node_t * program) {
+    joint_c_backend_t backend = {
+        .writer = NULL,
+        .failed = false,
+        .temporaries_length = 0,
+        .bindings_length = 0,
+        .bindings_capacity = 64,
+        .declared_length = 0,
+        .declared_capacity = 64,
+        .frames_length = 0,
+        .frames_capacity = 16,
+        .frames = malloc(sizeof(joint_c_backend_frame_t) * 16),
+        .modules_length = 0,
+        .modules = NULL,
+        .module = -1
+    };
+    assert(backend.frames);
+
+    backend.failed = !joint_module_load_imports(program, &backend.modules, &backend.modules_length);
+    backend.compiled = malloc(sizeof(joint_c_backend_binding_t *) * (backend.modules_length + 1));
+    backend.compiled_capacities = malloc(sizeof(int) * (backend.modules_length + 1));
+    assert(backend.compiled && backend.compiled_capacities);
+
+    for (int pass = 0; pass < 2 && !backend.failed; pass++) {
+        backend.writer = pass == 0 ? NULL : writer;
+        backend.temporaries_length = 0;
+        backend.bindings_length = 0;
+        backend.bindings = calloc(backend.bindings_capacity, sizeof(joint_c_backend_binding_t));
+        backend.declared_length = 0;
+        backend.declared = calloc(backend.declared_capacity, sizeof(joint_intern_string_t *));
+        backend.compiled_length = 0;
+        assert(backend.bindings && backend.declared);
+
+        joint_c_backend_write_program(&backend, program);
+
+        free(backend.bindings);
+        free(backend.declared);
+
+        for (int i = 0; i < backend.compiled_length; i++) {
+            free(backend.compiled[i]);
+        }
+    }
+
+    free(backend.frames);
+    free(backend.compiled);
+    free(backend.compiled_capacities);
+    joint_module_free_all(backend.modules, backend.modules_length);
+
+    return !backend.failed;
+}
@@ -0,0 +1,292 @@
+/* Copyright (c) 2014 Vyacheslav Slinko
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <assert.h>
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "cache.h"
+#include "dump.h"
+#include "hash.h"
+#include "writer.h"
+
+/* An entry starts with the length of its source and two hashes of it,
+ * the key that names the file and a second one with another seed:
+ *
+ *   "JNTC", u32 version, u64 source length, u64 key, u64 check
+ *
+ * followed by the binary dump of the tokens and the program. */
+#define JOINT_CACHE_MAGIC "JNTC"
+#define JOINT_CACHE_VERSION 1
+#define JOINT_CACHE_HEADER_SIZE 32
+
+typedef struct joint_cache_entry {
+    char * name;
+    uint64_t size;
+    struct timespec modified;
+} joint_cache_entry_t;
+
+joint_cache_t * joint_cache_alloc(const char * directory, uint64_t max_size, const char * version) {
+    joint_cache_t * cache = malloc(sizeof(joint_cache_t));
+    assert(cache);
+
+    cache->directory = malloc(sizeof(char) * (strlen(directory) + 1));
+    assert(cache->directory);
+    strcpy(cache->directory, directory);
+
+    cache->max_size = max_size;
+    cache->seed = joint_hash_string(version, JOINT_DUMP_BINARY_VERSION);
+
+    cache->hits = 0;
+    cache->misses = 0;
+    cache->stores = 0;
+    cache->evictions = 0;
+
+    mkdir(cache->directory, 0777);
+
+    return cache;
+}
+
+static uint32_t joint_cache_get_uint32(const unsigned char * bytes) {
+    return (uint32_t) bytes[0] | ((uint32_t) bytes[1] << 8) | ((uint32_t) bytes[2] << 16) | ((uint32_t) bytes[3] << 24);
+}
+
+static uint64_t joint_cache_get_uint64(const unsigned char * bytes) {
+    return (uint64_t) joint_cache_get_uint32(bytes) | ((uint64_t) joint_cache_get_uint32(bytes + 4) << 32);
+}
+
+static uint64_t joint_cache_key(const joint_cache_t * cache, const joint_source_file_t * source_file) {
+    return joint_hash_bytes(source_file->content->data, (size_t) source_file->content->length, cache->seed);
+}
+
+static uint64_t joint_cache_check(const joint_cache_t * cache, const joint_source_file_t * source_file) {
+    return joint_hash_bytes(source_file->content->data, (size_t) source_file->content->length, ~cache->seed);
+}
+
+/* The file name alone is not trusted, a renamed or colliding entry must
+ * also match the length and both hashes of the source. */
+static bool joint_cache_verify(const joint_cache_t * cache, const joint_source_file_t * source_file, uint64_t key, const unsigned char * data, size_t size) {
+    return size >= JOINT_CACHE_HEADER_SIZE
+        && memcmp(data, JOINT_CACHE_MAGIC, 4) == 0
+        && joint_cache_get_uint32(data + 4) == JOINT_CACHE_VERSION
+        && joint_cache_get_uint64(data + 8) == (uint64_t) source_file->content->length
+        && joint_cache_get_uint64(data + 16) == key
+        && joint_cache_get_uint64(data + 24) == joint_cache_check(cache, source_file);
+}
+
+static char * joint_cache_entry_path(const joint_cache_t * cache, uint64_t key, const char * suffix) {
+    size_t length = strlen(cache->directory) + strlen(suffix) + 18;
+
+    char * path = malloc(sizeof(char) * (length + 1));
+    assert(path);
+    snprintf(path, length + 1, "%s/%016llx%s", cache->directory, (unsigned long long) key, suffix);
+
+    return path;
+}
+
+bool joint_cache_load(joint_cache_t * cache, joint_source_file_t * source_file, joint_tokenizer_t ** tokenizer, joint_node_t ** program) {
+    uint64_t key = joint_cache_key(cache, source_file);
+    char * path = joint_cache_entry_path(cache, key, ".jointc");
+    int fd = open(path, O_RDONLY);
+    free(path);
+
+    struct stat status;
+
+    if (fd < 0 || fstat(fd, &status) != 0 || status.st_size == 0) {
+        if (fd >= 0) {
+            close(fd);
+        }
+
+        cache->misses++;
+        return false;
+    }
+
+    void * data = mmap(NULL, (size_t) status.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+    if (data == MAP_FAILED) {
+        close(fd);
+        cache->misses++;
+        return false;
+    }
+
+    /* The dump holds owned, mutable tokens and nodes, so it is still
+     * deserialized, the mapping only saves copying the file in. */
+    const char * dump = (const char *) data + JOINT_CACHE_HEADER_SIZE;
+    size_t dump_size = (size_t) status.st_size - JOINT_CACHE_HEADER_SIZE;
+    size_t tokens_length = 0;
+    size_t program_length = 0;
+    *tokenizer = joint_tokenizer_alloc(source_file->allocator, source_file);
+    *program = NULL;
+
+    if (joint_cache_verify(cache, source_file, key, data, (size_t) status.st_size) && joint_dump_load_tokens(dump, dump_size, *tokenizer, &tokens_length)) {
+        *program = joint_dump_load_node(source_file->allocator, dump + tokens_length, dump_size - tokens_length, source_file->path, &program_length);
+    }
+
+    munmap(data, (size_t) status.st_size);
+
+    if (*program == NULL) {
+        close(fd);
+        joint_tokenizer_free(*tokenizer);
+        *tokenizer = NULL;
+        cache->misses++;
+        return false;
+    }
+
+    futimens(fd, NULL);
+    close(fd);
+
+    cache->hits++;
+
+    return true;
+}
+
+static int joint_cache_entry_compare(const void * left, const void * right) {
+    const joint_cache_entry_t * left_entry = left;
+    const joint_cache_entry_t * right_entry = right;
+
+    if (left_entry->modified.tv_sec != right_entry->modified.tv_sec) {
+        return left_entry->modified.tv_sec < right_entry->modified.tv_sec ? -1 : 1;
+    }
+
+    if (left_entry->modified.tv_nsec != right_entry->modified.tv_nsec) {
+        return left_entry->modified.tv_nsec < right_entry->modified.tv_nsec ? -1 : 1;
+    }
+
+    return 0;
+}
+
+static void joint_cache_evict(joint_cache_t * cache) {
+    DIR * directory = opendir(cache->directory);
+
+    if (directory == NULL) {
+        return;
+    }
+
+    int entries_length = 0;
+    joint_cache_entry_t * entries = NULL;
+    uint64_t total_size = 0;
+    int directory_fd = dirfd(directory);
+    struct dirent * dirent;
+
+    while ((dirent = readdir(directory)) != NULL) {
+        size_t name_length = strlen(dirent->d_name);
+        struct stat status;
+
+        if (name_length < 7 || strcmp(dirent->d_name + name_length - 7, ".jointc") != 0) {
+            continue;
+        }
+
+        if (fstatat(directory_fd, dirent->d_name, &status, 0) != 0) {
+            continue;
+        }
+
+        entries = realloc(entries, sizeof(joint_cache_entry_t) * (entries_length + 1));
+        assert(entries);
+
+        joint_cache_entry_t * entry = &entries[entries_length++];
+        entry->name = malloc(sizeof(char) * (name_length + 1));
+        assert(entry->name);
+        strcpy(entry->name, dirent->d_name);
+        entry->size = (uint64_t) status.st_size;
+        entry->modified = status.st_mtim;
+
+        total_size += entry->size;
+    }
+
+    if (total_size > cache->max_size) {
+        qsort(entries, entries_length, sizeof(joint_cache_entry_t), joint_cache_entry_compare);
+
+        for (int i = 0; i < entries_length && total_size > cache->max_size; i++) {
+            if (unlinkat(directory_fd, entries[i].name, 0) == 0 || errno == ENOENT) {
+                total_size -= entries[i].size;
+                cache->evictions++;
+            }
+        }
+    }
+
+    for (int i = 0; i < entries_length; i++) {
+        free(entries[i].name);
+    }
+
+    if (entries != NULL) {
+        free(entries);
+    }
+
+    closedir(directory);
+}
+
+bool joint_cache_store(joint_cache_t * cache, const joint_tokenizer_t * tokenizer, joint_node_t * program) {
+    /* Several threads may store the same entry at once, so the temporary
+     * name is unique per call rather than per process. */
+    uint64_t key = joint_cache_key(cache, tokenizer->source_file);
+    char * temporary_path = joint_cache_entry_path(cache, key, ".tmp.XXXXXX");
+    int fd = mkstemp(temporary_path);
+
+    if (fd < 0) {
+        free(temporary_path);
+        return false;
+    }
+
+    fchmod(fd, 0644);
+
+    joint_writer_t * writer = joint_writer_alloc(fd, 1 << 20);
+    joint_writer_write(writer, JOINT_CACHE_MAGIC, 4);
+    joint_writer_write_uint32(writer, JOINT_CACHE_VERSION);
+    joint_writer_write_uint64(writer, (uint64_t) tokenizer->source_file->content->length);
+    joint_writer_write_uint64(writer, key);
+    joint_writer_write_uint64(writer, joint_cache_check(cache, tokenizer->source_file));
+    joint_dump_tokens(writer, tokenizer, BINARY_DUMP_FORMAT);
+    joint_dump_node(writer, program, BINARY_DUMP_FORMAT);
+    bool written = joint_writer_flush(writer);
+    joint_writer_free(writer);
+
+    if (close(fd) != 0) {
+        written = false;
+    }
+
+    char * path = joint_cache_entry_path(cache, key, ".jointc");
+
+    if (!written || rename(temporary_path, path) != 0) {
+        unlink(temporary_path);
+        written = false;
+    }
+
+    free(path);
+    free(temporary_path);
+
+    if (written) {
+        cache->stores++;
+        joint_cache_evict(cache);
+    }
+
+    return written;
+}
+
+void joint_cache_free(joint_cache_t * cache) {
+    free(cache->directory);
+    free(cache);
+}
@@ -0,0 +1,50 @@
+/* Copyright (c) 2014 Vyacheslav Slinko
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef joint_cache_h
+#define joint_cache_h
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "node.h"
+#include "source_file.h"
+#include "tokenizer.h"
+
+typedef struct joint_cache {
+    char * directory;
+    uint64_t max_size;
+    uint64_t seed;
+
+    int hits;
+    int misses;
+    int stores;
+    int evictions;
+} joint_cache_t;
+
+joint_cache_t * joint_cache_alloc(const char * directory, uint64_t max_size, const char * version);
+
+bool joint_cache_load(joint_cache_t * cache, joint_source_file_t * source_file, joint_tokenizer_t ** tokenizer, joint_node_t ** program);
+
+bool joint_cache_store(joint_cache_t * cache, const joint_tokenizer_t * tokenizer, joint_node_t * program);
+
+void joint_cache_free(joint_cache_t * cache);
+
+#endif
@@ -0,0 +1,169 @@
+/* Copyright (c) 2014 Vyacheslav Slinko
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "constants.h"
+#include "hash.h"
+
+joint_constants_t * joint_constants_alloc(void) {
+    joint_constants_t * constants = malloc(sizeof(joint_constants_t));
+    assert(constants);
+
+    constants->values_length = 0;
+    constants->values_capacity = 64;
+    constants->values = malloc(sizeof(joint_value_t) * constants->values_capacity);
+    assert(constants->values);
+
+    constants->slots_capacity = 128;
+    constants->slots = malloc(sizeof(int) * constants->slots_capacity);
+    assert(constants->slots);
+    memset(constants->slots, 0xFF, sizeof(int) * constants->slots_capacity);
+
+    constants->lexemes_length = 0;
+    constants->lexemes_capacity = 64;
+    constants->lexemes = calloc(constants->lexemes_capacity, sizeof(joint_constants_lexeme_t));
+    assert(constants->lexemes);
+
+    return constants;
+}
+
+joint_constants_t * joint_constants_clone(const joint_constants_t * constants) {
+    joint_constants_t * clone = malloc(sizeof(joint_constants_t));
+    assert(clone);
+
+    *clone = *constants;
+
+    clone->values = malloc(sizeof(joint_value_t) * clone->values_capacity);
+    clone->slots = malloc(sizeof(int) * clone->slots_capacity);
+    clone->lexemes = malloc(sizeof(joint_constants_lexeme_t) * clone->lexemes_capacity);
+    assert(clone->values && clone->slots && clone->lexemes);
+
+    memcpy(clone->values, constants->values, sizeof(joint_value_t) * constants->values_length);
+    memcpy(clone->slots, constants->slots, sizeof(int) * constants->slots_capacity);
+    memcpy(clone->lexemes, constants->lexemes, sizeof(joint_constants_lexeme_t) * constants->lexemes_capacity);
+
+    return clone;
+}
+
+static int * joint_constants_slot(const joint_constants_t * constants, int * slots, int capacity, joint_value_t value) {
+    int slot = (int) (joint_hash_bytes(&value, sizeof(value), 0) & (uint64_t) (capacity - 1));
+
+    while (slots[slot] >= 0 && constants->values[slots[slot]] != value) {
+        slot = (slot + 1) & (capacity - 1);
+    }
+
+    return &slots[slot];
+}
+
+static void joint_constants_grow_slots(joint_constants_t * constants) {
+    int capacity = constants->slots_capacity * 2;
+    int * slots = malloc(sizeof(int) * capacity);
+    assert(slots);
+    memset(slots, 0xFF, sizeof(int) * capacity);
+
+    for (int i = 0; i < constants->values_length; i++) {
+        *joint_constants_slot(constants, slots, capacity, constants->values[i]) = i;
+    }
+
+    free(constants->slots);
+    constants->slots = slots;
+    constants->slots_capacity = capacity;
+}
+
+int joint_constants_add(joint_constants_t * constants, joint_value_t value) {
+    if ((constants->values_length + 1) * 4 > constants->slots_capacity * 3) {
+        joint_constants_grow_slots(constants);
+    }
+
+    int * slot = joint_constants_slot(constants, constants->slots, constants->slots_capacity, value);
+
+    if (*slot >= 0) {
+        return *slot;
+    }
+
+    if (constants->values_length == constants->values_capacity) {
+        constants->values_capacity *= 2;
+        constants->values = realloc(constants->values, sizeof(joint_value_t) * constants->values_capacity);
+        assert(constants->values);
+    }
+
+    constants->values[constants->values_length] = value;
+    *slot = constants->values_length;
+
+    return constants->values_length++;
+}
+
+static joint_constants_lexeme_t * joint_constants_lexeme_slot(joint_constants_lexeme_t * lexemes, int capacity, const joint_intern_string_t * lexeme) {
+    int slot = (int) (lexeme->hash & (uint64_t) (capacity - 1));
+
+    while (lexemes[slot].lexeme != NULL && lexemes[slot].lexeme != lexeme) {
+        slot = (slot + 1) & (capacity - 1);
+    }
+
+    return &lexemes[slot];
+}
+
+static void joint_constants_grow_lexemes(joint_constants_t * constants) {
+    int capacity = constants->lexemes_capacity * 2;
+    joint_constants_lexeme_t * lexemes = calloc(capacity, sizeof(joint_constants_lexeme_t));
+    assert(lexemes);
+
+    for (int i = 0; i < constants->lexemes_capacity; i++) {
+        if (constants->lexemes[i].lexeme != NULL) {
+            *joint_constants_lexeme_slot(lexemes, capacity, constants->lexemes[i].lexeme) = constants->lexemes[i];
+        }
+    }
+
+    free(constants->lexemes);
+    constants->lexemes = lexemes;
+    constants->lexemes_capacity = capacity;
+}
+
+int joint_constants_add_number(joint_constants_t * constants, const char * lexeme, size_t length, long double * number) {
+    if ((constants->lexemes_length + 1) * 4 > constants->lexemes_capacity * 3) {
+        joint_constants_grow_lexemes(constants);
+    }
+
+    const joint_intern_string_t * interned = joint_intern(lexeme, length);
+    joint_constants_lexeme_t * entry = joint_constants_lexeme_slot(constants->lexemes, constants->lexemes_capacity, interned);
+
+    if (entry->lexeme == NULL) {
+        entry->lexeme = interned;
+        entry->number = 0;
+        sscanf(interned->characters, "%Lf", &entry->number);
+        entry->constant = joint_constants_add(constants, joint_value_number((double) entry->number));
+        constants->lexemes_length++;
+    }
+
+    *number = entry->number;
+
+    return entry->constant;
+}
+
+void joint_constants_free(joint_constants_t * constants) {
+    free(constants->values);
+    free(constants->slots);
+    free(constants->lexemes);
+    free(constants);
+}
@@ -0,0 +1,67 @@
+/* Copyright (c) 2014 Vyacheslav Slinko
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef joint_constants_h
+#define joint_constants_h
+
+#include <stddef.h>
+#include "intern.h"
+#include "value.h"
+
+/* Literal values of a module, hash-consed so that equal values share one
+ * index. Strings are interned, numeric lexemes that were seen before are
+ * not converted again. The values array is laid out as a constant table
+ * that backends can load from directly. */
+
+typedef struct joint_constants_lexeme {
+    const joint_intern_string_t * lexeme;
+    long double number;
+    int constant;
+} joint_constants_lexeme_t;
+
+typedef struct joint_constants {
+    int values_length;
+    int values_capacity;
+    joint_value_t * values;
+
+    /* Indexes into values, -1 for empty slots. */
+    int slots_capacity;
+    int * slots;
+
+    int lexemes_length;
+    int lexemes_capacity;
+    joint_constants_lexeme_t * lexemes;
+} joint_constants_t;
+
+joint_constants_t * joint_constants_alloc(void);
+
+joint_constants_t * joint_constants_clone(const joint_constants_t * constants);
+
+/* Returns the index of value, adding it when it is new. */
+int joint_constants_add(joint_constants_t * constants, joint_value_t value);
+
+/* Returns the index of the numeric literal spelled by lexeme and stores its
+ * full precision value in number. */
+int joint_constants_add_number(joint_constants_t * constants, const char * lexeme, size_t length, long double * number);
+
+void joint_constants_free(joint_constants_t * constants);
+
+#endif
@@ -0,0 +1,99 @@
+/* Copyright (c) 2014 Vyacheslav Slinko
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "context.h"
+
+joint_context_t * joint_context_alloc(joint_allocator_t * allocator) {
+    joint_context_t * context = malloc(sizeof(joint_context_t));
+    assert(context);
+
+    context->owns_allocator = allocator == NULL;
+    context->allocator = allocator != NULL ? allocator : joint_allocator_pool_alloc();
+
+    context->source_file = NULL;
+    context->tokenizer = NULL;
+    context->parser = NULL;
+    context->error = NULL;
+
+    return context;
+}
+
+joint_node_t * joint_context_compile(joint_context_t * context, const char * path, const char * data, size_t length) {
+    joint_context_reset(context);
+
+    context->source_file = joint_source_file_alloc_borrowed(context->allocator, path, data, length);
+
+    if (!joint_source_file_validate(context->source_file)) {
+        int length = snprintf(NULL, 0, "%s: invalid UTF-8", path);
+        context->error = malloc(length + 1);
+        assert(context->error);
+        snprintf(context->error, length + 1, "%s: invalid UTF-8", path);
+        return NULL;
+    }
+
+    context->tokenizer = joint_tokenizer_alloc(context->allocator, context->source_file);
+    joint_tokenizer_tokenize(context->tokenizer);
+
+    context->parser = joint_parser_alloc(context->allocator, context->tokenizer);
+
+    if (!joint_parser_parse(context->parser)) {
+        int length = joint_parser_format_error(context->parser, NULL, 0);
+        context->error = malloc(length + 1);
+        assert(context->error);
+        joint_parser_format_error(context->parser, context->error, length + 1);
+        return NULL;
+    }
+
+    return context->parser->program;
+}
+
+void joint_context_reset(joint_context_t * context) {
+    free(context->error);
+    context->error = NULL;
+
+    if (context->parser != NULL) {
+        joint_parser_free(context->parser);
+        context->parser = NULL;
+    }
+
+    if (context->tokenizer != NULL) {
+        joint_tokenizer_free(context->tokenizer);
+        context->tokenizer = NULL;
+    }
+
+    if (context->source_file != NULL) {
+        joint_source_file_free(context->source_file);
+        context->source_file = NULL;
+    }
+}
+
+void joint_context_free(joint_context_t * context) {
+    joint_context_reset(context);
+
+    if (context->owns_allocator) {
+        joint_allocator_free(context->allocator);
+    }
+
+    free(context);
+}
@@ -0,0 +1,61 @@
+/* Copyright (c) 2014 Vyacheslav Slinko
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef joint_context_h
+#define joint_context_h
+
+#include <stddef.h>
+#include "allocator.h"
+#include "node.h"
+#include "parser.h"
+#include "source_file.h"
+#include "tokenizer.h"
+
+/* Keeps the tokens and AST of the latest compiled snippet. Compiling the
+ * next one releases them into the same allocator, so a context reused for
+ * many snippets works on warm memory. */
+typedef struct joint_context {
+    joint_allocator_t * allocator;
+    bool owns_allocator;
+
+    joint_source_file_t * source_file;
+    joint_tokenizer_t * tokenizer;
+    joint_parser_t * parser;
+
+    /* The diagnostic of the latest compile when it failed, otherwise NULL. */
+    char * error;
+} joint_context_t;
+
+/* A NULL allocator gives the context a pool of its own. */
+joint_context_t * joint_context_alloc(joint_allocator_t * allocator);
+
+/* Tokenizes and parses length bytes of data, which is read in place and
+ * must stay unchanged while the result is used. path only appears in
+ * positions. The program belongs to the context and is valid until the
+ * next compile, reset or free. Returns NULL with context->error set for
+ * sources that are not UTF-8 and for syntax errors. */
+joint_node_t * joint_context_compile(joint_context_t * context, const char * path, const char * data, size_t length);
+
+void joint_context_reset(joint_context_t * context);
+
+void joint_context_free(joint_context_t * context);
+
+#endif
@@ -0,0 +1,889 @@
+/* Copyright (c) 2014 Vyacheslav Slinko
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "dump.h"
+
+bool joint_dump_parse_format(const char * name, enum joint_dump_format * format) {
+    if (strcmp(name, "text") == 0) {
+        *format = TEXT_DUMP_FORMAT;
+    } else if (strcmp(name, "json") == 0) {
+        *format = JSON_DUMP_FORMAT;
+    } else if (strcmp(name, "binary") == 0) {
+        *format = BINARY_DUMP_FORMAT;
+    } else {
+        return false;
+    }
+
+    return true;
+}
+
+static void joint_dump_text_position(joint_writer_t * writer, const char * label, const joint_source_file_position_t * position) {
+    joint_writer_write_string(writer, label);
+    joint_writer_write_string(writer, ": p ");
+    joint_writer_write_integer(writer, position->position);
+    joint_writer_write_string(writer, " l ");
+    joint_writer_write_integer(writer, position->line);
+    joint_writer_write_string(writer, " c ");
+    joint_writer_write_integer(writer, position->column);
+    joint_writer_write_character(writer, '\n');
+}
+
+static void joint_dump_json_string(joint_writer_t * writer, const char * string) {
+    static const char hex[] = "0123456789abcdef";
+    const char * run = string;
+
+    joint_writer_write_character(writer, '"');
+
+    for (const char * character = string; *character != '\0'; character++) {
+        unsigned char byte = (unsigned char) *character;
+
+        if (byte >= 0x20 && byte != '"' && byte != '\\') {
+            continue;
+        }
+
+        joint_writer_write(writer, run, character - run);
+        run = character + 1;
+
+        switch (byte) {
+            case '"':
+                joint_writer_write_string(writer, "\\\"");
+                break;
+
+            case '\\':
+                joint_writer_write_string(writer, "\\\\");
+                break;
+
+            case '\n':
+                joint_writer_write_string(writer, "\\n");
+                break;
+
+            case '\t':
+                joint_writer_write_string(writer, "\\t");
+                break;
+
+            default:
+                joint_writer_write_string(writer, "\\u00");
+                joint_writer_write_character(writer, hex[byte >> 4]);
+                joint_writer_write_character(writer, hex[byte & 0x0F]);
+                break;
+        }
+    }
+
+    joint_writer_write(writer, run, strlen(run));
+    joint_writer_write_character(writer, '"');
+}
+
+static void joint_dump_json_position(joint_writer_t * writer, const joint_source_file_position_t * position) {
+    joint_writer_write_string(writer, "{\"position\":");
+    joint_writer_write_integer(writer, position->position);
+    joint_writer_write_string(writer, ",\"line\":");
+    joint_writer_write_integer(writer, position->line);
+    joint_writer_write_string(writer, ",\"column\":");
+    joint_writer_write_integer(writer, position->column);
+    joint_writer_write_character(writer, '}');
+}
+
+static void joint_dump_binary_position(joint_writer_t * writer, const joint_source_file_position_t * position, bool wide) {
+    if (wide) {
+        joint_writer_write_uint64(writer, position->position);
+        joint_writer_write_uint64(writer, position->line);
+        joint_writer_write_uint64(writer, position->column);
+        joint_writer_write_uint64(writer, position->code_point_column);
+    } else {
+        joint_writer_write_uint32(writer, (uint32_t) position->position);
+        joint_writer_write_uint32(writer, (uint32_t) position->line);
+        joint_writer_write_uint32(writer, (uint32_t) position->column);
+        joint_writer_write_uint32(writer, (uint32_t) position->code_point_column);
+    }
+}
+
+/* Lines and columns never exceed the offset, so the last position of a
+ * source tells whether all of them fit in 32 bits. */
+static bool joint_dump_binary_is_wide(const joint_source_file_position_t * last_position) {
+    return last_position->position > UINT32_MAX;
+}
+
+static size_t joint_dump_binary_record_size(bool wide) {
+    return wide ? JOINT_DUMP_BINARY_WIDE_RECORD_SIZE : JOINT_DUMP_BINARY_RECORD_SIZE;
+}
+
+static void joint_dump_binary_record_header(joint_writer_t * writer, uint64_t length, uint32_t type, bool wide) {
+    if (wide) {
+        joint_writer_write_uint64(writer, length);
+        joint_writer_write_uint32(writer, type);
+        joint_writer_write_uint32(writer, 0);
+    } else {
+        joint_writer_write_uint32(writer, (uint32_t) length);
+        joint_writer_write_uint32(writer, type);
+    }
+}
+
+static size_t joint_dump_binary_string_size(size_t length) {
+    return (length + 1 + JOINT_DUMP_BINARY_ALIGNMENT - 1) / JOINT_DUMP_BINARY_ALIGNMENT * JOINT_DUMP_BINARY_ALIGNMENT;
+}
+
+static void joint_dump_binary_string(joint_writer_t * writer, const char * string, size_t length) {
+    joint_writer_write(writer, string, length);
+    joint_writer_write_repeat(writer, '\0', joint_dump_binary_string_size(length) - length);
+}
+
+static void joint_dump_binary_header(joint_writer_t * writer, enum joint_dump_binary_kind kind, const char * path, uint64_t records_length, bool wide) {
+    size_t path_length = strlen(path);
+
+    joint_writer_write(writer, JOINT_DUMP_BINARY_MAGIC, 4);
+    joint_writer_write_uint32(writer, JOINT_DUMP_BINARY_VERSION);
+    joint_writer_write_uint32(writer, kind);
+    joint_writer_write_uint32(writer, wide ? JOINT_DUMP_BINARY_WIDE : 0);
+    joint_writer_write_uint64(writer, 8 + joint_dump_binary_string_size(path_length) + records_length);
+
+    joint_writer_write_uint64(writer, path_length);
+    joint_dump_binary_string(writer, path, path_length);
+}
+
+void joint_dump_tokens(joint_writer_t * writer, const joint_tokenizer_t * tokenizer, enum joint_dump_format format) {
+    switch (format) {
+        case TEXT_DUMP_FORMAT:
+            for (size_t i = 0; i < tokenizer->tokens_length; i++) {
+                joint_token_t * token = tokenizer->tokens[i];
+
+                joint_writer_write_string(writer, "TYPE: ");
+                joint_writer_write_string(writer, joint_tokenizer_token_type_name(token->type));
+                joint_writer_write_string(writer, "\nVALUE: \"");
+                joint_writer_write(writer, token->value->data, token->value->length);
+                joint_writer_write_string(writer, "\"\n");
+                joint_dump_text_position(writer, "START", token->start_position);
+                joint_dump_text_position(writer, "END", token->end_position);
+                joint_writer_write_string(writer, "---\n");
+            }
+            break;
+
+        case JSON_DUMP_FORMAT:
+            joint_writer_write_character(writer, '[');
+
+            for (size_t i = 0; i < tokenizer->tokens_length; i++) {
+                joint_token_t * token = tokenizer->tokens[i];
+
+                if (i > 0) {
+                    joint_writer_write_character(writer, ',');
+                }
+
+                joint_writer_write_string(writer, "{\"type\":\"");
+                joint_writer_write_string(writer, joint_tokenizer_token_type_name(token->type));
+                joint_writer_write_string(writer, "\",\"value\":");
+                joint_dump_json_string(writer, token->value->data);
+                joint_writer_write_string(writer, ",\"start\":");
+                joint_dump_json_position(writer, token->start_position);
+                joint_writer_write_string(writer, ",\"end\":");
+                joint_dump_json_position(writer, token->end_position);
+                joint_writer_write_character(writer, '}');
+            }
+
+            joint_writer_write_string(writer, "]\n");
+            break;
+
+        case BINARY_DUMP_FORMAT: {
+            bool wide = joint_dump_binary_is_wide(tokenizer->tokens[tokenizer->tokens_length - 1]->end_position);
+            uint64_t records_length = 0;
+
+            for (size_t i = 0; i < tokenizer->tokens_length; i++) {
+                records_length += joint_dump_binary_record_size(wide) + joint_dump_binary_string_size(tokenizer->tokens[i]->value->length);
+            }
+
+            joint_dump_binary_header(writer, TOKENS_BINARY_KIND, tokenizer->source_file->path, records_length, wide);
+
+            for (size_t i = 0; i < tokenizer->tokens_length; i++) {
+                joint_token_t * token = tokenizer->tokens[i];
+
+                joint_dump_binary_record_header(writer, joint_dump_binary_record_size(wide) + joint_dump_binary_string_size(token->value->length), token->type, wide);
+                joint_dump_binary_position(writer, token->start_position, wide);
+                joint_dump_binary_position(writer, token->end_position, wide);
+                joint_writer_write_uint64(writer, token->value->length);
+                joint_dump_binary_string(writer, token->value->data, token->value->length);
+            }
+            break;
+        }
+    }
+}
+
+static joint_node_walk_action_t joint_dump_text_enter(joint_node_t * node, const joint_node_children_t * relation, int depth, void * data) {
+    joint_writer_t * writer = data;
+    int indent = depth * 8;
+
+    if (relation != NULL) {
+        joint_writer_write_repeat(writer, ' ', indent - 4);
+        joint_writer_write_string(writer, relation->name);
+        joint_writer_write_string(writer, ":\n");
+    }
+
+    joint_writer_write_repeat(writer, ' ', indent);
+    joint_writer_write_string(writer, "TYPE: ");
+    joint_writer_write_string(writer, joint_node_type_name(node->type));
+    joint_writer_write_character(writer, '\n');
+    joint_writer_write_repeat(writer, ' ', indent);
+    joint_dump_text_position(writer, "START", node->start_position);
+    joint_writer_write_repeat(writer, ' ', indent);
+    joint_dump_text_position(writer, "END", node->end_position);
+    joint_writer_write_repeat(writer, ' ', indent);
+
+    if (node->childrens_length > 0) {
+        joint_writer_write_string(writer, "CHILDRENS:\n");
+    } else {
+        joint_writer_write_string(writer, "CHILDRENS: ~\n");
+    }
+
+    return JOINT_NODE_WALK_CONTINUE;
+}
+
+static joint_node_walk_action_t joint_dump_text_scalar(joint_node_t * node, const joint_node_children_t * relation, int depth, void * data) {
+    joint_writer_t * writer = data;
+
+    joint_writer_write_repeat(writer, ' ', depth * 8 + 4);
+    joint_writer_write_string(writer, relation->name);
+    joint_writer_write_string(writer, ": ");
+
+    switch (relation->type) {
+        case NUMBER_CHILDREN:
+            joint_writer_write_long_double(writer, relation->number);
+            break;
+
+        case BOOLEAN_CHILDREN:
+            joint_writer_write_string(writer, relation->boolean ? "true" : "false");
+            break;
+
+        case CHARACTER_CHILDREN:
+            joint_writer_write_character(writer, '\'');
+            joint_writer_write_character(writer, relation->character);
+            joint_writer_write_character(writer, '\'');
+            break;
+
+        case STRING_CHILDREN:
+            joint_writer_write_character(writer, '"');
+            joint_writer_write_string(writer, relation->string);
+            joint_writer_write_character(writer, '"');
+            break;
+
+        case NULL_CHILDREN:
+            joint_writer_write_string(writer, "null");
+            break;
+
+        default:
+            assert(NULL);
+    }
+
+    joint_writer_write_character(writer, '\n');
+
+    return JOINT_NODE_WALK_CONTINUE;
+}
+
+typedef struct joint_dump_json_state {
+    joint_writer_t * writer;
+    bool needs_comma;
+} joint_dump_json_state_t;
+
+static joint_node_walk_action_t joint_dump_json_enter(joint_node_t * node, const joint_node_children_t * relation, int depth, void * data) {
+    joint_dump_json_state_t * state = data;
+
+    if (state->needs_comma) {
+        joint_writer_write_character(state->writer, ',');
+    }
+
+    if (relation != NULL) {
+        joint_writer_write_string(state->writer, "{\"name\":");
+        joint_dump_json_string(state->writer, relation->name);
+        joint_writer_write_string(state->writer, ",\"node\":");
+    }
+
+    joint_writer_write_string(state->writer, "{\"type\":\"");
+    joint_writer_write_string(state->writer, joint_node_type_name(node->type));
+    joint_writer_write_string(state->writer, "\",\"start\":");
+    joint_dump_json_position(state->writer, node->start_position);
+    joint_writer_write_string(state->writer, ",\"end\":");
+    joint_dump_json_position(state->writer, node->end_position);
+    joint_writer_write_string(state->writer, ",\"childrens\":[");
+
+    state->needs_comma = false;
+
+    return JOINT_NODE_WALK_CONTINUE;
+}
+
+static joint_node_walk_action_t joint_dump_json_scalar(joint_node_t * node, const joint_node_children_t * relation, int depth, void * data) {
+    joint_dump_json_state_t * state = data;
+    char character[2] = {relation->character, '\0'};
+
+    if (state->needs_comma) {
+        joint_writer_write_character(state->writer, ',');
+    }
+
+    joint_writer_write_string(state->writer, "{\"name\":");
+    joint_dump_json_string(state->writer, relation->name);
+
+    switch (relation->type) {
+        case NUMBER_CHILDREN:
+            joint_writer_write_string(state->writer, ",\"number\":");
+            joint_writer_write_long_double(state->writer, relation->number);
+            break;
+
+        case BOOLEAN_CHILDREN:
+            joint_writer_write_string(state->writer, relation->boolean ? ",\"boolean\":true" : ",\"boolean\":false");
+            break;
+
+        case CHARACTER_CHILDREN:
+            joint_writer_write_string(state->writer, ",\"character\":");
+            joint_dump_json_string(state->writer, character);
+            break;
+
+        case STRING_CHILDREN:
+            joint_writer_write_string(state->writer, ",\"string\":");
+            joint_dump_json_string(state->writer, relation->string);
+            break;
+
+        case NULL_CHILDREN:
+            joint_writer_write_string(state->writer, ",\"null\":null");
+            break;
+
+        default:
+            assert(NULL);
+    }
+
+    joint_writer_write_character(state->writer, '}');
+    state->needs_comma = true;
+
+    return JOINT_NODE_WALK_CONTINUE;
+}
+
+static joint_node_walk_action_t joint_dump_json_leave(joint_node_t * node, const joint_node_children_t * relation, int depth, void * data) {
+    joint_dump_json_state_t * state = data;
+
+    joint_writer_write_string(state->writer, relation != NULL ? "]}}" : "]}");
+    state->needs_comma = true;
+
+    return JOINT_NODE_WALK_CONTINUE;
+}
+
+typedef struct joint_dump_binary_state {
+    joint_writer_t * writer;
+    bool wide;
+    int nodes_length;
+    int nodes_capacity;
+    uint64_t * subtree_lengths;
+    int depths_capacity;
+    int * depths;
+    int current_node;
+} joint_dump_binary_state_t;
+
+static size_t joint_dump_binary_children_size(const joint_node_children_t * children) {
+    size_t size = 8 + joint_dump_binary_string_size(strlen(children->name));
+
+    switch (children->type) {
+        case NUMBER_CHILDREN:
+        case BOOLEAN_CHILDREN:
+        case CHARACTER_CHILDREN:
+            return size + 8;
+
+        case STRING_CHILDREN:
+            return size + 8 + joint_dump_binary_string_size(strlen(children->string));
+
+        default:
+            return size;
+    }
+}
+
+static joint_node_walk_action_t joint_dump_binary_measure_enter(joint_node_t * node, const joint_node_children_t * relation, int depth, void * data) {
+    joint_dump_binary_state_t * state = data;
+
+    if (state->nodes_length == state->nodes_capacity) {
+        state->nodes_capacity *= 2;
+        state->subtree_lengths = realloc(state->subtree_lengths, sizeof(uint64_t) * state->nodes_capacity);
+        assert(state->subtree_lengths);
+    }
+
+    if (depth == state->depths_capacity) {
+        state->depths_capacity *= 2;
+        state->depths = realloc(state->depths, sizeof(int) * state->depths_capacity);
+        assert(state->depths);
+    }
+
+    size_t size = joint_dump_binary_record_size(state->wide);
+
+    for (int i = 0; i < node->childrens_length; i++) {
+        size += joint_dump_binary_children_size(node->childrens[i]);
+    }
+
+    state->depths[depth] = state->nodes_length;
+    state->subtree_lengths[state->nodes_length++] = size;
+
+    return JOINT_NODE_WALK_CONTINUE;
+}
+
+static joint_node_walk_action_t joint_dump_binary_measure_leave(joint_node_t * node, const joint_node_children_t * relation, int depth, void * data) {
+    joint_dump_binary_state_t * state = data;
+
+    if (depth > 0) {
+        state->subtree_lengths[state->depths[depth - 1]] += state->subtree_lengths[state->depths[depth]];
+    }
+
+    return JOINT_NODE_WALK_CONTINUE;
+}
+
+static void joint_dump_binary_children_header(joint_writer_t * writer, const joint_node_children_t * children) {
+    size_t name_length = strlen(children->name);
+
+    joint_writer_write_uint32(writer, children->type);
+    joint_writer_write_uint32(writer, (uint32_t) name_length);
+    joint_dump_binary_string(writer, children->name, name_length);
+}
+
+static joint_node_walk_action_t joint_dump_binary_enter(joint_node_t * node, const joint_node_children_t * relation, int depth, void * data) {
+    joint_dump_binary_state_t * state = data;
+
+    if (relation != NULL) {
+        joint_dump_binary_children_header(state->writer, relation);
+    }
+
+    joint_dump_binary_record_header(state->writer, state->subtree_lengths[state->current_node++], node->type, state->wide);
+    joint_dump_binary_position(state->writer, node->start_position, state->wide);
+    joint_dump_binary_position(state->writer, node->end_position, state->wide);
+    joint_writer_write_uint32(state->writer, (uint32_t) node->childrens_length);
+    joint_writer_write_uint32(state->writer, 0);
+
+    return JOINT_NODE_WALK_CONTINUE;
+}
+
+static joint_node_walk_action_t joint_dump_binary_scalar(joint_node_t * node, const joint_node_children_t * relation, int depth, void * data) {
+    joint_dump_binary_state_t * state = data;
+    size_t length;
+
+    joint_dump_binary_children_header(state->writer, relation);
+
+    switch (relation->type) {
+        case NUMBER_CHILDREN:
+            joint_writer_write_double(state->writer, (double) relation->number);
+            break;
+
+        case BOOLEAN_CHILDREN:
+            joint_writer_write_uint32(state->writer, relation->boolean);
+            joint_writer_write_uint32(state->writer, 0);
+            break;
+
+        case CHARACTER_CHILDREN:
+            joint_writer_write_uint32(state->writer, (unsigned char) relation->character);
+            joint_writer_write_uint32(state->writer, 0);
+            break;
+
+        case STRING_CHILDREN:
+            length = strlen(relation->string);
+            joint_writer_write_uint64(state->writer, length);
+            joint_dump_binary_string(state->writer, relation->string, length);
+            break;
+
+        default:
+            break;
+    }
+
+    return JOINT_NODE_WALK_CONTINUE;
+}
+
+void joint_dump_node(joint_writer_t * writer, joint_node_t * root, enum joint_dump_format format) {
+    joint_node_walker_t * walker = joint_node_walker_alloc();
+
+    switch (format) {
+        case TEXT_DUMP_FORMAT: {
+            joint_node_visitor_t visitor = {
+                .enter = joint_dump_text_enter,
+                .scalar = joint_dump_text_scalar,
+                .data = writer
+            };
+
+            joint_node_walker_walk(walker, root, &visitor);
+            break;
+        }
+
+        case JSON_DUMP_FORMAT: {
+            joint_dump_json_state_t state = {
+                .writer = writer,
+                .needs_comma = false
+            };
+
+            joint_node_visitor_t visitor = {
+                .enter = joint_dump_json_enter,
+                .scalar = joint_dump_json_scalar,
+                .leave = joint_dump_json_leave,
+                .data = &state
+            };
+
+            joint_node_walker_walk(walker, root, &visitor);
+            joint_writer_write_character(writer, '\n');
+            break;
+        }
+
+        case BINARY_DUMP_FORMAT: {
+            joint_dump_binary_state_t state = {
+                .writer = writer,
+                .wide = joint_dump_binary_is_wide(root->end_position),
+                .nodes_length = 0,
+                .nodes_capacity = 64,
+                .depths_capacity = 32,
+                .current_node = 0
+            };
+
+            state.subtree_lengths = malloc(sizeof(uint64_t) * state.nodes_capacity);
+            assert(state.subtree_lengths);
+            state.depths = malloc(sizeof(int) * state.depths_capacity);
+            assert(state.depths);
+
+            joint_node_visitor_t measure_visitor = {
+                .enter = joint_dump_binary_measure_enter,
+                .leave = joint_dump_binary_measure_leave,
+                .data = &state
+            };
+
+            joint_node_walker_walk(walker, root, &measure_visitor);
+
+            /* Trees of small sources can still outgrow 32-bit lengths. */
+            if (!state.wide && state.subtree_lengths[0] > UINT32_MAX) {
+                state.wide = true;
+                state.nodes_length = 0;
+                joint_node_walker_walk(walker, root, &measure_visitor);
+            }
+
+            joint_dump_binary_header(writer, AST_BINARY_KIND, root->start_position->path, state.subtree_lengths[0], state.wide);
+
+            joint_node_visitor_t visitor = {
+                .enter = joint_dump_binary_enter,
+                .scalar = joint_dump_binary_scalar,
+                .data = &state
+            };
+
+            joint_node_walker_walk(walker, root, &visitor);
+
+            free(state.depths);
+            free(state.subtree_lengths);
+            break;
+        }
+    }
+
+    joint_node_walker_free(walker);
+}
+
+typedef struct joint_dump_cursor {
+    const unsigned char * data;
+    size_t length;
+    size_t offset;
+    bool wide;
+    bool failed;
+} joint_dump_cursor_t;
+
+static const unsigned char * joint_dump_cursor_take(joint_dump_cursor_t * cursor, size_t length) {
+    if (cursor->failed || cursor->length - cursor->offset < length) {
+        cursor->failed = true;
+        return NULL;
+    }
+
+    const unsigned char * data = cursor->data + cursor->offset;
+    cursor->offset += length;
+    return data;
+}
+
+static uint32_t joint_dump_cursor_uint32(joint_dump_cursor_t * cursor) {
+    const unsigned char * bytes = joint_dump_cursor_take(cursor, 4);
+
+    if (bytes == NULL) {
+        return 0;
+    }
+
+    return (uint32_t) bytes[0] | ((uint32_t) bytes[1] << 8) | ((uint32_t) bytes[2] << 16) | ((uint32_t) bytes[3] << 24);
+}
+
+static uint64_t joint_dump_cursor_uint64(joint_dump_cursor_t * cursor) {
+    uint64_t low = joint_dump_cursor_uint32(cursor);
+    return low | ((uint64_t) joint_dump_cursor_uint32(cursor) << 32);
+}
+
+static const char * joint_dump_cursor_string(joint_dump_cursor_t * cursor, uint64_t length) {
+    if (length >= cursor->length) {
+        cursor->failed = true;
+        return NULL;
+    }
+
+    const char * string = (const char *) joint_dump_cursor_take(cursor, joint_dump_binary_string_size(length));
+
+    if (string == NULL || string[length] != '\0') {
+        cursor->failed = true;
+        return NULL;
+    }
+
+    return string;
+}
+
+static joint_source_file_position_t * joint_dump_cursor_position(joint_dump_cursor_t * cursor, joint_allocator_t * allocator, const char * path) {
+    joint_source_file_position_t * position = JOINT_ALLOCATE(allocator, sizeof(joint_source_file_position_t));
+    assert(position);
+
+    position->path = JOINT_ALLOCATE(allocator, sizeof(char) * (strlen(path) + 1));
+    assert(position->path);
+    strcpy(position->path, path);
+
+    if (cursor->wide) {
+        position->position = joint_dump_cursor_uint64(cursor);
+        position->line = joint_dump_cursor_uint64(cursor);
+        position->column = joint_dump_cursor_uint64(cursor);
+        position->code_point_column = joint_dump_cursor_uint64(cursor);
+    } else {
+        position->position = joint_dump_cursor_uint32(cursor);
+        position->line = joint_dump_cursor_uint32(cursor);
+        position->column = joint_dump_cursor_uint32(cursor);
+        position->code_point_column = joint_dump_cursor_uint32(cursor);
+    }
+
+    return position;
+}
+
+static bool joint_dump_cursor_header(joint_dump_cursor_t * cursor, enum joint_dump_binary_kind kind) {
+    const unsigned char * magic = joint_dump_cursor_take(cursor, 4);
+
+    if (magic == NULL || memcmp(magic, JOINT_DUMP_BINARY_MAGIC, 4) != 0) {
+        return false;
+    }
+
+    if (joint_dump_cursor_uint32(cursor) != JOINT_DUMP_BINARY_VERSION || joint_dump_cursor_uint32(cursor) != kind) {
+        return false;
+    }
+
+    cursor->wide = (joint_dump_cursor_uint32(cursor) & JOINT_DUMP_BINARY_WIDE) != 0;
+    uint64_t payload_length = joint_dump_cursor_uint64(cursor);
+
+    if (cursor->failed || payload_length > cursor->length - cursor->offset) {
+        return false;
+    }
+
+    cursor->length = cursor->offset + payload_length;
+
+    joint_dump_cursor_string(cursor, joint_dump_cursor_uint64(cursor));
+
+    return !cursor->failed;
+}
+
+static uint64_t joint_dump_cursor_record_header(joint_dump_cursor_t * cursor, uint32_t * type) {
+    if (cursor->wide) {
+        uint64_t length = joint_dump_cursor_uint64(cursor);
+        *type = joint_dump_cursor_uint32(cursor);
+        joint_dump_cursor_uint32(cursor);
+        return length;
+    }
+
+    uint64_t length = joint_dump_cursor_uint32(cursor);
+    *type = joint_dump_cursor_uint32(cursor);
+    return length;
+}
+
+bool joint_dump_load_tokens(const void * data, size_t length, joint_tokenizer_t * tokenizer, size_t * consumed) {
+    joint_dump_cursor_t cursor = {.data = data, .length = length, .offset = 0, .wide = false, .failed = false};
+
+    if (!joint_dump_cursor_header(&cursor, TOKENS_BINARY_KIND)) {
+        return false;
+    }
+
+    while (cursor.offset < cursor.length) {
+        size_t record_offset = cursor.offset;
+        uint32_t type;
+        uint64_t record_length = joint_dump_cursor_record_header(&cursor, &type);
+
+        if (cursor.failed || joint_tokenizer_token_type_name((int) type) == NULL) {
+            return false;
+        }
+
+        joint_token_t * token = JOINT_ALLOCATE(tokenizer->allocator, sizeof(joint_token_t));
+        assert(token);
+
+        token->type = type;
+        token->start_position = joint_dump_cursor_position(&cursor, tokenizer->allocator, tokenizer->source_file->path);
+        token->end_position = joint_dump_cursor_position(&cursor, tokenizer->allocator, tokenizer->source_file->path);
+        token->value = joint_string_alloc(tokenizer->allocator, 8);
+
+        const char * value = joint_dump_cursor_string(&cursor, joint_dump_cursor_uint64(&cursor));
+
+        if (value != NULL) {
+            joint_string_set_content(token->value, value);
+        }
+
+        tokenizer->tokens = JOINT_REALLOCATE(tokenizer->allocator, tokenizer->tokens, sizeof(joint_token_t *) * (tokenizer->tokens_length + 1));
+        assert(tokenizer->tokens);
+        tokenizer->tokens[tokenizer->tokens_length++] = token;
+
+        if (cursor.failed || cursor.offset - record_offset != record_length) {
+            return false;
+        }
+    }
+
+    if (tokenizer->tokens_length == 0 || tokenizer->tokens[tokenizer->tokens_length - 1]->type != EOF_TOKEN) {
+        return false;
+    }
+
+    *consumed = cursor.length;
+
+    return true;
+}
+
+static joint_node_t * joint_dump_cursor_node(joint_dump_cursor_t * cursor, joint_allocator_t * allocator, const char * path, uint32_t * childrens_length) {
+    uint32_t type;
+    joint_dump_cursor_record_header(cursor, &type);
+
+    if (cursor->failed || joint_node_type_name(type) == NULL) {
+        cursor->failed = true;
+        return NULL;
+    }
+
+    joint_node_t * node = JOINT_ALLOCATE(allocator, sizeof(joint_node_t));
+    assert(node);
+
+    node->allocator = allocator;
+    node->type = type;
+    node->childrens_length = 0;
+    node->childrens = NULL;
+    node->start_position = joint_dump_cursor_position(cursor, allocator, path);
+    node->end_position = joint_dump_cursor_position(cursor, allocator, path);
+
+    *childrens_length = joint_dump_cursor_uint32(cursor);
+    joint_dump_cursor_uint32(cursor);
+
+    return node;
+}
+
+joint_node_t * joint_dump_load_node(joint_allocator_t * allocator, const void * data, size_t length, const char * path, size_t * consumed) {
+    joint_dump_cursor_t cursor = {.data = data, .length = length, .offset = 0, .wide = false, .failed = false};
+
+    if (!joint_dump_cursor_header(&cursor, AST_BINARY_KIND)) {
+        return NULL;
+    }
+
+    int frames_length = 0;
+    int frames_capacity = 32;
+    struct {
+        joint_node_t * node;
+        uint32_t remaining;
+    } * frames = malloc(sizeof(*frames) * frames_capacity);
+    assert(frames);
+
+    uint32_t childrens_length;
+    joint_node_t * root = joint_dump_cursor_node(&cursor, allocator, path, &childrens_length);
+
+    if (root != NULL) {
+        frames[0].node = root;
+        frames[0].remaining = childrens_length;
+        frames_length = 1;
+    }
+
+    while (frames_length > 0 && !cursor.failed) {
+        if (frames[frames_length - 1].remaining == 0) {
+            frames_length--;
+            continue;
+        }
+
+        frames[frames_length - 1].remaining--;
+        joint_node_t * node = frames[frames_length - 1].node;
+
+        uint32_t type = joint_dump_cursor_uint32(&cursor);
+        uint32_t name_length = joint_dump_cursor_uint32(&cursor);
+        const char * stored_name = joint_dump_cursor_string(&cursor, name_length);
+        char * name = stored_name != NULL ? joint_node_children_name(stored_name) : NULL;
+        uint64_t bits;
+        double number;
+        const char * string;
+
+        if (name == NULL) {
+            cursor.failed = true;
+            break;
+        }
+
+        switch (type) {
+            case NODE_CHILDREN: {
+                joint_node_t * related = joint_dump_cursor_node(&cursor, allocator, path, &childrens_length);
+
+                if (related == NULL) {
+                    break;
+                }
+
+                joint_node_attach_node(node, name, related);
+
+                if (frames_length == frames_capacity) {
+                    frames_capacity *= 2;
+                    frames = realloc(frames, sizeof(*frames) * frames_capacity);
+                    assert(frames);
+                }
+
+                frames[frames_length].node = related;
+                frames[frames_length].remaining = childrens_length;
+                frames_length++;
+                break;
+            }
+
+            case NUMBER_CHILDREN:
+                bits = joint_dump_cursor_uint64(&cursor);
+                memcpy(&number, &bits, sizeof(number));
+                joint_node_attach_number(node, name, number);
+                break;
+
+            case BOOLEAN_CHILDREN:
+                joint_node_attach_boolean(node, name, joint_dump_cursor_uint32(&cursor) != 0);
+                joint_dump_cursor_uint32(&cursor);
+                break;
+
+            case CHARACTER_CHILDREN:
+                joint_node_attach_character(node, name, (char) joint_dump_cursor_uint32(&cursor));
+                joint_dump_cursor_uint32(&cursor);
+                break;
+
+            case STRING_CHILDREN:
+                string = joint_dump_cursor_string(&cursor, joint_dump_cursor_uint64(&cursor));
+
+                if (string != NULL) {
+                    joint_node_attach_string(node, name, string);
+                }
+                break;
+
+            case NULL_CHILDREN:
+                joint_node_attach_null(node, name);
+                break;
+
+            default:
+                cursor.failed = true;
+                break;
+        }
+    }
+
+    free(frames);
+
+    if (cursor.failed || cursor.offset != cursor.length) {
+        if (root != NULL) {
+            joint_node_free(root);
+        }
+
+        return NULL;
+    }
+
+    *consumed = cursor.length;
+
+    return root;
+}
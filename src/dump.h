@@ -0,0 +1,79 @@
+/* Copyright (c) 2014 Vyacheslav Slinko
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef joint_dump_h
+#define joint_dump_h
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "node.h"
+#include "tokenizer.h"
+#include "writer.h"
+
+/* The binary format is little-endian and keeps every record 8-byte aligned
+ * so that it can be read in place from a mapped file. A 24-byte header
+ * (magic, version, kind, flags, u64 payload length) is followed by the
+ * source path (u64 length, bytes) and the records.
+ *
+ * A position is u32 offset, line, column and column in code points. Record
+ * headers are u32 length and u32 type. Dumps of sources past 4 GiB set the
+ * WIDE flag, which makes positions four u64 and record headers u64 length,
+ * u32 type and u32 padding.
+ *
+ * Token record: record header, start and end positions, u64 value length,
+ * value bytes.
+ *
+ * Node record: record header with the subtree length, start and end
+ * positions, u32 childrens length, u32 padding, then every children as u32
+ * type, u32 name length, name bytes and the payload: a nested node record,
+ * f64 number, u32 boolean or character followed by u32 padding, u64 string
+ * length and bytes, or nothing for null. Strings and names are
+ * NUL-terminated and padded. */
+#define JOINT_DUMP_BINARY_MAGIC "JNTB"
+#define JOINT_DUMP_BINARY_VERSION 3
+#define JOINT_DUMP_BINARY_HEADER_SIZE 24
+#define JOINT_DUMP_BINARY_ALIGNMENT 8
+#define JOINT_DUMP_BINARY_WIDE 1
+#define JOINT_DUMP_BINARY_RECORD_SIZE 48
+#define JOINT_DUMP_BINARY_WIDE_RECORD_SIZE 88
+
+enum joint_dump_format {
+    TEXT_DUMP_FORMAT,
+    JSON_DUMP_FORMAT,
+    BINARY_DUMP_FORMAT
+};
+
+enum joint_dump_binary_kind {
+    TOKENS_BINARY_KIND = 1,
+    AST_BINARY_KIND = 2
+};
+
+bool joint_dump_parse_format(const char * name, enum joint_dump_format * format);
+
+void joint_dump_tokens(joint_writer_t * writer, const joint_tokenizer_t * tokenizer, enum joint_dump_format format);
+
+void joint_dump_node(joint_writer_t * writer, joint_node_t * root, enum joint_dump_format format);
+
+bool joint_dump_load_tokens(const void * data, size_t length, joint_tokenizer_t * tokenizer, size_t * consumed);
+
+joint_node_t * joint_dump_load_node(joint_allocator_t * allocator, const void * data, size_t length, const char * path, size_t * consumed);
+
+#endif
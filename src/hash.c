@@ -0,0 +1,120 @@
+/* Copyright (c) 2014 Vyacheslav Slinko
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <string.h>
+#include "hash.h"
+
+/* XXH64 by Yann Collet, see https://github.com/Cyan4973/xxHash */
+
+static const uint64_t joint_hash_prime1 = 0x9E3779B185EBCA87ULL;
+static const uint64_t joint_hash_prime2 = 0xC2B2AE3D27D4EB4FULL;
+static const uint64_t joint_hash_prime3 = 0x165667B19E3779F9ULL;
+static const uint64_t joint_hash_prime4 = 0x85EBCA77C2B2AE63ULL;
+static const uint64_t joint_hash_prime5 = 0x27D4EB2F165667C5ULL;
+
+static inline uint64_t joint_hash_rotate(uint64_t value, int bits) {
+    return (value << bits) | (value >> (64 - bits));
+}
+
+static inline uint64_t joint_hash_read64(const unsigned char * data) {
+    uint64_t value;
+    memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+static inline uint32_t joint_hash_read32(const unsigned char * data) {
+    uint32_t value;
+    memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+static inline uint64_t joint_hash_round(uint64_t accumulator, uint64_t input) {
+    accumulator += input * joint_hash_prime2;
+    accumulator = joint_hash_rotate(accumulator, 31);
+    return accumulator * joint_hash_prime1;
+}
+
+static inline uint64_t joint_hash_merge_round(uint64_t accumulator, uint64_t value) {
+    accumulator ^= joint_hash_round(0, value);
+    return accumulator * joint_hash_prime1 + joint_hash_prime4;
+}
+
+uint64_t joint_hash_bytes(const void * data, size_t length, uint64_t seed) {
+    const unsigned char * current = data;
+    const unsigned char * end = current + length;
+    uint64_t hash;
+
+    if (length >= 32) {
+        const unsigned char * limit = end - 32;
+        uint64_t v1 = seed + joint_hash_prime1 + joint_hash_prime2;
+        uint64_t v2 = seed + joint_hash_prime2;
+        uint64_t v3 = seed;
+        uint64_t v4 = seed - joint_hash_prime1;
+
+        do {
+            v1 = joint_hash_round(v1, joint_hash_read64(current));
+            v2 = joint_hash_round(v2, joint_hash_read64(current + 8));
+            v3 = joint_hash_round(v3, joint_hash_read64(current + 16));
+            v4 = joint_hash_round(v4, joint_hash_read64(current + 24));
+            current += 32;
+        } while (current <= limit);
+
+        hash = joint_hash_rotate(v1, 1) + joint_hash_rotate(v2, 7) + joint_hash_rotate(v3, 12) + joint_hash_rotate(v4, 18);
+        hash = joint_hash_merge_round(hash, v1);
+        hash = joint_hash_merge_round(hash, v2);
+        hash = joint_hash_merge_round(hash, v3);
+        hash = joint_hash_merge_round(hash, v4);
+    } else {
+        hash = seed + joint_hash_prime5;
+    }
+
+    hash += (uint64_t) length;
+
+    while (current + 8 <= end) {
+        hash ^= joint_hash_round(0, joint_hash_read64(current));
+        hash = joint_hash_rotate(hash, 27) * joint_hash_prime1 + joint_hash_prime4;
+        current += 8;
+    }
+
+    if (current + 4 <= end) {
+        hash ^= (uint64_t) joint_hash_read32(current) * joint_hash_prime1;
+        hash = joint_hash_rotate(hash, 23) * joint_hash_prime2 + joint_hash_prime3;
+        current += 4;
+    }
+
+    while (current < end) {
+        hash ^= (*current) * joint_hash_prime5;
+        hash = joint_hash_rotate(hash, 11) * joint_hash_prime1;
+        current++;
+    }
+
+    hash ^= hash >> 33;
+    hash *= joint_hash_prime2;
+    hash ^= hash >> 29;
+    hash *= joint_hash_prime3;
+    hash ^= hash >> 32;
+
+    return hash;
+}
+
+uint64_t joint_hash_string(const char * string, uint64_t seed) {
+    return joint_hash_bytes(string, strlen(string), seed);
+}
@@ -19,23 +19,14 @@
  * THE SOFTWARE.
  */
 
-#ifndef joint_string_h
-#define joint_string_h
+#ifndef joint_hash_h
+#define joint_hash_h
 
-typedef struct joint_string {
-    size_t block_size;
-    int length;
-    char * data;
-} joint_string_t;
+#include <stddef.h>
+#include <stdint.h>
 
-joint_string_t * joint_string_alloc(size_t block_size);
+uint64_t joint_hash_bytes(const void * data, size_t length, uint64_t seed);
 
-void joint_string_set_content(joint_string_t * string, const char * content);
-
-void joint_string_append_character(joint_string_t * string, char character);
-
-void joint_string_print(const joint_string_t * string);
-
-void joint_string_free(joint_string_t * string);
+uint64_t joint_hash_string(const char * string, uint64_t seed);
 
 #endif
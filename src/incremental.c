@@ -0,0 +1,515 @@
+/* Copyright (c) 2014 Vyacheslav Slinko
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <assert.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include "incremental.h"
+#include "utf8.h"
+
+/* Tokens the parser may read past the one it stands on before it has to
+ * check that they were moved. */
+#define JOINT_INCREMENTAL_LOOKAHEAD 256
+
+/* What an edit does to the positions after it. Deltas are added with
+ * wrap-around to the unsigned positions, the column deltas only apply on
+ * line, numbered as before the edit. */
+typedef struct joint_incremental_shift {
+    joint_incremental_offset_t offset;
+    size_t line;
+    int64_t column_delta;
+    int64_t code_point_column_delta;
+} joint_incremental_shift_t;
+
+typedef struct joint_incremental_columns {
+    const joint_incremental_shift_t * shift;
+    int64_t line_delta;
+} joint_incremental_columns_t;
+
+static void joint_incremental_move(joint_source_file_position_t * position, const joint_incremental_offset_t * offset) {
+    position->position += (size_t) offset->delta;
+    position->line += (size_t) offset->line_delta;
+}
+
+/* owed_line_delta is the part of the offset the position still owes. */
+static void joint_incremental_move_columns(joint_source_file_position_t * position, int64_t owed_line_delta, const joint_incremental_shift_t * shift) {
+    if (position->line + (size_t) owed_line_delta == shift->line) {
+        position->column += (size_t) shift->column_delta;
+        position->code_point_column += (size_t) shift->code_point_column_delta;
+    }
+}
+
+static joint_source_file_position_t joint_incremental_moved(const joint_source_file_position_t * position, bool owed, const joint_incremental_offset_t * offset) {
+    joint_source_file_position_t moved = *position;
+
+    if (owed) {
+        joint_incremental_move(&moved, offset);
+    }
+
+    return moved;
+}
+
+static joint_source_file_position_t joint_incremental_token_start(const joint_incremental_t * incremental, size_t index) {
+    return joint_incremental_moved(incremental->parser->tokenizer->tokens[index]->start_position, index >= incremental->tokens_from, &incremental->tokens_offset);
+}
+
+static joint_source_file_position_t joint_incremental_token_end(const joint_incremental_t * incremental, size_t index) {
+    return joint_incremental_moved(incremental->parser->tokenizer->tokens[index]->end_position, index >= incremental->tokens_from, &incremental->tokens_offset);
+}
+
+static joint_source_file_position_t joint_incremental_element_start(const joint_incremental_t * incremental, int index) {
+    return joint_incremental_moved(incremental->parser->program->childrens[index]->node->start_position, index >= incremental->elements_from, &incremental->elements_offset);
+}
+
+static joint_source_file_position_t joint_incremental_element_end(const joint_incremental_t * incremental, int index) {
+    return joint_incremental_moved(incremental->parser->program->childrens[index]->node->end_position, index >= incremental->elements_from, &incremental->elements_offset);
+}
+
+static joint_node_walk_action_t joint_incremental_move_enter(joint_node_t * node, const joint_node_children_t * relation, int depth, void * data) {
+    joint_incremental_move(node->start_position, data);
+    joint_incremental_move(node->end_position, data);
+    return JOINT_NODE_WALK_CONTINUE;
+}
+
+static joint_node_walk_action_t joint_incremental_move_columns_enter(joint_node_t * node, const joint_node_children_t * relation, int depth, void * data) {
+    const joint_incremental_columns_t * columns = data;
+    joint_incremental_move_columns(node->start_position, columns->line_delta, columns->shift);
+    joint_incremental_move_columns(node->end_position, columns->line_delta, columns->shift);
+    return JOINT_NODE_WALK_CONTINUE;
+}
+
+typedef void (* joint_incremental_move_t)(joint_incremental_t * incremental, size_t index, const joint_incremental_offset_t * offset);
+
+static void joint_incremental_move_token(joint_incremental_t * incremental, size_t index, const joint_incremental_offset_t * offset) {
+    joint_incremental_move(incremental->parser->tokenizer->tokens[index]->start_position, offset);
+    joint_incremental_move(incremental->parser->tokenizer->tokens[index]->end_position, offset);
+}
+
+static void joint_incremental_move_element(joint_incremental_t * incremental, size_t index, const joint_incremental_offset_t * offset) {
+    joint_node_visitor_t visitor = {.enter = joint_incremental_move_enter, .scalar = NULL, .leave = NULL, .data = (void *) offset};
+    joint_node_walker_walk(incremental->walker, incremental->parser->program->childrens[index]->node, &visitor);
+}
+
+/* Moves the tokens before end that still owe the offset. */
+static void joint_incremental_flush_tokens(joint_incremental_t * incremental, size_t end) {
+    if (end > incremental->parser->tokenizer->tokens_length) {
+        end = incremental->parser->tokenizer->tokens_length;
+    }
+
+    for (size_t i = incremental->tokens_from; i < end; i++) {
+        joint_incremental_move_token(incremental, i, &incremental->tokens_offset);
+    }
+
+    if (end > incremental->tokens_from) {
+        incremental->tokens_from = end;
+    }
+}
+
+static void joint_incremental_flush_elements(joint_incremental_t * incremental, int end) {
+    if (end > incremental->parser->program->childrens_length) {
+        end = incremental->parser->program->childrens_length;
+    }
+
+    for (int i = incremental->elements_from; i < end; i++) {
+        joint_incremental_move_element(incremental, (size_t) i, &incremental->elements_offset);
+    }
+
+    if (end > incremental->elements_from) {
+        incremental->elements_from = end;
+    }
+}
+
+/* Returns the offset owed from index on once shift is added to the offset
+ * owed from from on. What lies between index and from did not owe the old
+ * offset, so it is moved back by it. */
+static joint_incremental_offset_t joint_incremental_defer(joint_incremental_t * incremental, joint_incremental_move_t move, size_t index, size_t from, size_t length, joint_incremental_offset_t offset, const joint_incremental_offset_t * shift) {
+    if (from >= length) {
+        return *shift;
+    }
+
+    joint_incremental_offset_t back = {.delta = -offset.delta, .line_delta = -offset.line_delta};
+
+    for (size_t i = index; i < from; i++) {
+        move(incremental, i, &back);
+    }
+
+    offset.delta += shift->delta;
+    offset.line_delta += shift->line_delta;
+
+    return offset;
+}
+
+static size_t joint_incremental_find_damaged_token(const joint_incremental_t * incremental, size_t offset) {
+    size_t low = 0;
+    size_t high = incremental->parser->tokenizer->tokens_length - 1;
+
+    while (low < high) {
+        size_t middle = low + (high - low) / 2;
+
+        if (joint_incremental_token_end(incremental, middle).position >= offset) {
+            high = middle;
+        } else {
+            low = middle + 1;
+        }
+    }
+
+    return low;
+}
+
+static int joint_incremental_find_affected_element(const joint_incremental_t * incremental, size_t position) {
+    int low = 0;
+    int high = incremental->parser->program->childrens_length;
+
+    while (low < high) {
+        int middle = low + (high - low) / 2;
+
+        if (joint_incremental_element_end(incremental, middle).position <= position) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+
+    return low;
+}
+
+/* Appends the elements after the end of the program up to the end of the
+ * source, or up to a syntax error. */
+static void joint_incremental_parse_rest(joint_incremental_t * incremental) {
+    joint_parser_t * parser = incremental->parser;
+    joint_node_t * program = parser->program;
+    size_t token = 0;
+
+    joint_incremental_flush(incremental);
+
+    if (program->childrens_length > 0) {
+        size_t end = program->childrens[program->childrens_length - 1]->node->end_position->position;
+        size_t high = parser->tokenizer->tokens_length - 1;
+
+        while (token < high) {
+            size_t middle = token + (high - token) / 2;
+
+            if (parser->tokenizer->tokens[middle]->start_position->position >= end) {
+                high = middle;
+            } else {
+                token = middle + 1;
+            }
+        }
+    }
+
+    int parsed_length = 0;
+    int parsed_capacity = 8;
+    joint_node_t ** parsed = malloc(sizeof(joint_node_t *) * parsed_capacity);
+    assert(parsed);
+
+    joint_parser_seek(parser, token);
+
+    while (parser->next_token->type != EOF_TOKEN) {
+        joint_node_t * element = joint_parser_parse_element(parser);
+
+        if (element == NULL) {
+            break;
+        }
+
+        if (parsed_length == parsed_capacity) {
+            parsed_capacity *= 2;
+            parsed = realloc(parsed, sizeof(joint_node_t *) * parsed_capacity);
+            assert(parsed);
+        }
+
+        parsed[parsed_length++] = element;
+    }
+
+    if (parsed_length > 0) {
+        joint_node_splice_nodes(program, program->childrens_length, 0, "body", parsed, parsed_length);
+    }
+
+    incremental->elements_from = program->childrens_length;
+    free(parsed);
+}
+
+static void joint_incremental_replace_position(joint_allocator_t * allocator, joint_source_file_position_t ** position, const joint_source_file_position_t * source) {
+    joint_node_free_position(allocator, *position);
+    *position = joint_node_clone_position(allocator, source);
+}
+
+joint_incremental_t * joint_incremental_alloc(joint_parser_t * parser) {
+    joint_incremental_t * incremental = malloc(sizeof(joint_incremental_t));
+    assert(incremental);
+
+    incremental->parser = parser;
+    incremental->walker = joint_node_walker_alloc();
+
+    incremental->tokens_from = parser->tokenizer->tokens_length;
+    incremental->tokens_offset = (joint_incremental_offset_t) {.delta = 0, .line_delta = 0};
+
+    incremental->elements_from = parser->program->childrens_length;
+    incremental->elements_offset = (joint_incremental_offset_t) {.delta = 0, .line_delta = 0};
+
+    incremental->truncated = false;
+
+    return incremental;
+}
+
+bool joint_incremental_apply(joint_incremental_t * incremental, const joint_incremental_edit_t * edit, joint_incremental_result_t * result) {
+    joint_parser_t * parser = incremental->parser;
+    joint_tokenizer_t * tokenizer = parser->tokenizer;
+    size_t old_tokens_length = tokenizer->tokens_length;
+    size_t edit_end = edit->offset + edit->removed_length;
+    int64_t delta = (int64_t) edit->inserted_length - (int64_t) edit->removed_length;
+
+    size_t first_damaged = joint_incremental_find_damaged_token(incremental, edit->offset);
+    joint_incremental_flush_tokens(incremental, first_damaged);
+
+    joint_source_file_position_t restart = {.path = NULL, .position = 0, .line = 0, .column = 0, .code_point_column = 0};
+
+    if (first_damaged > 0) {
+        restart = *tokenizer->tokens[first_damaged - 1]->end_position;
+    }
+
+    joint_string_splice(tokenizer->source_file->content, edit->offset, edit->removed_length, edit->inserted, edit->inserted_length);
+    tokenizer->source_file->ascii = tokenizer->source_file->ascii && joint_utf8_is_ascii(edit->inserted, edit->inserted_length);
+
+    tokenizer->current_position = restart.position;
+    tokenizer->current_line_number = restart.line;
+    tokenizer->current_line_start_position = restart.position - restart.column;
+
+    size_t relexed_length = 0;
+    size_t relexed_capacity = 16;
+    joint_token_t ** relexed = malloc(sizeof(joint_token_t *) * relexed_capacity);
+    assert(relexed);
+
+    size_t resync = first_damaged;
+    joint_incremental_shift_t shift = {.offset = {.delta = delta, .line_delta = 0}, .line = SIZE_MAX, .column_delta = 0, .code_point_column_delta = 0};
+
+    while (true) {
+        joint_token_t * token = joint_tokenizer_next_token(tokenizer);
+        size_t start = token->start_position->position;
+
+        if (start >= edit->offset + edit->inserted_length) {
+            size_t old_start = start - edit->inserted_length + edit->removed_length;
+
+            while (resync < old_tokens_length && joint_incremental_token_start(incremental, resync).position < old_start) {
+                resync++;
+            }
+
+            joint_source_file_position_t old_position;
+
+            if (resync < old_tokens_length && (old_position = joint_incremental_token_start(incremental, resync)).position == old_start && old_start >= edit_end) {
+                shift.line = old_position.line;
+                shift.offset.line_delta = (int64_t) token->start_position->line - (int64_t) old_position.line;
+                shift.column_delta = (int64_t) token->start_position->column - (int64_t) old_position.column;
+                shift.code_point_column_delta = (int64_t) token->start_position->code_point_column - (int64_t) old_position.code_point_column;
+                joint_token_free(tokenizer, token);
+                break;
+            }
+        }
+
+        if (relexed_length == relexed_capacity) {
+            relexed_capacity *= 2;
+            relexed = realloc(relexed, sizeof(joint_token_t *) * relexed_capacity);
+            assert(relexed);
+        }
+
+        relexed[relexed_length++] = token;
+
+        if (token->type == EOF_TOKEN) {
+            resync = old_tokens_length;
+            break;
+        }
+    }
+
+    /* Only the tokens left on the line of the edit move sideways, the
+     * others just take the offset. */
+    for (size_t i = resync; i < old_tokens_length; i++) {
+        joint_token_t * token = tokenizer->tokens[i];
+        int64_t owed_line_delta = i >= incremental->tokens_from ? incremental->tokens_offset.line_delta : 0;
+
+        if (token->start_position->line + (size_t) owed_line_delta != shift.line) {
+            break;
+        }
+
+        joint_incremental_move_columns(token->start_position, owed_line_delta, &shift);
+        joint_incremental_move_columns(token->end_position, owed_line_delta, &shift);
+    }
+
+    incremental->tokens_offset = joint_incremental_defer(incremental, joint_incremental_move_token, resync, incremental->tokens_from, old_tokens_length, incremental->tokens_offset, &shift.offset);
+    incremental->tokens_from = resync;
+
+    for (size_t i = first_damaged; i < resync; i++) {
+        joint_token_free(tokenizer, tokenizer->tokens[i]);
+    }
+
+    size_t removed_tokens = resync - first_damaged;
+    size_t tokens_length = old_tokens_length - removed_tokens + relexed_length;
+
+    if (relexed_length > removed_tokens) {
+        tokenizer->tokens = JOINT_REALLOCATE(tokenizer->allocator, tokenizer->tokens, sizeof(joint_token_t *) * tokens_length);
+        assert(tokenizer->tokens);
+    }
+
+    joint_token_t ** tokens = tokenizer->tokens;
+    memmove(tokens + first_damaged + relexed_length, tokens + resync, sizeof(joint_token_t *) * (old_tokens_length - resync));
+    memcpy(tokens + first_damaged, relexed, sizeof(joint_token_t *) * relexed_length);
+    free(relexed);
+
+    tokenizer->tokens_length = tokens_length;
+    incremental->tokens_from = incremental->tokens_from - removed_tokens + relexed_length;
+
+    result->relexed_tokens = relexed_length;
+    result->removed_tokens = removed_tokens;
+
+    joint_node_t * program = parser->program;
+    int elements_length = program->childrens_length;
+    int first_affected = joint_incremental_find_affected_element(incremental, restart.position);
+    joint_incremental_flush_elements(incremental, first_affected);
+
+    size_t reparse_start = first_damaged;
+
+    if (first_affected < elements_length && joint_incremental_element_start(incremental, first_affected).position < restart.position) {
+        size_t element_start = joint_incremental_element_start(incremental, first_affected).position;
+
+        while (joint_incremental_token_start(incremental, reparse_start).position > element_start) {
+            reparse_start--;
+        }
+    } else {
+        size_t covered = first_affected > 0 ? joint_incremental_element_end(incremental, first_affected - 1).position : 0;
+
+        while (reparse_start > 0 && joint_incremental_token_start(incremental, reparse_start - 1).position >= covered) {
+            reparse_start--;
+        }
+    }
+
+    int reparsed_length = 0;
+    int reparsed_capacity = 8;
+    joint_node_t ** reparsed = malloc(sizeof(joint_node_t *) * reparsed_capacity);
+    assert(reparsed);
+
+    int reused = first_affected;
+    size_t unchanged_tokens = first_damaged + relexed_length;
+
+    parser->error = NULL;
+    parser->error_token = NULL;
+    joint_parser_seek(parser, reparse_start);
+
+    while (true) {
+        joint_incremental_flush_tokens(incremental, parser->current_token + JOINT_INCREMENTAL_LOOKAHEAD);
+
+        if (parser->next_token->type == EOF_TOKEN) {
+            break;
+        }
+
+        if (parser->current_token >= unchanged_tokens) {
+            size_t start = parser->next_token->start_position->position;
+
+            while (reused < elements_length && (joint_incremental_element_start(incremental, reused).position < edit_end || joint_incremental_element_start(incremental, reused).position + (size_t) delta < start)) {
+                reused++;
+            }
+
+            if (reused < elements_length && joint_incremental_element_start(incremental, reused).position + (size_t) delta == start) {
+                break;
+            }
+        }
+
+        if (reparsed_length == reparsed_capacity) {
+            reparsed_capacity *= 2;
+            reparsed = realloc(reparsed, sizeof(joint_node_t *) * reparsed_capacity);
+            assert(reparsed);
+        }
+
+        size_t element_token = parser->current_token;
+        joint_node_t * element = joint_parser_parse_element(parser);
+
+        /* The element ran into tokens that were not moved yet, so it is
+         * parsed again once they all are. */
+        if (parser->current_token >= incremental->tokens_from) {
+            if (element != NULL) {
+                joint_node_free(element);
+            }
+
+            joint_incremental_flush_tokens(incremental, SIZE_MAX);
+            joint_parser_seek(parser, element_token);
+            element = joint_parser_parse_element(parser);
+        }
+
+        if (element == NULL) {
+            break;
+        }
+
+        reparsed[reparsed_length++] = element;
+    }
+
+    bool resynced = parser->next_token->type != EOF_TOKEN && parser->error == NULL;
+
+    if (!resynced) {
+        reused = elements_length;
+    }
+
+    joint_incremental_columns_t columns = {.shift = &shift};
+    joint_node_visitor_t columns_visitor = {.enter = joint_incremental_move_columns_enter, .scalar = NULL, .leave = NULL, .data = &columns};
+
+    for (int i = reused; i < elements_length; i++) {
+        columns.line_delta = i >= incremental->elements_from ? incremental->elements_offset.line_delta : 0;
+
+        if (program->childrens[i]->node->start_position->line + (size_t) columns.line_delta != shift.line) {
+            break;
+        }
+
+        joint_node_walker_walk(incremental->walker, program->childrens[i]->node, &columns_visitor);
+    }
+
+    incremental->elements_offset = joint_incremental_defer(incremental, joint_incremental_move_element, (size_t) reused, (size_t) incremental->elements_from, (size_t) elements_length, incremental->elements_offset, &shift.offset);
+    incremental->elements_from = first_affected + reparsed_length;
+
+    result->reparsed_elements = reparsed_length;
+    result->removed_elements = reused - first_affected;
+
+    if (reused > first_affected || reparsed_length > 0) {
+        joint_node_splice_nodes(program, first_affected, reused - first_affected, "body", reparsed, reparsed_length);
+    }
+
+    free(reparsed);
+
+    if (resynced && incremental->truncated) {
+        joint_incremental_parse_rest(incremental);
+    }
+
+    incremental->truncated = parser->error != NULL;
+
+    joint_source_file_position_t start_position = joint_incremental_token_start(incremental, 0);
+    joint_source_file_position_t end_position = program->childrens_length > 0 ? joint_incremental_element_end(incremental, program->childrens_length - 1) : joint_incremental_token_end(incremental, tokens_length - 1);
+
+    joint_incremental_replace_position(program->allocator, &program->start_position, &start_position);
+    joint_incremental_replace_position(program->allocator, &program->end_position, &end_position);
+
+    return parser->error == NULL;
+}
+
+void joint_incremental_flush(joint_incremental_t * incremental) {
+    joint_incremental_flush_tokens(incremental, SIZE_MAX);
+    joint_incremental_flush_elements(incremental, INT_MAX);
+}
+
+void joint_incremental_free(joint_incremental_t * incremental) {
+    joint_node_walker_free(incremental->walker);
+    free(incremental);
+}
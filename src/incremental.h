@@ -0,0 +1,90 @@
+/* Copyright (c) 2014 Vyacheslav Slinko
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef joint_incremental_h
+#define joint_incremental_h
+
+#include <stdint.h>
+#include "parser.h"
+
+typedef struct joint_incremental_edit {
+    size_t offset;
+    size_t removed_length;
+    const char * inserted;
+    size_t inserted_length;
+} joint_incremental_edit_t;
+
+typedef struct joint_incremental_result {
+    size_t relexed_tokens;
+    size_t removed_tokens;
+    int reparsed_elements;
+    int removed_elements;
+} joint_incremental_result_t;
+
+/* Moves positions by delta bytes and line_delta lines. */
+typedef struct joint_incremental_offset {
+    int64_t delta;
+    int64_t line_delta;
+} joint_incremental_offset_t;
+
+/* A parsed buffer that is edited in place. Tokens from tokens_from on and
+ * program elements from elements_from on have not been moved by their
+ * offset yet. */
+typedef struct joint_incremental {
+    joint_parser_t * parser;
+    joint_node_walker_t * walker;
+
+    size_t tokens_from;
+    joint_incremental_offset_t tokens_offset;
+
+    int elements_from;
+    joint_incremental_offset_t elements_offset;
+
+    /* The last edit ended in a syntax error and the program stops there. */
+    bool truncated;
+} joint_incremental_t;
+
+/* parser must hold a successfully parsed program, it stays owned by the
+ * caller. */
+joint_incremental_t * joint_incremental_alloc(joint_parser_t * parser);
+
+/* Applies an edit to the source of a parsed buffer, re-lexing and
+ * reparsing only around it. This is a library API for tools that keep a
+ * buffer open, such as editors; the server and watch mode reparse whole
+ * files.
+ *
+ * Tokens and nodes after the edit are not moved right away, they take the
+ * offset of the edit on top of the one they still owe. Only the ones between
+ * this edit and the previous one are touched, so an edit costs time
+ * proportional to that distance and to the edit, plus moving the token and
+ * source arrays in memory. Call joint_incremental_flush before reading
+ * positions from the tokenizer or the program.
+ *
+ * After a syntax error the program keeps the elements before it and false
+ * is returned. The next edit parses the source after the program again. */
+bool joint_incremental_apply(joint_incremental_t * incremental, const joint_incremental_edit_t * edit, joint_incremental_result_t * result);
+
+/* Moves every token and node that still owes an offset. */
+void joint_incremental_flush(joint_incremental_t * incremental);
+
+void joint_incremental_free(joint_incremental_t * incremental);
+
+#endif
@@ -0,0 +1,397 @@
+/* Copyright (c) 2014 Vyacheslav Slinko
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <assert.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "hash.h"
+#include "interface.h"
+#include "parser.h"
+#include "source_file.h"
+#include "tokenizer.h"
+
+#define JOINT_INTERFACE_MAGIC "JNTI"
+#define JOINT_INTERFACE_VERSION 1
+#define JOINT_INTERFACE_HEADER_SIZE 24
+#define JOINT_INTERFACE_SLOT_SIZE 16
+#define JOINT_INTERFACE_EMPTY_SLOT 0xFFFFFFFF
+
+static void joint_interface_put_uint16(unsigned char * bytes, uint16_t value) {
+    bytes[0] = value;
+    bytes[1] = value >> 8;
+}
+
+static void joint_interface_put_uint32(unsigned char * bytes, uint32_t value) {
+    joint_interface_put_uint16(bytes, (uint16_t) value);
+    joint_interface_put_uint16(bytes + 2, (uint16_t) (value >> 16));
+}
+
+static void joint_interface_put_uint64(unsigned char * bytes, uint64_t value) {
+    joint_interface_put_uint32(bytes, (uint32_t) value);
+    joint_interface_put_uint32(bytes + 4, (uint32_t) (value >> 32));
+}
+
+static uint16_t joint_interface_get_uint16(const unsigned char * bytes) {
+    return (uint16_t) (bytes[0] | (bytes[1] << 8));
+}
+
+static uint32_t joint_interface_get_uint32(const unsigned char * bytes) {
+    return (uint32_t) joint_interface_get_uint16(bytes) | ((uint32_t) joint_interface_get_uint16(bytes + 2) << 16);
+}
+
+static uint64_t joint_interface_get_uint64(const unsigned char * bytes) {
+    return (uint64_t) joint_interface_get_uint32(bytes) | ((uint64_t) joint_interface_get_uint32(bytes + 4) << 32);
+}
+
+char * joint_interface_path(const char * source_path) {
+    size_t length = strlen(source_path);
+
+    if (length >= 6 && strcmp(source_path + length - 6, ".joint") == 0) {
+        length -= 6;
+    }
+
+    char * path = malloc(sizeof(char) * (length + 8));
+    assert(path);
+    memcpy(path, source_path, length);
+    strcpy(path + length, ".jointi");
+
+    return path;
+}
+
+static const joint_node_children_t * joint_interface_children(const joint_node_t * node, const char * name) {
+    for (int i = 0; i < node->childrens_length; i++) {
+        if (strcmp(node->childrens[i]->name, name) == 0) {
+            return node->childrens[i];
+        }
+    }
+
+    return NULL;
+}
+
+static unsigned char * joint_interface_slot(unsigned char * data, uint32_t slots_length, const char * name, size_t name_length, uint64_t hash, size_t strings_offset) {
+    uint32_t slot = (uint32_t) hash & (slots_length - 1);
+
+    while (true) {
+        unsigned char * bytes = data + JOINT_INTERFACE_HEADER_SIZE + (size_t) slot * JOINT_INTERFACE_SLOT_SIZE;
+        uint32_t offset = joint_interface_get_uint32(bytes + 8);
+
+        if (offset == JOINT_INTERFACE_EMPTY_SLOT) {
+            return bytes;
+        }
+
+        if (joint_interface_get_uint64(bytes) == hash && joint_interface_get_uint16(bytes + 12) == name_length && memcmp(data + strings_offset + offset, name, name_length) == 0) {
+            return bytes;
+        }
+
+        slot = (slot + 1) & (slots_length - 1);
+    }
+}
+
+/* Builds the interface image in memory, exports that are declared twice
+ * keep the type of the last declaration. */
+static unsigned char * joint_interface_build(const joint_node_t * program, uint64_t source_hash, size_t * size) {
+    uint32_t declarations_length = 0;
+    size_t strings_size = 0;
+
+    for (int i = 0; i < program->childrens_length; i++) {
+        const joint_node_t * element = program->childrens[i]->node;
+
+        if (element->type == VARIABLE_DECLARATION_NODE) {
+            declarations_length++;
+            strings_size += strlen(joint_interface_children(element, "id")->node->childrens[0]->string);
+        }
+    }
+
+    uint32_t slots_length = 8;
+
+    while (slots_length < declarations_length * 2) {
+        slots_length *= 2;
+    }
+
+    size_t strings_offset = JOINT_INTERFACE_HEADER_SIZE + (size_t) slots_length * JOINT_INTERFACE_SLOT_SIZE;
+    unsigned char * data = malloc(strings_offset + strings_size);
+    assert(data);
+
+    memcpy(data, JOINT_INTERFACE_MAGIC, 4);
+    joint_interface_put_uint32(data + 4, JOINT_INTERFACE_VERSION);
+    joint_interface_put_uint64(data + 8, source_hash);
+    joint_interface_put_uint32(data + 20, slots_length);
+    memset(data + JOINT_INTERFACE_HEADER_SIZE, 0xFF, (size_t) slots_length * JOINT_INTERFACE_SLOT_SIZE);
+
+    uint32_t exports_length = 0;
+    size_t strings_length = 0;
+
+    for (int i = 0; i < program->childrens_length; i++) {
+        const joint_node_t * element = program->childrens[i]->node;
+
+        if (element->type != VARIABLE_DECLARATION_NODE) {
+            continue;
+        }
+
+        const char * name = joint_interface_children(element, "id")->node->childrens[0]->string;
+        const char * annotation = joint_interface_children(element, "type")->node->childrens[0]->string;
+        const joint_node_children_t * optional = joint_interface_children(element, "optional");
+        size_t name_length = strlen(name);
+        uint64_t hash = joint_hash_bytes(name, name_length, 0);
+        joint_type_t type = joint_type_from_name(annotation);
+
+        if (type != ERROR_TYPE && optional != NULL && optional->boolean) {
+            type |= JOINT_TYPE_OPTIONAL;
+        }
+
+        if (name_length > UINT16_MAX) {
+            continue;
+        }
+
+        unsigned char * slot = joint_interface_slot(data, slots_length, name, name_length, hash, strings_offset);
+
+        if (joint_interface_get_uint32(slot + 8) == JOINT_INTERFACE_EMPTY_SLOT) {
+            memcpy(data + strings_offset + strings_length, name, name_length);
+            joint_interface_put_uint64(slot, hash);
+            joint_interface_put_uint32(slot + 8, (uint32_t) strings_length);
+            joint_interface_put_uint16(slot + 12, (uint16_t) name_length);
+            strings_length += name_length;
+            exports_length++;
+        }
+
+        slot[14] = type;
+        slot[15] = 0;
+    }
+
+    joint_interface_put_uint32(data + 16, exports_length);
+    *size = strings_offset + strings_length;
+
+    return data;
+}
+
+static bool joint_interface_store(const char * path, const unsigned char * data, size_t size) {
+    char * temporary_path = malloc(sizeof(char) * (strlen(path) + 32));
+    assert(temporary_path);
+    sprintf(temporary_path, "%s.%ld.tmp", path, (long) getpid());
+
+    int fd = open(temporary_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    bool written = fd >= 0;
+
+    for (size_t offset = 0; written && offset < size;) {
+        ssize_t result = write(fd, data + offset, size - offset);
+
+        if (result <= 0) {
+            written = false;
+        } else {
+            offset += (size_t) result;
+        }
+    }
+
+    if (fd >= 0 && close(fd) != 0) {
+        written = false;
+    }
+
+    if (fd >= 0 && (!written || rename(temporary_path, path) != 0)) {
+        unlink(temporary_path);
+        written = false;
+    }
+
+    free(temporary_path);
+
+    return written;
+}
+
+bool joint_interface_write(const joint_node_t * program, uint64_t source_hash) {
+    size_t size;
+    unsigned char * data = joint_interface_build(program, source_hash, &size);
+    char * path = joint_interface_path(program->start_position->path);
+    bool written = joint_interface_store(path, data, size);
+
+    free(path);
+    free(data);
+
+    return written;
+}
+
+static joint_interface_t * joint_interface_validate(const unsigned char * data, size_t size, bool mapped) {
+    if (size < JOINT_INTERFACE_HEADER_SIZE || memcmp(data, JOINT_INTERFACE_MAGIC, 4) != 0 || joint_interface_get_uint32(data + 4) != JOINT_INTERFACE_VERSION) {
+        return NULL;
+    }
+
+    uint32_t slots_length = joint_interface_get_uint32(data + 20);
+
+    if (slots_length == 0 || (slots_length & (slots_length - 1)) != 0 || (size - JOINT_INTERFACE_HEADER_SIZE) / JOINT_INTERFACE_SLOT_SIZE < slots_length) {
+        return NULL;
+    }
+
+    joint_interface_t * interface = malloc(sizeof(joint_interface_t));
+    assert(interface);
+
+    interface->data = data;
+    interface->size = size;
+    interface->mapped = mapped;
+    interface->source_hash = joint_interface_get_uint64(data + 8);
+    interface->exports_length = joint_interface_get_uint32(data + 16);
+    interface->slots_length = slots_length;
+
+    return interface;
+}
+
+joint_interface_t * joint_interface_alloc(const joint_node_t * program, uint64_t source_hash) {
+    size_t size;
+    unsigned char * data = joint_interface_build(program, source_hash, &size);
+    joint_interface_t * interface = joint_interface_validate(data, size, false);
+    assert(interface);
+
+    return interface;
+}
+
+static joint_interface_t * joint_interface_map(const char * path) {
+    int fd = open(path, O_RDONLY);
+
+    if (fd < 0) {
+        return NULL;
+    }
+
+    struct stat status;
+    void * data = MAP_FAILED;
+
+    if (fstat(fd, &status) == 0 && status.st_size > 0) {
+        data = mmap(NULL, (size_t) status.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+
+    close(fd);
+
+    if (data == MAP_FAILED) {
+        return NULL;
+    }
+
+    joint_interface_t * interface = joint_interface_validate(data, (size_t) status.st_size, true);
+
+    if (interface == NULL) {
+        munmap(data, (size_t) status.st_size);
+    }
+
+    return interface;
+}
+
+joint_interface_t * joint_interface_load(const char * source_path) {
+    joint_source_file_t * source_file = joint_source_file_alloc(joint_allocator_system(), source_path);
+
+    if (!joint_source_file_read(source_file)) {
+        joint_source_file_free(source_file);
+        return NULL;
+    }
+
+    joint_interface_t * interface = joint_interface_load_source(source_file);
+    joint_source_file_free(source_file);
+
+    return interface;
+}
+
+joint_interface_t * joint_interface_load_source(joint_source_file_t * source_file) {
+    uint64_t source_hash = joint_hash_bytes(source_file->content->data, (size_t) source_file->content->length, 0);
+    char * path = joint_interface_path(source_file->path);
+    joint_interface_t * interface = joint_interface_map(path);
+
+    if (interface != NULL && interface->source_hash != source_hash) {
+        joint_interface_free(interface);
+        interface = NULL;
+    }
+
+    if (interface == NULL) {
+        joint_tokenizer_t * tokenizer = joint_tokenizer_alloc(source_file->allocator, source_file);
+        tokenizer->skip_comments = true;
+        joint_tokenizer_tokenize(tokenizer);
+        joint_parser_t * parser = joint_parser_alloc(source_file->allocator, tokenizer);
+
+        if (!joint_parser_parse(parser)) {
+            joint_parser_print_error(parser);
+            joint_parser_free(parser);
+            joint_tokenizer_free(tokenizer);
+            free(path);
+            return NULL;
+        }
+
+        size_t size;
+        unsigned char * data = joint_interface_build(parser->program, source_hash, &size);
+
+        /* An unwritable directory only costs the reparse next time. */
+        if (joint_interface_store(path, data, size)) {
+            interface = joint_interface_map(path);
+        }
+
+        if (interface == NULL) {
+            interface = joint_interface_validate(data, size, false);
+        } else {
+            free(data);
+        }
+
+        joint_parser_free(parser);
+        joint_tokenizer_free(tokenizer);
+    }
+
+    free(path);
+
+    return interface;
+}
+
+bool joint_interface_lookup(const joint_interface_t * interface, const char * name, joint_type_t * type) {
+    size_t name_length = strlen(name);
+    uint64_t hash = joint_hash_bytes(name, name_length, 0);
+    size_t strings_offset = JOINT_INTERFACE_HEADER_SIZE + (size_t) interface->slots_length * JOINT_INTERFACE_SLOT_SIZE;
+    uint32_t slot = (uint32_t) hash & (interface->slots_length - 1);
+
+    for (uint32_t probes = 0; probes < interface->slots_length; probes++) {
+        const unsigned char * bytes = interface->data + JOINT_INTERFACE_HEADER_SIZE + (size_t) slot * JOINT_INTERFACE_SLOT_SIZE;
+        uint32_t offset = joint_interface_get_uint32(bytes + 8);
+
+        if (offset == JOINT_INTERFACE_EMPTY_SLOT) {
+            return false;
+        }
+
+        if (joint_interface_get_uint64(bytes) == hash && joint_interface_get_uint16(bytes + 12) == name_length) {
+            /* The file may be corrupted, never read past its end. */
+            if (strings_offset + offset + name_length > interface->size) {
+                return false;
+            }
+
+            if (memcmp(interface->data + strings_offset + offset, name, name_length) == 0) {
+                *type = bytes[14];
+                return true;
+            }
+        }
+
+        slot = (slot + 1) & (interface->slots_length - 1);
+    }
+
+    return false;
+}
+
+void joint_interface_free(joint_interface_t * interface) {
+    if (interface->mapped) {
+        munmap((void *) interface->data, interface->size);
+    } else {
+        free((void *) interface->data);
+    }
+
+    free(interface);
+}
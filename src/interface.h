@@ -0,0 +1,73 @@
+/* Copyright (c) 2014 Vyacheslav Slinko
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef joint_interface_h
+#define joint_interface_h
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "node.h"
+#include "semantic.h"
+#include "source_file.h"
+
+/* A module interface (.jointi) lists the top-level bindings of a module
+ * with their types and the hash of the source they were taken from:
+ *
+ *   header  "JNTI", u32 version, u64 source hash, u32 exports, u32 slots
+ *   slots   u64 name hash, u32 name offset, u16 name length, u8 type, u8 0
+ *   names   concatenated, referenced by offset
+ *
+ * Slots form an open-addressing table indexed by the name hash, so lookups
+ * work on the mapped file directly. */
+
+typedef struct joint_interface {
+    const unsigned char * data;
+    size_t size;
+    bool mapped;
+
+    uint64_t source_hash;
+    uint32_t exports_length;
+    uint32_t slots_length;
+} joint_interface_t;
+
+/* Returns the interface path of a .joint source path. */
+char * joint_interface_path(const char * source_path);
+
+/* Writes the interface of program next to its source. */
+bool joint_interface_write(const joint_node_t * program, uint64_t source_hash);
+
+/* Builds the interface of program in memory, nothing is written. */
+joint_interface_t * joint_interface_alloc(const joint_node_t * program, uint64_t source_hash);
+
+/* Returns the interface of the module at source_path, reparsing the source
+ * only when its interface is missing or was built from other content.
+ * Returns NULL when that source has a syntax error. */
+joint_interface_t * joint_interface_load(const char * source_path);
+
+/* Same as joint_interface_load for a source that is already read. */
+joint_interface_t * joint_interface_load_source(joint_source_file_t * source_file);
+
+bool joint_interface_lookup(const joint_interface_t * interface, const char * name, joint_type_t * type);
+
+void joint_interface_free(joint_interface_t * interface);
+
+#endif
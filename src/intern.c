@@ -0,0 +1,112 @@
+/* Copyright (c) 2014 Vyacheslav Slinko
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include "hash.h"
+#include "intern.h"
+
+static pthread_mutex_t joint_intern_mutex = PTHREAD_MUTEX_INITIALIZER;
+static size_t joint_intern_length = 0;
+static size_t joint_intern_capacity = 0;
+static const joint_intern_string_t ** joint_intern_slots = NULL;
+
+#define JOINT_INTERN_CACHE_SIZE 1024
+
+/* Strings this thread interned lately, so that repeated ones skip the lock.
+ * Entries never go stale because interned strings are never freed. */
+static __thread const joint_intern_string_t * joint_intern_cache[JOINT_INTERN_CACHE_SIZE];
+
+static void joint_intern_grow(void) {
+    size_t capacity = joint_intern_capacity == 0 ? 256 : joint_intern_capacity * 2;
+    const joint_intern_string_t ** slots = calloc(capacity, sizeof(joint_intern_string_t *));
+    assert(slots);
+
+    for (size_t i = 0; i < joint_intern_capacity; i++) {
+        const joint_intern_string_t * string = joint_intern_slots[i];
+
+        if (string == NULL) {
+            continue;
+        }
+
+        size_t slot = string->hash & (capacity - 1);
+
+        while (slots[slot] != NULL) {
+            slot = (slot + 1) & (capacity - 1);
+        }
+
+        slots[slot] = string;
+    }
+
+    free(joint_intern_slots);
+    joint_intern_slots = slots;
+    joint_intern_capacity = capacity;
+}
+
+const joint_intern_string_t * joint_intern(const char * characters, size_t length) {
+    uint64_t hash = joint_hash_bytes(characters, length, 0);
+    const joint_intern_string_t ** cached = &joint_intern_cache[hash & (JOINT_INTERN_CACHE_SIZE - 1)];
+
+    if (*cached != NULL && (*cached)->hash == hash && (*cached)->length == length && memcmp((*cached)->characters, characters, length) == 0) {
+        return *cached;
+    }
+
+    pthread_mutex_lock(&joint_intern_mutex);
+
+    if ((joint_intern_length + 1) * 4 > joint_intern_capacity * 3) {
+        joint_intern_grow();
+    }
+
+    size_t slot = hash & (joint_intern_capacity - 1);
+
+    while (joint_intern_slots[slot] != NULL) {
+        const joint_intern_string_t * string = joint_intern_slots[slot];
+
+        if (string->hash == hash && string->length == length && memcmp(string->characters, characters, length) == 0) {
+            pthread_mutex_unlock(&joint_intern_mutex);
+            *cached = string;
+            return string;
+        }
+
+        slot = (slot + 1) & (joint_intern_capacity - 1);
+    }
+
+    joint_intern_string_t * string = malloc(sizeof(joint_intern_string_t) + length + 1);
+    assert(string);
+    string->length = length;
+    string->hash = hash;
+    memcpy(string->characters, characters, length);
+    string->characters[length] = '\0';
+
+    joint_intern_slots[slot] = string;
+    joint_intern_length++;
+
+    pthread_mutex_unlock(&joint_intern_mutex);
+
+    *cached = string;
+    return string;
+}
+
+const joint_intern_string_t * joint_intern_cstring(const char * string) {
+    return joint_intern(string, strlen(string));
+}
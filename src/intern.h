@@ -0,0 +1,46 @@
+/* Copyright (c) 2014 Vyacheslav Slinko
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef joint_intern_h
+#define joint_intern_h
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Interned strings are immutable and live until the process exits, so two
+ * interned strings are equal exactly when their pointers are. */
+typedef struct joint_intern_string {
+    size_t length;
+    uint64_t hash;
+    char characters[];
+} joint_intern_string_t;
+
+const joint_intern_string_t * joint_intern(const char * characters, size_t length);
+
+const joint_intern_string_t * joint_intern_cstring(const char * string);
+
+/* Recovers the interned string from its characters, which must have been
+ * returned by joint_intern. */
+static inline const joint_intern_string_t * joint_intern_of(const char * characters) {
+    return (const joint_intern_string_t *) (characters - offsetof(joint_intern_string_t, characters));
+}
+
+#endif
@@ -0,0 +1,127 @@
+/* Copyright (c) 2014 Vyacheslav Slinko
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "builtins.h"
+#include "interpreter.h"
+#include "stats.h"
+
+#if defined(__GNUC__) && !defined(JOINT_SWITCH_DISPATCH)
+#define JOINT_THREADED_DISPATCH
+#endif
+
+bool joint_interpreter_call(joint_value_t * base, uint32_t arguments_length, joint_interpreter_stats_t * stats) {
+    if (!joint_value_is_function(*base)) {
+        joint_builtins_flush();
+        fputs("Runtime error: value is not a function\n", stderr);
+        return false;
+    }
+
+    const joint_builtin_t * builtin = joint_value_as_function(*base);
+
+    if ((int) arguments_length != builtin->arguments_length) {
+        joint_builtins_flush();
+        fprintf(stderr, "Runtime error: %s expects %d arguments, %u given\n", builtin->name, builtin->arguments_length, arguments_length);
+        return false;
+    }
+
+    if (stats != NULL) {
+        uint64_t started_at = joint_stats_now();
+        *base = builtin->function(base + 1);
+        stats->calls_time += joint_stats_now() - started_at;
+        stats->calls++;
+    } else {
+        *base = builtin->function(base + 1);
+    }
+
+    return true;
+}
+
+bool joint_interpreter_run(const joint_bytecode_t * bytecode, joint_interpreter_stats_t * stats) {
+    joint_value_t * registers = calloc(bytecode->registers_length > 0 ? bytecode->registers_length : 1, sizeof(joint_value_t));
+    assert(registers);
+
+    const joint_instruction_t * instruction = bytecode->instructions;
+    const joint_value_t * constants = bytecode->constants->values;
+    bool succeeded = true;
+
+#ifdef JOINT_THREADED_DISPATCH
+    static const void * labels[] = {
+        [LOAD_CONSTANT_OPCODE] = &&load_constant,
+        [MOVE_OPCODE] = &&move,
+        [CALL_OPCODE] = &&call,
+        [HALT_OPCODE] = &&halt
+    };
+
+#define JOINT_DISPATCH() goto *labels[instruction->opcode]
+#define JOINT_CASE(label, opcode) label:
+#define JOINT_NEXT() instruction++; JOINT_DISPATCH()
+
+    JOINT_DISPATCH();
+#else
+#define JOINT_CASE(label, opcode) case opcode:
+#define JOINT_NEXT() instruction++; continue
+
+    while (true) {
+        switch (instruction->opcode) {
+#endif
+            JOINT_CASE(load_constant, LOAD_CONSTANT_OPCODE)
+                registers[instruction->a] = constants[instruction->b];
+                JOINT_NEXT();
+
+            JOINT_CASE(move, MOVE_OPCODE)
+                registers[instruction->a] = registers[instruction->b];
+                JOINT_NEXT();
+
+            JOINT_CASE(call, CALL_OPCODE)
+                if (!joint_interpreter_call(registers + instruction->a, instruction->b, stats)) {
+                    succeeded = false;
+                    goto finish;
+                }
+                JOINT_NEXT();
+
+            JOINT_CASE(halt, HALT_OPCODE)
+                goto finish;
+#ifndef JOINT_THREADED_DISPATCH
+        }
+    }
+#endif
+
+finish:
+    /* Programs are straight-line, so the executed instructions are exactly
+     * the ones up to the halting one. */
+    if (stats != NULL) {
+        stats->instructions += (uint64_t) (instruction - bytecode->instructions) + 1;
+    }
+
+    free(registers);
+    joint_builtins_flush();
+
+    return succeeded;
+
+#undef JOINT_CASE
+#undef JOINT_NEXT
+#ifdef JOINT_THREADED_DISPATCH
+#undef JOINT_DISPATCH
+#endif
+}
@@ -0,0 +1,41 @@
+/* Copyright (c) 2014 Vyacheslav Slinko
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef joint_interpreter_h
+#define joint_interpreter_h
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "bytecode.h"
+
+typedef struct joint_interpreter_stats {
+    uint64_t instructions;
+    uint64_t calls;
+    uint64_t calls_time;
+} joint_interpreter_stats_t;
+
+/* Calls R[0](R[1], ..., R[arguments_length]) of base and stores the result in
+ * R[0], stats may be NULL. */
+bool joint_interpreter_call(joint_value_t * base, uint32_t arguments_length, joint_interpreter_stats_t * stats);
+
+bool joint_interpreter_run(const joint_bytecode_t * bytecode, joint_interpreter_stats_t * stats);
+
+#endif
@@ -0,0 +1,281 @@
+/* Copyright (c) 2014 Vyacheslav Slinko
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include "builtins.h"
+#include "jit.h"
+
+#if defined(__x86_64__)
+
+typedef struct joint_jit_assembler {
+    size_t length;
+    size_t capacity;
+    uint8_t * code;
+
+    size_t failure_jumps_length;
+    size_t failure_jumps_capacity;
+    size_t * failure_jumps;
+} joint_jit_assembler_t;
+
+static void joint_jit_emit(joint_jit_assembler_t * assembler, const void * bytes, size_t length) {
+    if (assembler->length + length > assembler->capacity) {
+        while (assembler->length + length > assembler->capacity) {
+            assembler->capacity *= 2;
+        }
+
+        assembler->code = realloc(assembler->code, assembler->capacity);
+        assert(assembler->code);
+    }
+
+    memcpy(assembler->code + assembler->length, bytes, length);
+    assembler->length += length;
+}
+
+static void joint_jit_emit_byte(joint_jit_assembler_t * assembler, uint8_t byte) {
+    joint_jit_emit(assembler, &byte, 1);
+}
+
+static void joint_jit_emit_uint32(joint_jit_assembler_t * assembler, uint32_t value) {
+    uint8_t bytes[4] = {value, value >> 8, value >> 16, value >> 24};
+    joint_jit_emit(assembler, bytes, sizeof(bytes));
+}
+
+static void joint_jit_emit_uint64(joint_jit_assembler_t * assembler, uint64_t value) {
+    joint_jit_emit_uint32(assembler, (uint32_t) value);
+    joint_jit_emit_uint32(assembler, (uint32_t) (value >> 32));
+}
+
+/* The registers array lives in rbx for the whole program. */
+
+static void joint_jit_emit_load_immediate(joint_jit_assembler_t * assembler, uint8_t opcode, uint64_t value) {
+    /* movabs r64, imm64 */
+    joint_jit_emit_byte(assembler, 0x48);
+    joint_jit_emit_byte(assembler, opcode);
+    joint_jit_emit_uint64(assembler, value);
+}
+
+static void joint_jit_emit_store_rax(joint_jit_assembler_t * assembler, uint32_t register_index) {
+    /* mov [rbx + disp32], rax */
+    joint_jit_emit(assembler, "\x48\x89\x83", 3);
+    joint_jit_emit_uint32(assembler, register_index * sizeof(joint_value_t));
+}
+
+static void joint_jit_emit_load_rax(joint_jit_assembler_t * assembler, uint32_t register_index) {
+    /* mov rax, [rbx + disp32] */
+    joint_jit_emit(assembler, "\x48\x8B\x83", 3);
+    joint_jit_emit_uint32(assembler, register_index * sizeof(joint_value_t));
+}
+
+static void joint_jit_emit_register_address(joint_jit_assembler_t * assembler, uint32_t register_index) {
+    /* lea rdi, [rbx + disp32] */
+    joint_jit_emit(assembler, "\x48\x8D\xBB", 3);
+    joint_jit_emit_uint32(assembler, register_index * sizeof(joint_value_t));
+}
+
+static void joint_jit_emit_call(joint_jit_assembler_t * assembler, const void * function) {
+    /* movabs rax, function; call rax */
+    joint_jit_emit_load_immediate(assembler, 0xB8, (uint64_t) (uintptr_t) function);
+    joint_jit_emit(assembler, "\xFF\xD0", 2);
+}
+
+static void joint_jit_emit_failure_check(joint_jit_assembler_t * assembler) {
+    /* test al, al; jz failure */
+    joint_jit_emit(assembler, "\x84\xC0\x0F\x84", 4);
+
+    if (assembler->failure_jumps_length == assembler->failure_jumps_capacity) {
+        assembler->failure_jumps_capacity *= 2;
+        assembler->failure_jumps = realloc(assembler->failure_jumps, sizeof(size_t) * assembler->failure_jumps_capacity);
+        assert(assembler->failure_jumps);
+    }
+
+    assembler->failure_jumps[assembler->failure_jumps_length++] = assembler->length;
+    joint_jit_emit_uint32(assembler, 0);
+}
+
+static void joint_jit_emit_generic_call(joint_jit_assembler_t * assembler, const joint_instruction_t * instruction, joint_interpreter_stats_t * stats) {
+    joint_jit_emit_register_address(assembler, instruction->a);
+    /* mov esi, imm32 */
+    joint_jit_emit_byte(assembler, 0xBE);
+    joint_jit_emit_uint32(assembler, instruction->b);
+    /* movabs rdx, stats */
+    joint_jit_emit_load_immediate(assembler, 0xBA, (uint64_t) (uintptr_t) stats);
+    joint_jit_emit_call(assembler, (const void *) joint_interpreter_call);
+    joint_jit_emit_failure_check(assembler);
+}
+
+static bool joint_jit_translate(joint_jit_assembler_t * assembler, const joint_bytecode_t * bytecode, joint_interpreter_stats_t * stats) {
+    /* Straight-line code lets us track which registers hold a known constant,
+     * calls through them skip the arity check and go to the builtin directly. */
+    bool * known = calloc(bytecode->registers_length > 0 ? bytecode->registers_length : 1, sizeof(bool));
+    joint_value_t * values = calloc(bytecode->registers_length > 0 ? bytecode->registers_length : 1, sizeof(joint_value_t));
+    assert(known && values);
+
+    bool supported = true;
+
+    /* push rbx; mov rbx, rdi */
+    joint_jit_emit(assembler, "\x53\x48\x89\xFB", 4);
+
+    for (int i = 0; i < bytecode->instructions_length && supported; i++) {
+        const joint_instruction_t * instruction = &bytecode->instructions[i];
+
+        switch (instruction->opcode) {
+            case LOAD_CONSTANT_OPCODE:
+                joint_jit_emit_load_immediate(assembler, 0xB8, bytecode->constants->values[instruction->b]);
+                joint_jit_emit_store_rax(assembler, instruction->a);
+                known[instruction->a] = true;
+                values[instruction->a] = bytecode->constants->values[instruction->b];
+                break;
+
+            case MOVE_OPCODE:
+                joint_jit_emit_load_rax(assembler, instruction->b);
+                joint_jit_emit_store_rax(assembler, instruction->a);
+                known[instruction->a] = known[instruction->b];
+                values[instruction->a] = values[instruction->b];
+                break;
+
+            case CALL_OPCODE: {
+                const joint_builtin_t * builtin = NULL;
+
+                if (stats == NULL && known[instruction->a] && joint_value_is_function(values[instruction->a])) {
+                    builtin = joint_value_as_function(values[instruction->a]);
+                }
+
+                if (builtin != NULL && builtin->arguments_length == (int) instruction->b) {
+                    joint_jit_emit_register_address(assembler, instruction->a + 1);
+                    joint_jit_emit_call(assembler, (const void *) builtin->function);
+                    joint_jit_emit_store_rax(assembler, instruction->a);
+                } else {
+                    joint_jit_emit_generic_call(assembler, instruction, stats);
+                }
+
+                known[instruction->a] = false;
+                break;
+            }
+
+            case HALT_OPCODE:
+                /* mov eax, 1; pop rbx; ret */
+                joint_jit_emit(assembler, "\xB8\x01\x00\x00\x00\x5B\xC3", 7);
+                break;
+
+            default:
+                supported = false;
+                break;
+        }
+    }
+
+    size_t failure = assembler->length;
+
+    /* xor eax, eax; pop rbx; ret */
+    joint_jit_emit(assembler, "\x31\xC0\x5B\xC3", 4);
+
+    for (size_t i = 0; i < assembler->failure_jumps_length; i++) {
+        size_t jump = assembler->failure_jumps[i];
+        int32_t displacement = (int32_t) (failure - (jump + 4));
+        memcpy(assembler->code + jump, &displacement, sizeof(displacement));
+    }
+
+    free(known);
+    free(values);
+
+    return supported;
+}
+
+joint_jit_t * joint_jit_compile(const joint_bytecode_t * bytecode, joint_interpreter_stats_t * stats) {
+    joint_jit_assembler_t assembler = {
+        .length = 0,
+        .capacity = 4096,
+        .code = malloc(4096),
+        .failure_jumps_length = 0,
+        .failure_jumps_capacity = 64,
+        .failure_jumps = malloc(sizeof(size_t) * 64)
+    };
+    assert(assembler.code && assembler.failure_jumps);
+
+    joint_jit_t * jit = NULL;
+
+    if (joint_jit_translate(&assembler, bytecode, stats)) {
+        size_t page_size = (size_t) sysconf(_SC_PAGESIZE);
+        size_t size = (assembler.length + page_size - 1) & ~(page_size - 1);
+        void * code = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+        if (code != MAP_FAILED) {
+            memcpy(code, assembler.code, assembler.length);
+
+            if (mprotect(code, size, PROT_READ | PROT_EXEC) == 0) {
+                jit = malloc(sizeof(joint_jit_t));
+                assert(jit);
+                jit->size = size;
+                jit->code = code;
+                jit->registers_length = bytecode->registers_length;
+            } else {
+                munmap(code, size);
+            }
+        }
+    }
+
+    free(assembler.code);
+    free(assembler.failure_jumps);
+
+    return jit;
+}
+
+bool joint_jit_run(const joint_jit_t * jit) {
+    joint_value_t * registers = calloc(jit->registers_length > 0 ? jit->registers_length : 1, sizeof(joint_value_t));
+    assert(registers);
+
+    bool (* function)(joint_value_t *);
+    /* Object to function pointer conversion is not ISO C, but POSIX requires
+     * it to work (dlsym relies on it as well). */
+    memcpy(&function, &jit->code, sizeof(function));
+
+    bool succeeded = function(registers);
+
+    free(registers);
+    joint_builtins_flush();
+
+    return succeeded;
+}
+
+void joint_jit_free(joint_jit_t * jit) {
+    munmap(jit->code, jit->size);
+    free(jit);
+}
+
+#else
+
+joint_jit_t * joint_jit_compile(const joint_bytecode_t * bytecode, joint_interpreter_stats_t * stats) {
+    return NULL;
+}
+
+bool joint_jit_run(const joint_jit_t * jit) {
+    return false;
+}
+
+void joint_jit_free(joint_jit_t * jit) {
+}
+
+#endif
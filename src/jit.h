@@ -0,0 +1,44 @@
+/* Copyright (c) 2014 Vyacheslav Slinko
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef joint_jit_h
+#define joint_jit_h
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "bytecode.h"
+#include "interpreter.h"
+
+typedef struct joint_jit {
+    size_t size;
+    void * code;
+    int registers_length;
+} joint_jit_t;
+
+/* Returns NULL when the bytecode can not be translated on this machine, the
+ * caller is expected to fall back to joint_interpreter_run. */
+joint_jit_t * joint_jit_compile(const joint_bytecode_t * bytecode, joint_interpreter_stats_t * stats);
+
+bool joint_jit_run(const joint_jit_t * jit);
+
+void joint_jit_free(joint_jit_t * jit);
+
+#endif
@@ -22,16 +22,56 @@
 #include <argp.h>
 #include <stdbool.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "allocator.h"
+#include "bytecode.h"
+#include "c_backend.h"
+#include "cache.h"
+#include "dump.h"
+#include "hash.h"
+#include "interface.h"
+#include "interpreter.h"
+#include "jit.h"
 #include "source_file.h"
+#include "stats.h"
 #include "tokenizer.h"
+#include "optimizer.h"
+#include "parallel_parser.h"
+#include "parallel_tokenizer.h"
 #include "parser.h"
+#include "passes.h"
+#include "semantic.h"
+#include "server.h"
+#include "watch.h"
+#include "writer.h"
 
 const char * argp_program_version = "joint 0.1";
 const char * argp_program_bug_address = "Vyacheslav Slinko <vyacheslav.slinko@gmail.com>";
 
+enum {
+    SERVE_OPTION = 0x100,
+    CONNECT_OPTION,
+    NO_OPTIMIZE_OPTION
+};
+
 static struct argp_option options[] = {
     {"tokens", 't', 0, OPTION_ARG_OPTIONAL, "Print tokens and exit"},
     {"ast", 'a', 0, OPTION_ARG_OPTIONAL, "Print AST tree and exit"},
+    {"format", 'f', "FORMAT", 0, "Output format of tokens and AST: text, json or binary"},
+    {"cache-dir", 'c', "DIRECTORY", 0, "Reuse tokens and AST of unchanged sources from DIRECTORY"},
+    {"cache-size", 'C', "BYTES", 0, "Evict least recently used cache entries above BYTES"},
+    {"stats", 's', 0, 0, "Print statistics to stderr"},
+    {"serve", SERVE_OPTION, "SOCKET", 0, "Serve requests of --connect clients on a Unix domain SOCKET"},
+    {"connect", CONNECT_OPTION, "SOCKET", 0, "Send the request to a server listening on SOCKET"},
+    {"watch", 'w', 0, 0, "Recompile the source file and its imports whenever they change"},
+    {"jit", 'j', 0, 0, "Run the program as native code when the machine is supported"},
+    {"emit", 'e', "TARGET", 0, "Print the program translated to TARGET: c, or write its interface file for TARGET interface"},
+    {"check", 'k', 0, 0, "Check names and types and exit"},
+    {"no-optimize", NO_OPTIMIZE_OPTION, 0, 0, "Run or translate the program without optimization passes"},
+    {"allocator", 'A', "ALLOCATOR", 0, "Allocate the source, tokens and AST with ALLOCATOR: system, arena or pool"},
+    {"jobs", 'J', "COUNT", 0, "Tokenize and parse large sources with COUNT threads, one per processor by default"},
     {0}
 };
 
@@ -39,6 +79,21 @@ struct arguments {
     char * source_file_path;
     bool tokens;
     bool ast;
+    enum joint_dump_format format;
+    char * cache_directory;
+    unsigned long long cache_size;
+    bool stats;
+    char * serve_socket_path;
+    char * connect_socket_path;
+    bool watch;
+    bool run;
+    bool jit;
+    bool emit_c;
+    bool emit_interface;
+    bool check;
+    bool optimize;
+    joint_allocator_t * allocator;
+    int jobs;
 };
 
 static error_t parse_opt(int key, char * arg, struct argp_state * state) {
@@ -53,12 +108,83 @@ static error_t parse_opt(int key, char * arg, struct argp_state * state) {
             arguments->ast = true;
             break;
 
+        case 'f':
+            if (!joint_dump_parse_format(arg, &arguments->format)) {
+                argp_error(state, "Unknown format \"%s\"", arg);
+            }
+            break;
+
+        case 'c':
+            arguments->cache_directory = arg;
+            break;
+
+        case 'C':
+            arguments->cache_size = strtoull(arg, NULL, 10);
+            break;
+
+        case 's':
+            arguments->stats = true;
+            break;
+
+        case SERVE_OPTION:
+            arguments->serve_socket_path = arg;
+            break;
+
+        case CONNECT_OPTION:
+            arguments->connect_socket_path = arg;
+            break;
+
+        case 'w':
+            arguments->watch = true;
+            break;
+
+        case 'j':
+            arguments->jit = true;
+            break;
+
+        case 'e':
+            if (strcmp(arg, "c") == 0) {
+                arguments->emit_c = true;
+            } else if (strcmp(arg, "interface") == 0) {
+                arguments->emit_interface = true;
+            } else {
+                argp_error(state, "unknown target \"%s\"", arg);
+            }
+            break;
+
+        case 'k':
+            arguments->check = true;
+            break;
+
+        case NO_OPTIMIZE_OPTION:
+            arguments->optimize = false;
+            break;
+
+        case 'A':
+            if (!joint_allocator_parse(arg, &arguments->allocator)) {
+                argp_error(state, "unknown allocator \"%s\"", arg);
+            }
+            break;
+
+        case 'J':
+            arguments->jobs = atoi(arg);
+            if (arguments->jobs < 1) {
+                argp_error(state, "invalid jobs count \"%s\"", arg);
+            }
+            break;
+
         case ARGP_KEY_NO_ARGS:
-            argp_usage(state);
+            if (arguments->serve_socket_path == NULL) {
+                argp_usage(state);
+            }
             break;
 
         case ARGP_KEY_ARG:
-            arguments->source_file_path = arg;
+            if (state->arg_num == 0 && strcmp(arg, "run") == 0) {
+                arguments->run = true;
+            } else {
+                arguments->source_file_path = arg;
+            }
             break;
 
         default:
@@ -71,20 +197,92 @@ static error_t parse_opt(int key, char * arg, struct argp_state * state) {
 static struct argp argp = {
     .options = options,
     .parser = parse_opt,
-    .args_doc = "SOURCE_FILE",
+    .args_doc = "SOURCE_FILE\nrun SOURCE_FILE",
     .doc = "The Joint language compiler."
 };
 
 static struct arguments arguments = {
     .source_file_path = "-",
     .tokens = false,
-    .ast = true
+    .ast = false,
+    .format = TEXT_DUMP_FORMAT,
+    .cache_directory = NULL,
+    .cache_size = 256 * 1024 * 1024,
+    .stats = false,
+    .serve_socket_path = NULL,
+    .connect_socket_path = NULL,
+    .watch = false,
+    .run = false,
+    .jit = false,
+    .emit_c = false,
+    .emit_interface = false,
+    .check = false,
+    .optimize = true,
+    .allocator = NULL,
+    .jobs = 0
 };
 
+static void add_interpreter_stats(joint_stats_t * stats, const joint_interpreter_stats_t * interpreter_stats, uint64_t compile_time, uint64_t run_time) {
+    joint_stats_add_time(stats, "compile time", compile_time);
+    joint_stats_add_time(stats, "run time", run_time);
+
+    /* Native code does not count the instructions it executes. */
+    if (interpreter_stats->instructions > 0) {
+        joint_stats_add(stats, "instructions", interpreter_stats->instructions);
+        joint_stats_add(stats, "instructions per second", run_time > 0 ? interpreter_stats->instructions * 1000000000 / run_time : 0);
+    }
+
+    joint_stats_add(stats, "calls", interpreter_stats->calls);
+    joint_stats_add(stats, "nanoseconds per call", interpreter_stats->calls > 0 ? interpreter_stats->calls_time / interpreter_stats->calls : 0);
+}
+
+static void print_stats(joint_stats_t * stats, const joint_cache_t * cache, joint_allocator_t * tracking_allocator) {
+    if (cache != NULL) {
+        joint_stats_add(stats, "cache hits", cache->hits);
+        joint_stats_add(stats, "cache misses", cache->misses);
+        joint_stats_add(stats, "cache stores", cache->stores);
+        joint_stats_add(stats, "cache evictions", cache->evictions);
+    }
+
+    joint_allocator_tracking_add_stats(tracking_allocator, stats);
+
+    joint_writer_t * writer = joint_writer_alloc(2, 4096);
+    joint_stats_print(stats, writer);
+    joint_writer_free(writer);
+}
+
 int main(int argc, char ** argv) {
     argp_parse(&argp, argc, argv, 0, 0, &arguments);
 
-    joint_source_file_t * source_file = joint_source_file_alloc(arguments.source_file_path);
+    if (arguments.serve_socket_path != NULL) {
+        return joint_server_serve(arguments.serve_socket_path);
+    }
+
+    if (arguments.connect_socket_path != NULL) {
+        enum joint_server_command command = COMPILE_SERVER_COMMAND;
+
+        if (arguments.tokens) {
+            command = TOKENS_SERVER_COMMAND;
+        } else if (arguments.ast) {
+            command = AST_SERVER_COMMAND;
+        }
+
+        return joint_server_request(arguments.connect_socket_path, command, arguments.format, arguments.source_file_path);
+    }
+
+    if (arguments.watch) {
+        return joint_watch(arguments.source_file_path);
+    }
+
+    joint_allocator_t * allocator = arguments.allocator != NULL ? arguments.allocator : joint_allocator_system();
+    joint_allocator_t * tracking_allocator = NULL;
+
+    if (arguments.stats) {
+        tracking_allocator = joint_allocator_tracking_alloc(allocator);
+        allocator = tracking_allocator;
+    }
+
+    joint_source_file_t * source_file = joint_source_file_alloc(allocator, arguments.source_file_path);
 
     if (!joint_source_file_read(source_file)) {
         fprintf(stderr, "Unable to read file \"%s\"\n", arguments.source_file_path);
@@ -92,30 +290,178 @@ int main(int argc, char ** argv) {
         return 1;
     }
 
-    joint_tokenizer_t * tokenizer = joint_tokenizer_alloc(source_file);
-    joint_tokenizer_tokenize(tokenizer);
+    joint_cache_t * cache = NULL;
+    joint_tokenizer_t * tokenizer = NULL;
+    joint_parser_t * parser = NULL;
+    joint_node_t * program = NULL;
+    int status = 0;
 
-    if (arguments.tokens) {
-        joint_tokeinzer_print(tokenizer);
-        joint_tokenizer_free(tokenizer);
-        joint_source_file_free(source_file);
-        return 0;
+    if (arguments.cache_directory != NULL) {
+        cache = joint_cache_alloc(arguments.cache_directory, arguments.cache_size, argp_program_version);
+    }
+
+    if (cache == NULL || !joint_cache_load(cache, source_file, &tokenizer, &program)) {
+        tokenizer = joint_tokenizer_alloc(allocator, source_file);
+
+        /* Dumps and translated C keep comments, cached tokens may be dumped later. */
+        tokenizer->skip_comments = cache == NULL && !arguments.emit_c && (arguments.run || arguments.emit_interface || arguments.check);
+
+        int jobs = arguments.jobs > 0 ? arguments.jobs : (int) sysconf(_SC_NPROCESSORS_ONLN);
+
+        if (jobs > 1 && source_file->content->length >= JOINT_PARALLEL_TOKENIZER_THRESHOLD) {
+            joint_parallel_tokenizer_tokenize(tokenizer, jobs);
+        } else {
+            joint_tokenizer_tokenize(tokenizer);
+        }
+
+        if (cache != NULL || arguments.run || arguments.emit_c || arguments.emit_interface || arguments.check || !arguments.tokens) {
+            parser = joint_parser_alloc(allocator, tokenizer);
+
+            bool parsed;
+
+            if (jobs > 1 && tokenizer->tokens_length >= JOINT_PARALLEL_PARSER_THRESHOLD) {
+                parsed = joint_parallel_parser_parse(parser, jobs);
+            } else {
+                parsed = joint_parser_parse(parser);
+            }
+
+            if (!parsed) {
+                joint_parser_print_error(parser);
+                status = 1;
+            }
+
+            program = parser->program;
+        }
+
+        if (cache != NULL && status == 0) {
+            joint_cache_store(cache, tokenizer, program);
+        }
+    }
+
+    joint_stats_t * stats = arguments.stats ? joint_stats_alloc() : NULL;
+    bool check = status == 0 && (arguments.check || arguments.run || arguments.emit_c || arguments.emit_interface);
+
+    if (check) {
+        joint_semantic_result_t semantic_result;
+        uint64_t started_at = joint_stats_now();
+        uint64_t cpu_started_at = joint_stats_cpu_now();
+
+        if (!joint_semantic_check(program, stderr, &semantic_result)) {
+            status = 1;
+        }
+
+        if (stats != NULL) {
+            joint_stats_add_time(stats, "check time", joint_stats_now() - started_at);
+            joint_stats_add_time(stats, "check CPU time", joint_stats_cpu_now() - cpu_started_at);
+            joint_stats_add_time(stats, "import I/O wait time", semantic_result.imports.wait_time);
+            joint_stats_add(stats, "imports loaded", (uint64_t) semantic_result.imports.files);
+            joint_stats_add(stats, "import bytes loaded", semantic_result.imports.bytes);
+            joint_stats_add(stats, "symbols", semantic_result.symbols);
+            joint_stats_add(stats, "diagnostics", semantic_result.diagnostics);
+        }
+    }
+
+    joint_optimizer_t * optimizer = NULL;
+
+    if (status == 0 && arguments.optimize && (arguments.run || arguments.emit_c)) {
+        optimizer = joint_optimizer_alloc(16);
+        joint_passes_add_defaults(optimizer);
+        joint_optimizer_run(optimizer, program);
+
+        if (stats != NULL) {
+            joint_optimizer_add_stats(optimizer, stats);
+        }
     }
 
-    joint_parser_t * parser = joint_parser_alloc(tokenizer);
-    joint_parser_parse(parser);
+    if (status != 0 || arguments.check) {
+        /* Nothing to do after checking. */
+    } else if (arguments.run) {
+        joint_interpreter_stats_t interpreter_stats = {.instructions = 0, .calls = 0, .calls_time = 0};
+        uint64_t started_at = joint_stats_now();
+        joint_bytecode_t * bytecode = joint_bytecode_compile(program, parser != NULL ? parser->constants : NULL);
+        joint_jit_t * jit = NULL;
+
+        if (bytecode != NULL && arguments.jit) {
+            jit = joint_jit_compile(bytecode, stats != NULL ? &interpreter_stats : NULL);
+        }
 
-    if (arguments.ast) {
-        joint_parser_print(parser);
+        uint64_t compile_time = joint_stats_now() - started_at;
+
+        if (bytecode == NULL) {
+            status = 1;
+        } else {
+            started_at = joint_stats_now();
+
+            if (jit != NULL ? !joint_jit_run(jit) : !joint_interpreter_run(bytecode, stats != NULL ? &interpreter_stats : NULL)) {
+                status = 1;
+            }
+
+            uint64_t run_time = joint_stats_now() - started_at;
+
+            if (stats != NULL) {
+                add_interpreter_stats(stats, &interpreter_stats, compile_time, run_time);
+            }
+
+            if (jit != NULL) {
+                joint_jit_free(jit);
+            }
+
+            joint_bytecode_free(bytecode);
+        }
+    } else if (arguments.emit_interface) {
+        uint64_t source_hash = joint_hash_bytes(source_file->content->data, (size_t) source_file->content->length, 0);
+
+        if (!joint_interface_write(program, source_hash)) {
+            fprintf(stderr, "Can not write the interface of %s\n", source_file->path);
+            status = 1;
+        }
+    } else if (arguments.emit_c) {
+        joint_writer_t * writer = joint_writer_alloc(1, 1 << 20);
+
+        if (!joint_c_backend_emit(writer, program)) {
+            status = 1;
+        }
+
+        joint_writer_free(writer);
+    } else if (arguments.tokens) {
+        joint_writer_t * writer = joint_writer_alloc(1, 1 << 20);
+        joint_dump_tokens(writer, tokenizer, arguments.format);
+        joint_writer_free(writer);
+    } else {
+        joint_writer_t * writer = joint_writer_alloc(1, 1 << 20);
+        joint_dump_node(writer, program, arguments.format);
+        joint_writer_free(writer);
+    }
+
+    if (stats != NULL) {
+        print_stats(stats, cache, tracking_allocator);
+        joint_stats_free(stats);
+    }
+
+    if (optimizer != NULL) {
+        joint_optimizer_free(optimizer);
+    }
+
+    if (parser != NULL) {
         joint_parser_free(parser);
-        joint_tokenizer_free(tokenizer);
-        joint_source_file_free(source_file);
-        return 0;
+    } else if (program != NULL) {
+        joint_node_free(program);
+    }
+
+    if (cache != NULL) {
+        joint_cache_free(cache);
     }
 
-    joint_parser_free(parser);
     joint_tokenizer_free(tokenizer);
     joint_source_file_free(source_file);
 
-    return 0;
+    if (tracking_allocator != NULL) {
+        joint_allocator_free(tracking_allocator);
+    }
+
+    if (arguments.allocator != NULL) {
+        joint_allocator_free(arguments.allocator);
+    }
+
+    return status;
 }
@@ -0,0 +1,125 @@
+/* Copyright (c) 2014 Vyacheslav Slinko
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "joint_string.h"
+
+joint_string_t * joint_string_alloc(joint_allocator_t * allocator, size_t block_size) {
+    joint_string_t * string = JOINT_ALLOCATE(allocator, sizeof(joint_string_t));
+    assert(string);
+
+    string->data = JOINT_ALLOCATE(allocator, sizeof(char) * (block_size + 1));
+    assert(string->data);
+
+    string->allocator = allocator;
+    string->block_size = block_size;
+    string->length = 0;
+    string->data[0] = '\0';
+    string->borrowed = false;
+
+    return string;
+}
+
+joint_string_t * joint_string_borrow(joint_allocator_t * allocator, const char * data, size_t length) {
+    joint_string_t * string = JOINT_ALLOCATE(allocator, sizeof(joint_string_t));
+    assert(string);
+
+    string->allocator = allocator;
+    string->block_size = 0;
+    string->length = length;
+    string->data = (char *) data;
+    string->borrowed = true;
+
+    return string;
+}
+
+joint_string_t * joint_string_adopt(joint_allocator_t * allocator, char * data, size_t length) {
+    if (length == 0) {
+        JOINT_DEALLOCATE(allocator, data);
+        return joint_string_alloc(allocator, 512);
+    }
+
+    joint_string_t * string = JOINT_ALLOCATE(allocator, sizeof(joint_string_t));
+    assert(string);
+
+    /* Appending grows the data whenever length is a multiple of the block
+     * size, which matches data holding exactly length bytes. */
+    string->allocator = allocator;
+    string->block_size = length;
+    string->length = length;
+    string->data = data;
+    string->borrowed = false;
+
+    return string;
+}
+
+void joint_string_set_content(joint_string_t * string, const char * content) {
+    assert(!string->borrowed);
+
+    string->length = strlen(content);
+    string->data = JOINT_REALLOCATE(string->allocator, string->data, sizeof(char) * (string->length / string->block_size * string->block_size + string->block_size + 1));
+    assert(string->data);
+    strcpy(string->data, content);
+}
+
+void joint_string_append_character(joint_string_t * string, char character) {
+    assert(!string->borrowed);
+
+    if (string->length > 0 && string->length % string->block_size == 0) {
+        string->data = JOINT_REALLOCATE(string->allocator, string->data, sizeof(char) * (string->length + string->block_size + 1));
+        assert(string->data);
+    }
+
+    string->data[string->length++] = character;
+    string->data[string->length] = '\0';
+}
+
+void joint_string_splice(joint_string_t * string, size_t offset, size_t removed_length, const char * inserted, size_t inserted_length) {
+    assert(!string->borrowed);
+    assert(offset + removed_length <= string->length);
+
+    size_t length = string->length - removed_length + inserted_length;
+
+    if (inserted_length > removed_length) {
+        string->data = JOINT_REALLOCATE(string->allocator, string->data, sizeof(char) * (length / string->block_size * string->block_size + string->block_size + 1));
+        assert(string->data);
+    }
+
+    memmove(string->data + offset + inserted_length, string->data + offset + removed_length, string->length - offset - removed_length + 1);
+    memcpy(string->data + offset, inserted, inserted_length);
+    string->length = length;
+}
+
+void joint_string_print(const joint_string_t * string) {
+    fwrite(string->data, sizeof(char), string->length, stdout);
+    putchar('\n');
+}
+
+void joint_string_free(joint_string_t * string) {
+    if (!string->borrowed) {
+        JOINT_DEALLOCATE(string->allocator, string->data);
+    }
+
+    JOINT_DEALLOCATE(string->allocator, string);
+}
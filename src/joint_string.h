@@ -19,48 +19,39 @@
  * THE SOFTWARE.
  */
 
-#include <assert.h>
-#include <stdio.h>
-#include <stdlib.h>
-#include <string.h>
-#include "string.h"
+#ifndef joint_string_h
+#define joint_string_h
 
-joint_string_t * joint_string_alloc(size_t block_size) {
-    joint_string_t * string = malloc(sizeof(joint_string_t));
-    assert(string);
+#include <stdbool.h>
+#include "allocator.h"
 
-    string->data = malloc(sizeof(char) * (block_size + 1));
-    assert(string->data);
+typedef struct joint_string {
+    joint_allocator_t * allocator;
+    size_t block_size;
+    size_t length;
+    char * data;
+    bool borrowed;
+} joint_string_t;
 
-    string->block_size = block_size;
-    string->length = 0;
-    string->data[0] = '\0';
+joint_string_t * joint_string_alloc(joint_allocator_t * allocator, size_t block_size);
 
-    return string;
-}
+/* Wraps length bytes of data without copying them. The data is not
+ * necessarily NUL terminated, must outlive the string and can not be
+ * modified through it. */
+joint_string_t * joint_string_borrow(joint_allocator_t * allocator, const char * data, size_t length);
 
-void joint_string_set_content(joint_string_t * string, const char * content) {
-    string->length = (int) strlen(content);
-    realloc(string->data, sizeof(char) * (string->length / string->block_size * string->block_size + string->block_size + 1));
-    assert(string->data);
-    strcpy(string->data, content);
-}
+/* Takes over data, which holds length bytes followed by a NUL and was
+ * allocated from allocator. */
+joint_string_t * joint_string_adopt(joint_allocator_t * allocator, char * data, size_t length);
 
-void joint_string_append_character(joint_string_t * string, char character) {
-    if (string->length > 0 && string->length % string->block_size == 0) {
-        string->data = realloc(string->data, sizeof(char) * (string->length + string->block_size + 1));
-        assert(string->data);
-    }
+void joint_string_set_content(joint_string_t * string, const char * content);
 
-    string->data[string->length++] = character;
-    string->data[string->length] = '\0';
-}
+void joint_string_append_character(joint_string_t * string, char character);
 
-void joint_string_print(const joint_string_t * string) {
-    puts(string->data);
-}
+void joint_string_splice(joint_string_t * string, size_t offset, size_t removed_length, const char * inserted, size_t inserted_length);
 
-void joint_string_free(joint_string_t * string) {
-    free(string->data);
-    free(string);
-}
+void joint_string_print(const joint_string_t * string);
+
+void joint_string_free(joint_string_t * string);
+
+#endif
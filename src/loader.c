@@ -0,0 +1,567 @@
+/* Copyright (c) 2014 Vyacheslav Slinko
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#define _GNU_SOURCE
+
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "loader.h"
+#include "stats.h"
+
+#if defined(__linux__) && !defined(JOINT_LOADER_NO_IO_URING)
+#define JOINT_LOADER_IO_URING
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#endif
+
+#define JOINT_LOADER_THREADS 4
+
+#ifdef JOINT_LOADER_IO_URING
+
+enum joint_loader_operation {
+    OPEN_LOADER_OPERATION,
+    STATX_LOADER_OPERATION,
+    READ_LOADER_OPERATION,
+    CLOSE_LOADER_OPERATION
+};
+
+struct joint_loader_ring {
+    int fd;
+    void * rings;
+    size_t rings_size;
+    struct io_uring_sqe * sqes;
+    size_t sqes_size;
+
+    unsigned * sq_head;
+    unsigned * sq_tail;
+    unsigned sq_mask;
+    unsigned sq_entries;
+    unsigned * sq_array;
+
+    unsigned * cq_head;
+    unsigned * cq_tail;
+    unsigned cq_mask;
+    struct io_uring_cqe * cqes;
+
+    unsigned queued;
+
+    /* One per file in flight, indexed by file modulo depth. */
+    struct statx * statxes;
+};
+
+static bool joint_loader_ring_supports(int fd) {
+    static const int operations[] = {IORING_OP_OPENAT, IORING_OP_STATX, IORING_OP_READ, IORING_OP_CLOSE};
+    size_t size = sizeof(struct io_uring_probe) + 256 * sizeof(struct io_uring_probe_op);
+    struct io_uring_probe * probe = calloc(1, size);
+    assert(probe);
+
+    bool supported = syscall(__NR_io_uring_register, fd, IORING_REGISTER_PROBE, probe, 256) == 0;
+
+    for (size_t i = 0; supported && i < sizeof(operations) / sizeof(operations[0]); i++) {
+        supported = operations[i] <= probe->last_op && (probe->ops[operations[i]].flags & IO_URING_OP_SUPPORTED) != 0;
+    }
+
+    free(probe);
+
+    return supported;
+}
+
+/* Returns NULL when io_uring is missing, disabled or too old. */
+static struct joint_loader_ring * joint_loader_ring_alloc(int depth) {
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+
+    /* Every file in flight has at most two operations pending. */
+    int fd = (int) syscall(__NR_io_uring_setup, (unsigned) depth * 2, &params);
+
+    if (fd < 0) {
+        return NULL;
+    }
+
+    if ((params.features & IORING_FEAT_SINGLE_MMAP) == 0 || !joint_loader_ring_supports(fd)) {
+        close(fd);
+        return NULL;
+    }
+
+    size_t sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    size_t cq_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    size_t rings_size = sq_size > cq_size ? sq_size : cq_size;
+    size_t sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+
+    void * rings = mmap(NULL, rings_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    void * sqes = rings != MAP_FAILED ? mmap(NULL, sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES) : MAP_FAILED;
+
+    if (sqes == MAP_FAILED) {
+        if (rings != MAP_FAILED) {
+            munmap(rings, rings_size);
+        }
+
+        close(fd);
+        return NULL;
+    }
+
+    struct joint_loader_ring * ring = malloc(sizeof(struct joint_loader_ring));
+    assert(ring);
+
+    ring->fd = fd;
+    ring->rings = rings;
+    ring->rings_size = rings_size;
+    ring->sqes = sqes;
+    ring->sqes_size = sqes_size;
+
+    ring->sq_head = (unsigned *) ((char *) rings + params.sq_off.head);
+    ring->sq_tail = (unsigned *) ((char *) rings + params.sq_off.tail);
+    ring->sq_mask = *(unsigned *) ((char *) rings + params.sq_off.ring_mask);
+    ring->sq_entries = params.sq_entries;
+    ring->sq_array = (unsigned *) ((char *) rings + params.sq_off.array);
+
+    ring->cq_head = (unsigned *) ((char *) rings + params.cq_off.head);
+    ring->cq_tail = (unsigned *) ((char *) rings + params.cq_off.tail);
+    ring->cq_mask = *(unsigned *) ((char *) rings + params.cq_off.ring_mask);
+    ring->cqes = (struct io_uring_cqe *) ((char *) rings + params.cq_off.cqes);
+
+    ring->queued = 0;
+    ring->statxes = malloc(sizeof(struct statx) * depth);
+    assert(ring->statxes);
+
+    return ring;
+}
+
+static struct io_uring_sqe * joint_loader_ring_queue(struct joint_loader_ring * ring, int file, enum joint_loader_operation operation) {
+    unsigned tail = *ring->sq_tail;
+    assert(tail - __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE) < ring->sq_entries);
+
+    unsigned index = tail & ring->sq_mask;
+    struct io_uring_sqe * sqe = &ring->sqes[index];
+
+    memset(sqe, 0, sizeof(struct io_uring_sqe));
+    sqe->opcode = (uint8_t) operation;
+    sqe->user_data = (uint64_t) file << 2 | (uint64_t) operation;
+
+    ring->sq_array[index] = index;
+    __atomic_store_n(ring->sq_tail, tail + 1, __ATOMIC_RELEASE);
+    ring->queued++;
+
+    return sqe;
+}
+
+static void joint_loader_ring_start(joint_loader_t * loader, int file) {
+    struct joint_loader_ring * ring = loader->ring;
+    const char * path = loader->files[file].path;
+
+    struct io_uring_sqe * open = joint_loader_ring_queue(ring, file, OPEN_LOADER_OPERATION);
+    open->opcode = IORING_OP_OPENAT;
+    open->fd = AT_FDCWD;
+    open->addr = (uint64_t) (uintptr_t) path;
+    open->open_flags = O_RDONLY | O_CLOEXEC;
+
+    struct io_uring_sqe * statx = joint_loader_ring_queue(ring, file, STATX_LOADER_OPERATION);
+    statx->opcode = IORING_OP_STATX;
+    statx->fd = AT_FDCWD;
+    statx->addr = (uint64_t) (uintptr_t) path;
+    statx->len = STATX_SIZE | STATX_TYPE;
+    statx->off = (uint64_t) (uintptr_t) &ring->statxes[file % loader->depth];
+
+    loader->files[file].steps = 2;
+}
+
+static void joint_loader_ring_read(joint_loader_t * loader, int file) {
+    joint_loader_file_t * loader_file = &loader->files[file];
+    struct io_uring_sqe * read = joint_loader_ring_queue(loader->ring, file, READ_LOADER_OPERATION);
+
+    read->opcode = IORING_OP_READ;
+    read->fd = loader_file->fd;
+    read->addr = (uint64_t) (uintptr_t) (loader_file->data + loader_file->length);
+    size_t length = loader_file->capacity - loader_file->length;
+
+    read->len = (uint32_t) (length < (1u << 30) ? length : (1u << 30));
+    read->off = loader_file->length;
+    loader_file->steps = 1;
+}
+
+static void joint_loader_ring_close(joint_loader_t * loader, int file) {
+    struct io_uring_sqe * close = joint_loader_ring_queue(loader->ring, file, CLOSE_LOADER_OPERATION);
+
+    close->opcode = IORING_OP_CLOSE;
+    close->fd = loader->files[file].fd;
+    loader->files[file].steps = 1;
+}
+
+/* Moves the file one step further once all of its operations are done. */
+static void joint_loader_ring_complete(joint_loader_t * loader, int file, enum joint_loader_operation operation, int result) {
+    joint_loader_file_t * loader_file = &loader->files[file];
+    const struct statx * status = &loader->ring->statxes[file % loader->depth];
+
+    loader_file->failed = loader_file->failed || (result < 0 && operation != CLOSE_LOADER_OPERATION);
+
+    switch (operation) {
+        case OPEN_LOADER_OPERATION:
+            loader_file->fd = result;
+            break;
+
+        case READ_LOADER_OPERATION:
+            loader_file->length += result > 0 ? (size_t) result : 0;
+            break;
+
+        default:
+            break;
+    }
+
+    if (--loader_file->steps > 0) {
+        return;
+    }
+
+    if (operation == CLOSE_LOADER_OPERATION || (loader_file->failed && loader_file->fd < 0)) {
+        loader_file->loaded = true;
+        return;
+    }
+
+    if (loader_file->failed) {
+        joint_loader_ring_close(loader, file);
+        return;
+    }
+
+    if (operation == STATX_LOADER_OPERATION || operation == OPEN_LOADER_OPERATION) {
+        /* Files without a size, like pipes, are read until their end. */
+        loader_file->sized = S_ISREG(status->stx_mode) && status->stx_size > 0;
+        loader_file->capacity = loader_file->sized ? (size_t) status->stx_size : 4096;
+        loader_file->data = JOINT_ALLOCATE(loader->allocator, sizeof(char) * (loader_file->capacity + 1));
+        assert(loader_file->data);
+        joint_loader_ring_read(loader, file);
+        return;
+    }
+
+    if (result == 0 || (loader_file->sized && loader_file->length == loader_file->capacity)) {
+        joint_loader_ring_close(loader, file);
+        return;
+    }
+
+    if (loader_file->length == loader_file->capacity) {
+        loader_file->capacity *= 2;
+        loader_file->data = JOINT_REALLOCATE(loader->allocator, loader_file->data, sizeof(char) * (loader_file->capacity + 1));
+        assert(loader_file->data);
+    }
+
+    joint_loader_ring_read(loader, file);
+}
+
+/* Submits the queued operations and handles completions, waiting for at
+ * least one when wait is set. */
+static void joint_loader_ring_enter(joint_loader_t * loader, bool wait) {
+    struct joint_loader_ring * ring = loader->ring;
+    int entered;
+
+    do {
+        entered = (int) syscall(__NR_io_uring_enter, ring->fd, ring->queued, wait ? 1 : 0, wait ? IORING_ENTER_GETEVENTS : 0, NULL, 0);
+    } while (entered < 0 && errno == EINTR);
+
+    assert(entered >= 0);
+    ring->queued -= (unsigned) entered;
+
+    unsigned head = *ring->cq_head;
+    unsigned tail = __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE);
+
+    for (; head != tail; head++) {
+        const struct io_uring_cqe * cqe = &ring->cqes[head & ring->cq_mask];
+        joint_loader_ring_complete(loader, (int) (cqe->user_data >> 2), (enum joint_loader_operation) (cqe->user_data & 3), cqe->res);
+    }
+
+    __atomic_store_n(ring->cq_head, head, __ATOMIC_RELEASE);
+}
+
+static void joint_loader_ring_free(struct joint_loader_ring * ring) {
+    munmap(ring->sqes, ring->sqes_size);
+    munmap(ring->rings, ring->rings_size);
+    close(ring->fd);
+    free(ring->statxes);
+    free(ring);
+}
+
+#endif
+
+struct joint_loader_pool {
+    pthread_mutex_t mutex;
+    pthread_cond_t work;
+    pthread_cond_t loaded;
+    int claimed_files;
+    bool stopping;
+    pthread_t threads[JOINT_LOADER_THREADS];
+};
+
+static void * joint_loader_pool_work(void * data) {
+    joint_loader_t * loader = data;
+    struct joint_loader_pool * pool = loader->pool;
+
+    pthread_mutex_lock(&pool->mutex);
+
+    while (true) {
+        while (!pool->stopping && pool->claimed_files == loader->started_files) {
+            pthread_cond_wait(&pool->work, &pool->mutex);
+        }
+
+        if (pool->stopping) {
+            break;
+        }
+
+        int file = pool->claimed_files++;
+        const char * path = loader->files[file].path;
+        char * content;
+        size_t length;
+
+        pthread_mutex_unlock(&pool->mutex);
+        bool loaded = joint_source_file_load(loader->allocator, path, &content, &length);
+        pthread_mutex_lock(&pool->mutex);
+
+        loader->files[file].data = loaded ? content : NULL;
+        loader->files[file].length = loaded ? length : 0;
+        loader->files[file].failed = !loaded;
+        loader->files[file].loaded = true;
+        pthread_cond_broadcast(&pool->loaded);
+    }
+
+    pthread_mutex_unlock(&pool->mutex);
+
+    return NULL;
+}
+
+static struct joint_loader_pool * joint_loader_pool_alloc(joint_loader_t * loader) {
+    struct joint_loader_pool * pool = malloc(sizeof(struct joint_loader_pool));
+    assert(pool);
+
+    pthread_mutex_init(&pool->mutex, NULL);
+    pthread_cond_init(&pool->work, NULL);
+    pthread_cond_init(&pool->loaded, NULL);
+    pool->claimed_files = 0;
+    pool->stopping = false;
+    loader->pool = pool;
+
+    for (int i = 0; i < JOINT_LOADER_THREADS; i++) {
+        int created = pthread_create(&pool->threads[i], NULL, joint_loader_pool_work, loader);
+        assert(created == 0);
+    }
+
+    return pool;
+}
+
+static void joint_loader_pool_free(struct joint_loader_pool * pool) {
+    pthread_mutex_lock(&pool->mutex);
+    pool->stopping = true;
+    pthread_cond_broadcast(&pool->work);
+    pthread_mutex_unlock(&pool->mutex);
+
+    for (int i = 0; i < JOINT_LOADER_THREADS; i++) {
+        pthread_join(pool->threads[i], NULL);
+    }
+
+    pthread_cond_destroy(&pool->loaded);
+    pthread_cond_destroy(&pool->work);
+    pthread_mutex_destroy(&pool->mutex);
+    free(pool);
+}
+
+/* Refills the window once half of it is consumed, so files are started
+ * and submitted in batches. */
+static void joint_loader_start(joint_loader_t * loader) {
+    int window_end = loader->next_file + loader->depth;
+    int end = loader->files_length < window_end ? loader->files_length : window_end;
+
+    if (loader->started_files - loader->next_file > loader->depth / 2) {
+        return;
+    }
+
+    if (loader->pool != NULL) {
+        if (loader->started_files < end) {
+            loader->started_files = end;
+            pthread_cond_broadcast(&loader->pool->work);
+        }
+
+        return;
+    }
+
+#ifdef JOINT_LOADER_IO_URING
+    for (; loader->started_files < end; loader->started_files++) {
+        joint_loader_ring_start(loader, loader->started_files);
+    }
+
+    if (loader->ring->queued > 0) {
+        joint_loader_ring_enter(loader, false);
+    }
+#endif
+}
+
+joint_loader_t * joint_loader_alloc(joint_allocator_t * allocator, int depth) {
+    joint_loader_t * loader = malloc(sizeof(joint_loader_t));
+    assert(loader);
+
+    loader->allocator = allocator;
+    loader->depth = depth;
+
+    loader->files_length = 0;
+    loader->files_capacity = 0;
+    loader->files = NULL;
+    loader->started_files = 0;
+    loader->next_file = 0;
+
+    loader->ring = NULL;
+    loader->pool = NULL;
+
+    loader->stats.files = 0;
+    loader->stats.bytes = 0;
+    loader->stats.wait_time = 0;
+
+#ifdef JOINT_LOADER_IO_URING
+    loader->ring = joint_loader_ring_alloc(depth);
+#endif
+
+    if (loader->ring == NULL) {
+        joint_loader_pool_alloc(loader);
+    }
+
+    return loader;
+}
+
+void joint_loader_submit(joint_loader_t * loader, const char * path) {
+    if (loader->pool != NULL) {
+        pthread_mutex_lock(&loader->pool->mutex);
+    }
+
+    if (loader->files_length == loader->files_capacity) {
+        loader->files_capacity = loader->files_capacity > 0 ? loader->files_capacity * 2 : 16;
+        loader->files = realloc(loader->files, sizeof(joint_loader_file_t) * loader->files_capacity);
+        assert(loader->files);
+    }
+
+    joint_loader_file_t * file = &loader->files[loader->files_length++];
+
+    file->path = malloc(sizeof(char) * (strlen(path) + 1));
+    assert(file->path);
+    strcpy(file->path, path);
+
+    file->data = NULL;
+    file->length = 0;
+    file->capacity = 0;
+    file->fd = -1;
+    file->steps = 0;
+    file->sized = false;
+    file->failed = false;
+    file->loaded = false;
+
+    if (loader->pool != NULL) {
+        pthread_mutex_unlock(&loader->pool->mutex);
+    }
+}
+
+joint_source_file_t * joint_loader_next(joint_loader_t * loader) {
+    assert(loader->next_file < loader->files_length);
+
+    joint_loader_file_t * file = &loader->files[loader->next_file];
+    uint64_t started_at = joint_stats_now();
+
+    if (loader->pool != NULL) {
+        pthread_mutex_lock(&loader->pool->mutex);
+    }
+
+    joint_loader_start(loader);
+
+    if (loader->pool != NULL) {
+        while (!loader->files[loader->next_file].loaded) {
+            pthread_cond_wait(&loader->pool->loaded, &loader->pool->mutex);
+        }
+
+        file = &loader->files[loader->next_file];
+    }
+
+#ifdef JOINT_LOADER_IO_URING
+    while (loader->ring != NULL && !file->loaded) {
+        joint_loader_ring_enter(loader, true);
+    }
+#endif
+
+    loader->stats.wait_time += joint_stats_now() - started_at;
+
+    joint_source_file_t * source_file = NULL;
+
+    if (!file->failed) {
+        if (file->capacity != 0 && file->length != file->capacity) {
+            file->data = JOINT_REALLOCATE(loader->allocator, file->data, sizeof(char) * (file->length + 1));
+            assert(file->data);
+        }
+
+        file->data[file->length] = '\0';
+        source_file = joint_source_file_alloc(loader->allocator, file->path);
+        joint_source_file_adopt(source_file, file->data, file->length);
+
+        loader->stats.files++;
+        loader->stats.bytes += file->length;
+    } else if (file->data != NULL) {
+        JOINT_DEALLOCATE(loader->allocator, file->data);
+    }
+
+    file->data = NULL;
+    loader->next_file++;
+
+    if (loader->pool != NULL) {
+        pthread_mutex_unlock(&loader->pool->mutex);
+    }
+
+    if (source_file != NULL && !joint_source_file_validate(source_file)) {
+        joint_source_file_free(source_file);
+        source_file = NULL;
+    }
+
+    return source_file;
+}
+
+void joint_loader_free(joint_loader_t * loader) {
+    if (loader->pool != NULL) {
+        joint_loader_pool_free(loader->pool);
+    }
+
+#ifdef JOINT_LOADER_IO_URING
+    if (loader->ring != NULL) {
+        for (int i = loader->next_file; i < loader->started_files; i++) {
+            while (!loader->files[i].loaded) {
+                joint_loader_ring_enter(loader, true);
+            }
+        }
+
+        joint_loader_ring_free(loader->ring);
+    }
+#endif
+
+    for (int i = 0; i < loader->files_length; i++) {
+        if (loader->files[i].data != NULL) {
+            JOINT_DEALLOCATE(loader->allocator, loader->files[i].data);
+        }
+
+        free(loader->files[i].path);
+    }
+
+    free(loader->files);
+    free(loader);
+}
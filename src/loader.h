@@ -0,0 +1,84 @@
+/* Copyright (c) 2014 Vyacheslav Slinko
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef joint_loader_h
+#define joint_loader_h
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "allocator.h"
+#include "source_file.h"
+
+/* Files submitted to a loader are loaded at most depth at a time ahead of
+ * the one handed out last, so they are read while the caller tokenizes and
+ * parses the previous ones. Opens, statx calls and reads of the whole batch
+ * go through one io_uring when the kernel supports it, and through a pool of
+ * threads with blocking reads otherwise. */
+
+#define JOINT_LOADER_DEPTH 32
+
+typedef struct joint_loader_file {
+    char * path;
+    char * data;
+    size_t length;
+    size_t capacity;
+    int fd;
+    int steps;
+    bool sized;
+    bool failed;
+    bool loaded;
+} joint_loader_file_t;
+
+typedef struct joint_loader_stats {
+    int files;
+    uint64_t bytes;
+    /* Time joint_loader_next spent waiting for files still being loaded. */
+    uint64_t wait_time;
+} joint_loader_stats_t;
+
+typedef struct joint_loader {
+    joint_allocator_t * allocator;
+    int depth;
+
+    int files_length;
+    int files_capacity;
+    joint_loader_file_t * files;
+    int started_files;
+    int next_file;
+
+    struct joint_loader_ring * ring;
+    struct joint_loader_pool * pool;
+
+    joint_loader_stats_t stats;
+} joint_loader_t;
+
+/* Contents are allocated from allocator. */
+joint_loader_t * joint_loader_alloc(joint_allocator_t * allocator, int depth);
+
+void joint_loader_submit(joint_loader_t * loader, const char * path);
+
+/* Returns the next submitted file in submission order, waiting for it when
+ * it is still loading, or NULL when it can not be read or is not UTF-8. */
+joint_source_file_t * joint_loader_next(joint_loader_t * loader);
+
+void joint_loader_free(joint_loader_t * loader);
+
+#endif
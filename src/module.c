@@ -0,0 +1,288 @@
+/* Copyright (c) 2014 Vyacheslav Slinko
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <assert.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "module.h"
+#include "parser.h"
+
+char * joint_module_resolve_import(const char * importer_path, const char * source) {
+    const char * directory_end = strrchr(importer_path, '/');
+    size_t directory_length = directory_end == NULL ? 0 : (size_t) (directory_end - importer_path + 1);
+    size_t source_length = strlen(source);
+    bool has_extension = source_length >= 6 && strcmp(source + source_length - 6, ".joint") == 0;
+
+    char * candidate = malloc(sizeof(char) * (directory_length + source_length + 7));
+    assert(candidate);
+    memcpy(candidate, importer_path, directory_length);
+    strcpy(candidate + directory_length, source);
+
+    if (!has_extension) {
+        strcat(candidate, ".joint");
+    }
+
+    char * path = realpath(candidate, NULL);
+    free(candidate);
+
+    return path;
+}
+
+joint_module_t * joint_module_alloc(const char * path) {
+    joint_module_t * module = malloc(sizeof(joint_module_t));
+    assert(module);
+
+    module->path = malloc(sizeof(char) * (strlen(path) + 1));
+    assert(module->path);
+    strcpy(module->path, path);
+
+    module->source_file = NULL;
+    module->tokenizer = NULL;
+    module->program = NULL;
+
+    module->imports_length = 0;
+    module->imports = NULL;
+
+    return module;
+}
+
+bool joint_module_read(joint_module_t * module) {
+    joint_source_file_t * source_file = joint_source_file_alloc(joint_allocator_system(), module->path);
+
+    if (!joint_source_file_read(source_file)) {
+        joint_source_file_free(source_file);
+        return false;
+    }
+
+    joint_module_replace(module, source_file, NULL, NULL);
+
+    return true;
+}
+
+bool joint_module_compile(joint_module_t * module) {
+    joint_tokenizer_t * tokenizer = joint_tokenizer_alloc(module->source_file->allocator, module->source_file);
+    joint_tokenizer_tokenize(tokenizer);
+
+    joint_parser_t * parser = joint_parser_alloc(module->source_file->allocator, tokenizer);
+
+    if (!joint_parser_parse(parser)) {
+        joint_parser_print_error(parser);
+        joint_parser_free(parser);
+        joint_tokenizer_free(tokenizer);
+        return false;
+    }
+
+    joint_node_t * program = parser->program;
+    parser->program = NULL;
+    joint_parser_free(parser);
+
+    joint_module_replace(module, module->source_file, tokenizer, program);
+
+    return true;
+}
+
+static void joint_module_release(joint_module_t * module, bool release_source_file) {
+    if (module->program != NULL) {
+        joint_node_free(module->program);
+        module->program = NULL;
+    }
+
+    if (module->tokenizer != NULL) {
+        joint_tokenizer_free(module->tokenizer);
+        module->tokenizer = NULL;
+    }
+
+    if (release_source_file && module->source_file != NULL) {
+        joint_source_file_free(module->source_file);
+        module->source_file = NULL;
+    }
+
+    for (int i = 0; i < module->imports_length; i++) {
+        free(module->imports[i]);
+    }
+
+    if (module->imports != NULL) {
+        free(module->imports);
+        module->imports = NULL;
+    }
+
+    module->imports_length = 0;
+}
+
+static void joint_module_add_imports(joint_module_t * module, const joint_node_t * program) {
+    for (int i = 0; i < program->childrens_length; i++) {
+        joint_node_t * element = program->childrens[i]->node;
+
+        if (element->type != IMPORT_DECLARATION_NODE) {
+            continue;
+        }
+
+        for (int j = 0; j < element->childrens_length; j++) {
+            if (strcmp(element->childrens[j]->name, "source") != 0) {
+                continue;
+            }
+
+            char * path = joint_module_resolve_import(module->path, element->childrens[j]->node->childrens[0]->string);
+
+            if (path == NULL) {
+                continue;
+            }
+
+            module->imports = realloc(module->imports, sizeof(char *) * (module->imports_length + 1));
+            assert(module->imports);
+            module->imports[module->imports_length++] = path;
+        }
+    }
+}
+
+void joint_module_replace(joint_module_t * module, joint_source_file_t * source_file, joint_tokenizer_t * tokenizer, joint_node_t * program) {
+    joint_module_release(module, source_file != module->source_file);
+
+    module->source_file = source_file;
+    module->tokenizer = tokenizer;
+    module->program = program;
+
+    if (program != NULL) {
+        joint_module_add_imports(module, program);
+    }
+}
+
+bool joint_module_imports(const joint_module_t * module, const char * path) {
+    for (int i = 0; i < module->imports_length; i++) {
+        if (strcmp(module->imports[i], path) == 0) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static int joint_module_find(joint_module_t ** modules, int modules_length, const char * path) {
+    for (int i = 0; i < modules_length; i++) {
+        if (strcmp(modules[i]->path, path) == 0) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+bool joint_module_load_imports(const joint_node_t * program, joint_module_t *** loaded, int * modules_length) {
+    int stack_length = 1;
+    joint_module_t ** stack = malloc(sizeof(joint_module_t *) * 8);
+    int * next_imports = malloc(sizeof(int) * 8);
+    int stack_capacity = 8;
+    joint_module_t ** modules = NULL;
+    bool failed = false;
+
+    assert(stack && next_imports);
+    *modules_length = 0;
+
+    stack[0] = joint_module_alloc(program->start_position->path);
+    joint_module_add_imports(stack[0], program);
+    next_imports[0] = 0;
+
+    /* A depth first walk, a module is done once all of its imports are. */
+    while (stack_length > 0 && !failed) {
+        joint_module_t * module = stack[stack_length - 1];
+
+        if (next_imports[stack_length - 1] == module->imports_length) {
+            if (--stack_length > 0) {
+                modules = realloc(modules, sizeof(joint_module_t *) * (*modules_length + 1));
+                assert(modules);
+                modules[(*modules_length)++] = module;
+            }
+
+            continue;
+        }
+
+        const char * path = module->imports[next_imports[stack_length - 1]++];
+
+        if (joint_module_find(modules, *modules_length, path) >= 0) {
+            continue;
+        }
+
+        if (joint_module_find(stack, stack_length, path) >= 0) {
+            fprintf(stderr, "%s: Import cycle through \"%s\"\n", module->path, path);
+            failed = true;
+            continue;
+        }
+
+        joint_module_t * import = joint_module_alloc(path);
+
+        if (!joint_module_read(import)) {
+            fprintf(stderr, "Unable to read file \"%s\"\n", path);
+            joint_module_free(import);
+            failed = true;
+            continue;
+        }
+
+        if (!joint_module_compile(import)) {
+            joint_module_free(import);
+            failed = true;
+            continue;
+        }
+
+        if (stack_length == stack_capacity) {
+            stack_capacity *= 2;
+            stack = realloc(stack, sizeof(joint_module_t *) * stack_capacity);
+            next_imports = realloc(next_imports, sizeof(int) * stack_capacity);
+            assert(stack && next_imports);
+        }
+
+        stack[stack_length] = import;
+        next_imports[stack_length++] = 0;
+    }
+
+    if (failed) {
+        for (int i = 0; i < stack_length; i++) {
+            joint_module_free(stack[i]);
+        }
+
+        joint_module_free_all(modules, *modules_length);
+        modules = NULL;
+    } else {
+        joint_module_free(stack[0]);
+    }
+
+    free(stack);
+    free(next_imports);
+
+    *loaded = modules;
+
+    return !failed;
+}
+
+void joint_module_free_all(joint_module_t ** modules, int modules_length) {
+    for (int i = 0; i < modules_length; i++) {
+        joint_module_free(modules[i]);
+    }
+
+    free(modules);
+}
+
+void joint_module_free(joint_module_t * module) {
+    joint_module_release(module, true);
+    free(module->path);
+    free(module);
+}
@@ -0,0 +1,63 @@
+/* Copyright (c) 2014 Vyacheslav Slinko
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef joint_module_h
+#define joint_module_h
+
+#include <stdbool.h>
+#include "node.h"
+#include "source_file.h"
+#include "tokenizer.h"
+
+typedef struct joint_module {
+    char * path;
+    joint_source_file_t * source_file;
+    joint_tokenizer_t * tokenizer;
+    joint_node_t * program;
+
+    int imports_length;
+    char ** imports;
+} joint_module_t;
+
+char * joint_module_resolve_import(const char * importer_path, const char * source);
+
+joint_module_t * joint_module_alloc(const char * path);
+
+bool joint_module_read(joint_module_t * module);
+
+/* Keeps the previous program when the source has a syntax error. */
+bool joint_module_compile(joint_module_t * module);
+
+void joint_module_replace(joint_module_t * module, joint_source_file_t * source_file, joint_tokenizer_t * tokenizer, joint_node_t * program);
+
+bool joint_module_imports(const joint_module_t * module, const char * path);
+
+/* Reads and parses the modules imported by program, directly or through
+ * other modules, ordered so that every module comes after its imports.
+ * Imports that do not resolve to a file are left out. Reports unreadable
+ * modules, syntax errors and import cycles to stderr and returns false. */
+bool joint_module_load_imports(const joint_node_t * program, joint_module_t *** modules, int * modules_length);
+
+void joint_module_free_all(joint_module_t ** modules, int modules_length);
+
+void joint_module_free(joint_module_t * module);
+
+#endif
@@ -0,0 +1,404 @@
+/* Copyright (c) 2014 Vyacheslav Slinko
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include "dump.h"
+#include "node.h"
+#include "writer.h"
+
+static const char * joint_node_type_names[] = {
+    "PROGRAM_NODE",
+    "COMMENT_NODE",
+    "IDENTIFIER_NODE",
+    "LITERAL_NODE",
+    "CALL_EXPRESSION_NODE",
+    "IMPORT_DECLARATION_NODE",
+    "VARIABLE_DECLARATION_NODE",
+    "BINARY_EXPRESSION_NODE",
+    "UNARY_EXPRESSION_NODE"
+};
+
+static char * joint_node_children_names[] = {
+    "argument",
+    "body",
+    "callee",
+    "id",
+    "init",
+    "left",
+    "operator",
+    "optional",
+    "right",
+    "source",
+    "specifier",
+    "type",
+    "value"
+};
+
+joint_source_file_position_t * joint_node_clone_position(joint_allocator_t * allocator, const joint_source_file_position_t * position) {
+    joint_source_file_position_t * cloned_position = JOINT_ALLOCATE(allocator, sizeof(joint_source_file_position_t));
+    assert(cloned_position);
+    cloned_position->path = JOINT_ALLOCATE(allocator, sizeof(char) * (strlen(position->path) + 1));
+    assert(cloned_position->path);
+    strcpy(cloned_position->path, position->path);
+    cloned_position->position = position->position;
+    cloned_position->line = position->line;
+    cloned_position->column = position->column;
+    cloned_position->code_point_column = position->code_point_column;
+    return cloned_position;
+}
+
+void joint_node_free_position(joint_allocator_t * allocator, joint_source_file_position_t * position) {
+    JOINT_DEALLOCATE(allocator, position->path);
+    JOINT_DEALLOCATE(allocator, position);
+}
+
+joint_node_t * joint_node_alloc(joint_allocator_t * allocator, enum joint_node_type type, const joint_source_file_position_t * start_position) {
+    joint_node_t * node = JOINT_ALLOCATE(allocator, sizeof(joint_node_t));
+    assert(node);
+    node->allocator = allocator;
+    node->type = type;
+    node->childrens_length = 0;
+    node->childrens = NULL;
+    node->start_position = joint_node_clone_position(allocator, start_position);
+    node->end_position = NULL;
+    return node;
+}
+
+static void joint_node_attach_children(joint_node_t * node, joint_node_children_t * children) {
+    if (node->childrens_length == 0) {
+        node->childrens = JOINT_ALLOCATE(node->allocator, sizeof(joint_node_children_t *));
+    } else {
+        node->childrens = JOINT_REALLOCATE(node->allocator, node->childrens, sizeof(joint_node_children_t *) * (node->childrens_length + 1));
+    }
+    assert(node->childrens);
+    node->childrens[node->childrens_length++] = children;
+}
+
+void joint_node_attach_node(joint_node_t * node, char * name, joint_node_t * related) {
+    joint_node_children_t * relation = JOINT_ALLOCATE(node->allocator, sizeof(joint_node_children_t));
+    assert(relation);
+    relation->type = NODE_CHILDREN;
+    relation->constant = -1;
+    relation->name = name;
+    relation->node = related;
+    joint_node_attach_children(node, relation);
+}
+
+void joint_node_attach_number(joint_node_t * node, char * name, long double number) {
+    joint_node_children_t * relation = JOINT_ALLOCATE(node->allocator, sizeof(joint_node_children_t));
+    assert(relation);
+    relation->type = NUMBER_CHILDREN;
+    relation->constant = -1;
+    relation->name = name;
+    relation->number = number;
+    joint_node_attach_children(node, relation);
+}
+
+void joint_node_attach_boolean(joint_node_t * node, char * name, bool boolean) {
+    joint_node_children_t * relation = JOINT_ALLOCATE(node->allocator, sizeof(joint_node_children_t));
+    assert(relation);
+    relation->type = BOOLEAN_CHILDREN;
+    relation->constant = -1;
+    relation->name = name;
+    relation->boolean = boolean;
+    joint_node_attach_children(node, relation);
+}
+
+void joint_node_attach_character(joint_node_t * node, char * name, char character) {
+    joint_node_children_t * relation = JOINT_ALLOCATE(node->allocator, sizeof(joint_node_children_t));
+    assert(relation);
+    relation->type = CHARACTER_CHILDREN;
+    relation->constant = -1;
+    relation->name = name;
+    relation->character = character;
+    joint_node_attach_children(node, relation);
+}
+
+void joint_node_attach_string(joint_node_t * node, char * name, const char * string) {
+    joint_node_children_t * relation = JOINT_ALLOCATE(node->allocator, sizeof(joint_node_children_t));
+    assert(relation);
+
+    relation->type = STRING_CHILDREN;
+    relation->constant = -1;
+    relation->name = name;
+
+    relation->string = JOINT_ALLOCATE(node->allocator, sizeof(char) * (strlen(string) + 1));
+    assert(relation->string);
+    strcpy(relation->string, string);
+
+    joint_node_attach_children(node, relation);
+}
+
+void joint_node_attach_null(joint_node_t * node, char * name) {
+    joint_node_children_t * relation = JOINT_ALLOCATE(node->allocator, sizeof(joint_node_children_t));
+    assert(relation);
+    relation->type = NULL_CHILDREN;
+    relation->constant = -1;
+    relation->name = name;
+    joint_node_attach_children(node, relation);
+}
+
+void joint_node_attach_scalar(joint_node_t * node, const joint_node_children_t * scalar) {
+    assert(scalar->type != NODE_CHILDREN);
+
+    if (scalar->type == STRING_CHILDREN && scalar->constant == -1) {
+        joint_node_attach_string(node, scalar->name, scalar->string);
+        return;
+    }
+
+    joint_node_children_t * relation = JOINT_ALLOCATE(node->allocator, sizeof(joint_node_children_t));
+    assert(relation);
+    *relation = *scalar;
+    joint_node_attach_children(node, relation);
+}
+
+static void joint_node_free_children(joint_allocator_t * allocator, joint_node_children_t * children) {
+    switch (children->type) {
+        case NODE_CHILDREN:
+            joint_node_free(children->node);
+            break;
+
+        case STRING_CHILDREN:
+            if (children->constant == -1) {
+                JOINT_DEALLOCATE(allocator, children->string);
+            }
+            break;
+
+        default:
+            break;
+    }
+
+    JOINT_DEALLOCATE(allocator, children);
+}
+
+void joint_node_splice_nodes(joint_node_t * node, int index, int removed_length, char * name, joint_node_t ** inserted, int inserted_length) {
+    assert(index >= 0 && removed_length >= 0 && index + removed_length <= node->childrens_length);
+
+    for (int i = index; i < index + removed_length; i++) {
+        joint_node_free_children(node->allocator, node->childrens[i]);
+    }
+
+    int childrens_length = node->childrens_length - removed_length + inserted_length;
+
+    if (inserted_length > removed_length) {
+        node->childrens = JOINT_REALLOCATE(node->allocator, node->childrens, sizeof(joint_node_children_t *) * childrens_length);
+        assert(node->childrens);
+    }
+
+    memmove(node->childrens + index + inserted_length, node->childrens + index + removed_length, sizeof(joint_node_children_t *) * (node->childrens_length - index - removed_length));
+
+    for (int i = 0; i < inserted_length; i++) {
+        joint_node_children_t * relation = JOINT_ALLOCATE(node->allocator, sizeof(joint_node_children_t));
+        assert(relation);
+        relation->type = NODE_CHILDREN;
+        relation->constant = -1;
+        relation->name = name;
+        relation->node = inserted[i];
+        node->childrens[index + i] = relation;
+    }
+
+    node->childrens_length = childrens_length;
+
+    if (childrens_length == 0 && node->childrens != NULL) {
+        JOINT_DEALLOCATE(node->allocator, node->childrens);
+        node->childrens = NULL;
+    }
+}
+
+void joint_node_remove_childrens(joint_node_t * node, const bool * removed) {
+    int childrens_length = 0;
+
+    for (int i = 0; i < node->childrens_length; i++) {
+        if (removed[i]) {
+            joint_node_free_children(node->allocator, node->childrens[i]);
+        } else {
+            node->childrens[childrens_length++] = node->childrens[i];
+        }
+    }
+
+    node->childrens_length = childrens_length;
+
+    if (childrens_length == 0 && node->childrens != NULL) {
+        JOINT_DEALLOCATE(node->allocator, node->childrens);
+        node->childrens = NULL;
+    }
+}
+
+joint_node_walker_t * joint_node_walker_alloc(void) {
+    joint_node_walker_t * walker = malloc(sizeof(joint_node_walker_t));
+    assert(walker);
+
+    walker->frames_length = 0;
+    walker->frames_capacity = 32;
+    walker->frames = malloc(sizeof(joint_node_walk_frame_t) * walker->frames_capacity);
+    assert(walker->frames);
+
+    return walker;
+}
+
+static void joint_node_walker_push(joint_node_walker_t * walker, joint_node_t * node, const joint_node_children_t * relation) {
+    if (walker->frames_length == walker->frames_capacity) {
+        walker->frames_capacity *= 2;
+        walker->frames = realloc(walker->frames, sizeof(joint_node_walk_frame_t) * walker->frames_capacity);
+        assert(walker->frames);
+    }
+
+    joint_node_walk_frame_t * frame = &walker->frames[walker->frames_length++];
+    frame->node = node;
+    frame->relation = relation;
+    frame->next_children = 0;
+}
+
+bool joint_node_walker_walk(joint_node_walker_t * walker, joint_node_t * root, const joint_node_visitor_t * visitor) {
+    joint_node_walk_action_t action = JOINT_NODE_WALK_CONTINUE;
+
+    walker->frames_length = 0;
+
+    if (visitor->enter != NULL) {
+        action = visitor->enter(root, NULL, 0, visitor->data);
+    }
+
+    if (action == JOINT_NODE_WALK_STOP) {
+        return false;
+    }
+
+    joint_node_walker_push(walker, root, NULL);
+
+    if (action == JOINT_NODE_WALK_SKIP) {
+        walker->frames[0].next_children = root->childrens_length;
+    }
+
+    while (walker->frames_length > 0) {
+        joint_node_walk_frame_t * frame = &walker->frames[walker->frames_length - 1];
+        int depth = walker->frames_length;
+
+        if (frame->next_children >= frame->node->childrens_length) {
+            joint_node_t * node = frame->node;
+            const joint_node_children_t * relation = frame->relation;
+            walker->frames_length--;
+
+            if (visitor->leave != NULL && visitor->leave(node, relation, depth - 1, visitor->data) == JOINT_NODE_WALK_STOP) {
+                return false;
+            }
+
+            continue;
+        }
+
+        joint_node_children_t * children = frame->node->childrens[frame->next_children++];
+
+        if (children->type != NODE_CHILDREN) {
+            if (visitor->scalar != NULL && visitor->scalar(frame->node, children, depth - 1, visitor->data) == JOINT_NODE_WALK_STOP) {
+                return false;
+            }
+
+            continue;
+        }
+
+        action = JOINT_NODE_WALK_CONTINUE;
+
+        if (visitor->enter != NULL) {
+            action = visitor->enter(children->node, children, depth, visitor->data);
+        }
+
+        if (action == JOINT_NODE_WALK_STOP) {
+            return false;
+        }
+
+        joint_node_walker_push(walker, children->node, children);
+
+        if (action == JOINT_NODE_WALK_SKIP) {
+            walker->frames[walker->frames_length - 1].next_children = children->node->childrens_length;
+        }
+    }
+
+    return true;
+}
+
+void joint_node_walker_free(joint_node_walker_t * walker) {
+    free(walker->frames);
+    free(walker);
+}
+
+bool joint_node_walk(joint_node_t * root, const joint_node_visitor_t * visitor) {
+    joint_node_walker_t * walker = joint_node_walker_alloc();
+    bool completed = joint_node_walker_walk(walker, root, visitor);
+    joint_node_walker_free(walker);
+    return completed;
+}
+
+char * joint_node_children_name(const char * name) {
+    for (size_t i = 0; i < sizeof(joint_node_children_names) / sizeof(joint_node_children_names[0]); i++) {
+        if (strcmp(joint_node_children_names[i], name) == 0) {
+            return joint_node_children_names[i];
+        }
+    }
+
+    return NULL;
+}
+
+const char * joint_node_type_name(enum joint_node_type type) {
+    if ((size_t) type >= sizeof(joint_node_type_names) / sizeof(joint_node_type_names[0])) {
+        return NULL;
+    }
+
+    return joint_node_type_names[type];
+}
+
+void joint_node_print(joint_node_t * root) {
+    joint_writer_t * writer = joint_writer_alloc(1, 65536);
+    joint_dump_node(writer, root, TEXT_DUMP_FORMAT);
+    joint_writer_free(writer);
+}
+
+static joint_node_walk_action_t joint_node_free_leave(joint_node_t * node, const joint_node_children_t * relation, int depth, void * data) {
+    for (int i = 0; i < node->childrens_length; i++) {
+        if (node->childrens[i]->type == STRING_CHILDREN && node->childrens[i]->constant == -1) {
+            JOINT_DEALLOCATE(node->allocator, node->childrens[i]->string);
+        }
+
+        JOINT_DEALLOCATE(node->allocator, node->childrens[i]);
+    }
+
+    if (node->childrens != NULL) {
+        JOINT_DEALLOCATE(node->allocator, node->childrens);
+    }
+
+    joint_node_free_position(node->allocator, node->start_position);
+
+    /* Nodes left open by a syntax error have no end. */
+    if (node->end_position != NULL) {
+        joint_node_free_position(node->allocator, node->end_position);
+    }
+
+    JOINT_DEALLOCATE(node->allocator, node);
+
+    return JOINT_NODE_WALK_CONTINUE;
+}
+
+void joint_node_free(joint_node_t * root) {
+    joint_node_visitor_t visitor = {
+        .leave = joint_node_free_leave
+    };
+
+    joint_node_walk(root, &visitor);
+}
@@ -0,0 +1,153 @@
+/* Copyright (c) 2014 Vyacheslav Slinko
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef joint_node_h
+#define joint_node_h
+
+#include <stdbool.h>
+#include "allocator.h"
+#include "tokenizer.h"
+
+enum joint_node_type {
+    PROGRAM_NODE,
+    COMMENT_NODE,
+    IDENTIFIER_NODE,
+    LITERAL_NODE,
+    CALL_EXPRESSION_NODE,
+    IMPORT_DECLARATION_NODE,
+    VARIABLE_DECLARATION_NODE,
+    BINARY_EXPRESSION_NODE,
+    UNARY_EXPRESSION_NODE
+};
+
+typedef struct joint_node {
+    joint_allocator_t * allocator;
+    enum joint_node_type type;
+    int childrens_length;
+    struct joint_node_children ** childrens;
+
+    joint_source_file_position_t * start_position;
+    joint_source_file_position_t * end_position;
+} joint_node_t;
+
+#define JOINT_NODE_STATIC_STRING -2
+#define JOINT_NODE_INTERNED_STRING -3
+
+typedef struct joint_node_children {
+    enum {
+        NODE_CHILDREN,
+        NUMBER_CHILDREN,
+        BOOLEAN_CHILDREN,
+        CHARACTER_CHILDREN,
+        STRING_CHILDREN,
+        NULL_CHILDREN
+    } type;
+
+    /* Index of a scalar in the constant pool of the parser that built the
+     * node, -1 when it is not pooled. Strings of pooled and
+     * JOINT_NODE_INTERNED_STRING scalars are interned, JOINT_NODE_STATIC_STRING
+     * ones are in static storage, and none of them is owned by the node. */
+    int constant;
+
+    char * name;
+
+    union {
+        joint_node_t * node;
+        long double number;
+        bool boolean;
+        char character;
+        char * string;
+    };
+} joint_node_children_t;
+
+typedef enum joint_node_walk_action {
+    JOINT_NODE_WALK_CONTINUE,
+    JOINT_NODE_WALK_SKIP,
+    JOINT_NODE_WALK_STOP
+} joint_node_walk_action_t;
+
+/* Callbacks receive the relation through which the node was reached (NULL
+ * for the root) and the nesting depth of the node. Returning SKIP from
+ * enter prevents descending into the node, leave is still called for it. */
+typedef struct joint_node_visitor {
+    joint_node_walk_action_t (* enter)(joint_node_t * node, const joint_node_children_t * relation, int depth, void * data);
+    joint_node_walk_action_t (* scalar)(joint_node_t * node, const joint_node_children_t * relation, int depth, void * data);
+    joint_node_walk_action_t (* leave)(joint_node_t * node, const joint_node_children_t * relation, int depth, void * data);
+    void * data;
+} joint_node_visitor_t;
+
+typedef struct joint_node_walk_frame {
+    joint_node_t * node;
+    const joint_node_children_t * relation;
+    int next_children;
+} joint_node_walk_frame_t;
+
+typedef struct joint_node_walker {
+    int frames_length;
+    int frames_capacity;
+    joint_node_walk_frame_t * frames;
+} joint_node_walker_t;
+
+joint_source_file_position_t * joint_node_clone_position(joint_allocator_t * allocator, const joint_source_file_position_t * position);
+
+void joint_node_free_position(joint_allocator_t * allocator, joint_source_file_position_t * position);
+
+/* The node keeps allocator for its relations, strings and positions. */
+joint_node_t * joint_node_alloc(joint_allocator_t * allocator, enum joint_node_type type, const joint_source_file_position_t * start_position);
+
+void joint_node_attach_node(joint_node_t * node, char * name, joint_node_t * related);
+
+void joint_node_attach_number(joint_node_t * node, char * name, long double number);
+
+void joint_node_attach_boolean(joint_node_t * node, char * name, bool boolean);
+
+void joint_node_attach_character(joint_node_t * node, char * name, char character);
+
+void joint_node_attach_string(joint_node_t * node, char * name, const char * string);
+
+void joint_node_attach_null(joint_node_t * node, char * name);
+
+/* Attaches a copy of a scalar relation, keeping its constant. */
+void joint_node_attach_scalar(joint_node_t * node, const joint_node_children_t * scalar);
+
+void joint_node_splice_nodes(joint_node_t * node, int index, int removed_length, char * name, joint_node_t ** inserted, int inserted_length);
+
+/* Frees and removes the childrens flagged in removed, which has one entry
+ * per children, keeping the others in order. */
+void joint_node_remove_childrens(joint_node_t * node, const bool * removed);
+
+joint_node_walker_t * joint_node_walker_alloc(void);
+
+bool joint_node_walker_walk(joint_node_walker_t * walker, joint_node_t * root, const joint_node_visitor_t * visitor);
+
+void joint_node_walker_free(joint_node_walker_t * walker);
+
+bool joint_node_walk(joint_node_t * root, const joint_node_visitor_t * visitor);
+
+char * joint_node_children_name(const char * name);
+
+const char * joint_node_type_name(enum joint_node_type type);
+
+void joint_node_print(joint_node_t * root);
+
+void joint_node_free(joint_node_t * root);
+
+#endif
@@ -0,0 +1,104 @@
+/* Copyright (c) 2014 Vyacheslav Slinko
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "optimizer.h"
+
+joint_optimizer_t * joint_optimizer_alloc(int max_iterations) {
+    joint_optimizer_t * optimizer = malloc(sizeof(joint_optimizer_t));
+    assert(optimizer);
+
+    optimizer->passes_length = 0;
+    optimizer->passes = NULL;
+    optimizer->max_iterations = max_iterations;
+    optimizer->iterations = 0;
+
+    return optimizer;
+}
+
+static char * joint_optimizer_stats_name(const char * name, const char * suffix) {
+    char * stats_name = malloc(sizeof(char) * (strlen(name) + strlen(suffix) + 1));
+    assert(stats_name);
+    strcpy(stats_name, name);
+    strcat(stats_name, suffix);
+
+    return stats_name;
+}
+
+void joint_optimizer_add_pass(joint_optimizer_t * optimizer, const char * name, joint_optimizer_pass_function_t function, void * data) {
+    optimizer->passes = realloc(optimizer->passes, sizeof(joint_optimizer_pass_t) * (optimizer->passes_length + 1));
+    assert(optimizer->passes);
+
+    joint_optimizer_pass_t * pass = &optimizer->passes[optimizer->passes_length++];
+    pass->function = function;
+    pass->data = data;
+    pass->time_name = joint_optimizer_stats_name(name, " time");
+    pass->changes_name = joint_optimizer_stats_name(name, " changes");
+    pass->time = 0;
+    pass->changes = 0;
+}
+
+void joint_optimizer_run(joint_optimizer_t * optimizer, joint_node_t * program) {
+    bool changed = true;
+
+    while (changed && optimizer->iterations < optimizer->max_iterations) {
+        changed = false;
+        optimizer->iterations++;
+
+        for (int i = 0; i < optimizer->passes_length; i++) {
+            joint_optimizer_pass_t * pass = &optimizer->passes[i];
+            uint64_t started_at = joint_stats_now();
+            int changes = pass->function(program, pass->data);
+
+            if (changes > 0) {
+                pass->changes += (uint64_t) changes;
+                changed = true;
+            }
+
+            pass->time += joint_stats_now() - started_at;
+        }
+    }
+}
+
+void joint_optimizer_add_stats(const joint_optimizer_t * optimizer, joint_stats_t * stats) {
+    joint_stats_add(stats, "optimizer iterations", (uint64_t) optimizer->iterations);
+
+    for (int i = 0; i < optimizer->passes_length; i++) {
+        joint_stats_add_time(stats, optimizer->passes[i].time_name, optimizer->passes[i].time);
+        joint_stats_add(stats, optimizer->passes[i].changes_name, optimizer->passes[i].changes);
+    }
+}
+
+void joint_optimizer_free(joint_optimizer_t * optimizer) {
+    for (int i = 0; i < optimizer->passes_length; i++) {
+        free(optimizer->passes[i].time_name);
+        free(optimizer->passes[i].changes_name);
+    }
+
+    if (optimizer->passes != NULL) {
+        free(optimizer->passes);
+    }
+
+    free(optimizer);
+}
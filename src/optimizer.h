@@ -0,0 +1,64 @@
+/* Copyright (c) 2014 Vyacheslav Slinko
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef joint_optimizer_h
+#define joint_optimizer_h
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "node.h"
+#include "stats.h"
+
+/* A pass rewrites the program in place and returns the number of changes it
+ * made, zero when the program is left as is. */
+typedef int (* joint_optimizer_pass_function_t)(joint_node_t * program, void * data);
+
+typedef struct joint_optimizer_pass {
+    joint_optimizer_pass_function_t function;
+    void * data;
+
+    char * time_name;
+    char * changes_name;
+    uint64_t time;
+    uint64_t changes;
+} joint_optimizer_pass_t;
+
+typedef struct joint_optimizer {
+    int passes_length;
+    joint_optimizer_pass_t * passes;
+
+    int max_iterations;
+    int iterations;
+} joint_optimizer_t;
+
+joint_optimizer_t * joint_optimizer_alloc(int max_iterations);
+
+void joint_optimizer_add_pass(joint_optimizer_t * optimizer, const char * name, joint_optimizer_pass_function_t function, void * data);
+
+/* Runs every pass in order until none of them changes the program or
+ * max_iterations rounds were run. */
+void joint_optimizer_run(joint_optimizer_t * optimizer, joint_node_t * program);
+
+void joint_optimizer_add_stats(const joint_optimizer_t * optimizer, joint_stats_t * stats);
+
+void joint_optimizer_free(joint_optimizer_t * optimizer);
+
+#endif
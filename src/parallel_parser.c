@@ -0,0 +1,217 @@
+/* Copyright (c) 2014 Vyacheslav Slinko
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include "parallel_parser.h"
+
+typedef struct joint_parallel_parser_range {
+    joint_allocator_t * allocator;
+    joint_tokenizer_t * tokenizer;
+    size_t start;
+    size_t end;
+
+    pthread_t thread;
+
+    joint_parser_t * parser;
+    int elements_length;
+    joint_node_t ** elements;
+} joint_parallel_parser_range_t;
+
+static bool joint_parallel_parser_is_boundary(const joint_tokenizer_t * tokenizer, size_t token) {
+    if (token == 0 || tokenizer->tokens[token]->type == COMMENT_TOKEN) {
+        return true;
+    }
+
+    const joint_token_t * previous = tokenizer->tokens[token - 1];
+
+    return previous->type == COMMENT_TOKEN || (previous->type == PUNCTUATOR_TOKEN && strcmp(previous->value->data, ";") == 0);
+}
+
+static void * joint_parallel_parser_parse_range(void * data) {
+    joint_parallel_parser_range_t * range = data;
+    joint_parser_t * parser = joint_parser_alloc(range->allocator, range->tokenizer);
+    joint_parser_seek(parser, range->start);
+
+    int elements_capacity = 64;
+    range->elements_length = 0;
+    range->elements = malloc(sizeof(joint_node_t *) * elements_capacity);
+    assert(range->elements);
+
+    while (parser->current_token < range->end && parser->next_token->type != EOF_TOKEN && parser->error == NULL) {
+        if (range->elements_length == elements_capacity) {
+            elements_capacity *= 2;
+            range->elements = realloc(range->elements, sizeof(joint_node_t *) * elements_capacity);
+            assert(range->elements);
+        }
+
+        joint_node_t * element = joint_parser_parse_element(parser);
+
+        if (element != NULL) {
+            range->elements[range->elements_length++] = element;
+        }
+    }
+
+    range->parser = parser;
+
+    return NULL;
+}
+
+typedef struct joint_parallel_parser_adoption {
+    joint_allocator_t * allocator;
+    int * remap;
+} joint_parallel_parser_adoption_t;
+
+static joint_node_walk_action_t joint_parallel_parser_adopt_enter(joint_node_t * node, const joint_node_children_t * relation, int depth, void * data) {
+    const joint_parallel_parser_adoption_t * adoption = data;
+
+    node->allocator = adoption->allocator;
+
+    for (int i = 0; i < node->childrens_length; i++) {
+        if (node->childrens[i]->type != NODE_CHILDREN && node->childrens[i]->constant >= 0) {
+            node->childrens[i]->constant = adoption->remap[node->childrens[i]->constant];
+        }
+    }
+
+    return JOINT_NODE_WALK_CONTINUE;
+}
+
+/* Every range is parsed with a constant pool and an allocator of its own.
+ * Once the range is joined its literals move into the pool of parser and
+ * its memory into the allocator of parser. */
+static void joint_parallel_parser_adopt(joint_parser_t * parser, const joint_parallel_parser_range_t * range) {
+    const joint_constants_t * constants = range->parser->constants;
+    joint_parallel_parser_adoption_t adoption = {.allocator = parser->allocator, .remap = malloc(sizeof(int) * (constants->values_length + 1))};
+    assert(adoption.remap);
+
+    for (int i = 0; i < constants->values_length; i++) {
+        adoption.remap[i] = joint_constants_add(parser->constants, constants->values[i]);
+    }
+
+    joint_node_visitor_t visitor = {.enter = joint_parallel_parser_adopt_enter, .scalar = NULL, .leave = NULL, .data = &adoption};
+
+    for (int i = 0; i < range->elements_length; i++) {
+        joint_node_walk(range->elements[i], &visitor);
+    }
+
+    free(adoption.remap);
+}
+
+static int joint_parallel_parser_split(const joint_parser_t * parser, int threads_length, joint_parallel_parser_range_t * ranges) {
+    joint_tokenizer_t * tokenizer = parser->tokenizer;
+    size_t eof = tokenizer->tokens_length - 1;
+    size_t start = parser->current_token;
+    int ranges_length = 0;
+
+    for (int i = 1; i <= threads_length && start < eof; i++) {
+        size_t end = eof;
+
+        if (i < threads_length) {
+            end = parser->current_token + (eof - parser->current_token) / (size_t) threads_length * (size_t) i;
+
+            if (end <= start) {
+                end = start + 1;
+            }
+
+            while (end < eof && !joint_parallel_parser_is_boundary(tokenizer, end)) {
+                end++;
+            }
+        }
+
+        ranges[ranges_length].allocator = joint_allocator_fork(parser->allocator);
+        ranges[ranges_length].tokenizer = tokenizer;
+        ranges[ranges_length].start = start;
+        ranges[ranges_length].end = end;
+        ranges_length++;
+
+        start = end;
+    }
+
+    return ranges_length;
+}
+
+bool joint_parallel_parser_parse(joint_parser_t * parser, int threads_length) {
+    if (threads_length < 2) {
+        return joint_parser_parse(parser);
+    }
+
+    joint_parallel_parser_range_t * ranges = malloc(sizeof(joint_parallel_parser_range_t) * threads_length);
+    assert(ranges);
+
+    int ranges_length = joint_parallel_parser_split(parser, threads_length, ranges);
+
+    for (int i = 1; i < ranges_length; i++) {
+        int status = pthread_create(&ranges[i].thread, NULL, joint_parallel_parser_parse_range, &ranges[i]);
+        assert(status == 0);
+    }
+
+    joint_node_t * program = joint_node_alloc(parser->allocator, PROGRAM_NODE, parser->next_token->start_position);
+
+    for (int i = 0; i < ranges_length; i++) {
+        if (i == 0) {
+            joint_parallel_parser_parse_range(&ranges[0]);
+        } else {
+            pthread_join(ranges[i].thread, NULL);
+        }
+
+        if (parser->error == NULL && ranges[i].parser->error != NULL) {
+            parser->error = ranges[i].parser->error;
+            parser->error_token = ranges[i].parser->error_token;
+        }
+
+        if (parser->error == NULL) {
+            joint_parallel_parser_adopt(parser, &ranges[i]);
+
+            if (ranges[i].elements_length > 0) {
+                joint_node_splice_nodes(program, program->childrens_length, 0, "body", ranges[i].elements, ranges[i].elements_length);
+            }
+        } else {
+            for (int j = 0; j < ranges[i].elements_length; j++) {
+                joint_node_free(ranges[i].elements[j]);
+            }
+        }
+
+        joint_parser_free(ranges[i].parser);
+        joint_allocator_merge(parser->allocator, ranges[i].allocator);
+        free(ranges[i].elements);
+    }
+
+    free(ranges);
+
+    if (parser->error != NULL) {
+        joint_node_free(program);
+        return false;
+    }
+
+    joint_parser_seek(parser, parser->tokenizer->tokens_length - 1);
+
+    if (program->childrens_length == 0) {
+        program->end_position = joint_node_clone_position(parser->allocator, parser->next_token->end_position);
+    } else {
+        program->end_position = joint_node_clone_position(parser->allocator, program->childrens[program->childrens_length - 1]->node->end_position);
+    }
+
+    parser->program = program;
+
+    return true;
+}
@@ -0,0 +1,291 @@
+/* Copyright (c) 2014 Vyacheslav Slinko
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "parallel_tokenizer.h"
+
+typedef struct joint_parallel_tokenizer_state {
+    size_t position;
+    size_t line;
+    size_t line_start_position;
+} joint_parallel_tokenizer_state_t;
+
+typedef struct joint_parallel_tokenizer_chunk {
+    joint_allocator_t * allocator;
+    joint_source_file_t * source_file;
+    size_t start;
+    size_t end;
+    bool last;
+    bool skip_comments;
+    bool record_comments;
+
+    pthread_t thread;
+
+    size_t tokens_length;
+    joint_token_t ** tokens;
+    size_t comments_length;
+    joint_tokenizer_comment_t * comments;
+    joint_parallel_tokenizer_state_t end_state;
+} joint_parallel_tokenizer_chunk_t;
+
+static joint_parallel_tokenizer_state_t joint_parallel_tokenizer_save(const joint_tokenizer_t * tokenizer) {
+    joint_parallel_tokenizer_state_t state = {
+        .position = tokenizer->current_position,
+        .line = tokenizer->current_line_number,
+        .line_start_position = tokenizer->current_line_start_position
+    };
+
+    return state;
+}
+
+static void * joint_parallel_tokenizer_lex_chunk(void * data) {
+    joint_parallel_tokenizer_chunk_t * chunk = data;
+
+    joint_string_t content = *chunk->source_file->content;
+    content.length = chunk->end;
+
+    joint_source_file_t source_file = *chunk->source_file;
+    source_file.content = &content;
+
+    joint_tokenizer_t * tokenizer = joint_tokenizer_alloc(chunk->allocator, &source_file);
+    tokenizer->current_position = chunk->start;
+    tokenizer->current_line_start_position = chunk->start;
+    tokenizer->speculative = true;
+    tokenizer->skip_comments = chunk->skip_comments;
+    tokenizer->record_comments = chunk->record_comments;
+
+    size_t tokens_capacity = 64;
+    chunk->tokens_length = 0;
+    chunk->tokens = malloc(sizeof(joint_token_t *) * tokens_capacity);
+    assert(chunk->tokens);
+
+    while (true) {
+        chunk->end_state = joint_parallel_tokenizer_save(tokenizer);
+
+        joint_token_t * token = joint_tokenizer_next_token(tokenizer);
+
+        if (tokenizer->failed || token->end_position->position > chunk->end) {
+            joint_token_free(tokenizer, token);
+            break;
+        }
+
+        if (token->type == EOF_TOKEN) {
+            chunk->end_state = joint_parallel_tokenizer_save(tokenizer);
+
+            if (!chunk->last) {
+                joint_token_free(tokenizer, token);
+                break;
+            }
+        }
+
+        if (chunk->tokens_length == tokens_capacity) {
+            tokens_capacity *= 2;
+            chunk->tokens = realloc(chunk->tokens, sizeof(joint_token_t *) * tokens_capacity);
+            assert(chunk->tokens);
+        }
+
+        chunk->tokens[chunk->tokens_length++] = token;
+
+        if (token->type == EOF_TOKEN) {
+            break;
+        }
+    }
+
+    chunk->comments_length = tokenizer->comments_length;
+    chunk->comments = tokenizer->comments;
+    tokenizer->comments = NULL;
+
+    joint_tokenizer_free(tokenizer);
+
+    return NULL;
+}
+
+static void joint_parallel_tokenizer_shift_position(joint_source_file_position_t * position, size_t line, int64_t line_delta, int64_t column_delta, int64_t code_point_column_delta) {
+    if (position->line == line) {
+        position->column += (size_t) column_delta;
+        position->code_point_column += (size_t) code_point_column_delta;
+    }
+
+    position->line += (size_t) line_delta;
+}
+
+static void joint_parallel_tokenizer_append(joint_tokenizer_t * tokenizer, size_t * tokens_capacity, joint_token_t * token) {
+    if (tokenizer->tokens_length == *tokens_capacity) {
+        *tokens_capacity *= 2;
+        tokenizer->tokens = JOINT_REALLOCATE(tokenizer->allocator, tokenizer->tokens, sizeof(joint_token_t *) * *tokens_capacity);
+        assert(tokenizer->tokens);
+    }
+
+    tokenizer->tokens[tokenizer->tokens_length++] = token;
+}
+
+static int joint_parallel_tokenizer_split(const joint_tokenizer_t * tokenizer, int threads_length, joint_parallel_tokenizer_chunk_t * chunks) {
+    const char * data = tokenizer->source_file->content->data;
+    size_t length = tokenizer->source_file->content->length;
+    size_t start = tokenizer->current_position;
+    int chunks_length = 0;
+
+    for (int i = 1; i <= threads_length && start < length; i++) {
+        size_t end = length;
+
+        if (i < threads_length) {
+            size_t target = tokenizer->current_position + (length - tokenizer->current_position) / (size_t) threads_length * (size_t) i;
+
+            if (target < start) {
+                target = start;
+            }
+
+            const char * newline = memchr(data + target, '\n', length - target);
+
+            if (newline != NULL) {
+                end = (size_t) (newline - data) + 1;
+            }
+        }
+
+        chunks[chunks_length].allocator = tokenizer->allocator;
+        chunks[chunks_length].source_file = tokenizer->source_file;
+        chunks[chunks_length].start = start;
+        chunks[chunks_length].end = end;
+        chunks[chunks_length].last = end == length;
+        chunks[chunks_length].skip_comments = tokenizer->skip_comments;
+        chunks[chunks_length].record_comments = tokenizer->record_comments;
+        chunks_length++;
+
+        start = end;
+    }
+
+    return chunks_length;
+}
+
+void joint_parallel_tokenizer_tokenize(joint_tokenizer_t * tokenizer, int threads_length) {
+    if (threads_length < 2 || tokenizer->source_file->content->length - tokenizer->current_position < (size_t) threads_length) {
+        joint_tokenizer_tokenize(tokenizer);
+        return;
+    }
+
+    joint_parallel_tokenizer_chunk_t * chunks = malloc(sizeof(joint_parallel_tokenizer_chunk_t) * threads_length);
+    assert(chunks);
+
+    int chunks_length = joint_parallel_tokenizer_split(tokenizer, threads_length, chunks);
+
+    for (int i = 1; i < chunks_length; i++) {
+        int status = pthread_create(&chunks[i].thread, NULL, joint_parallel_tokenizer_lex_chunk, &chunks[i]);
+        assert(status == 0);
+    }
+
+    joint_parallel_tokenizer_lex_chunk(&chunks[0]);
+
+    size_t tokens_capacity = tokenizer->tokens_length + 1;
+
+    for (int i = 0; i < chunks_length; i++) {
+        if (i > 0) {
+            pthread_join(chunks[i].thread, NULL);
+        }
+
+        tokens_capacity += chunks[i].tokens_length;
+    }
+
+    tokenizer->tokens = JOINT_REALLOCATE(tokenizer->allocator, tokenizer->tokens, sizeof(joint_token_t *) * tokens_capacity);
+    assert(tokenizer->tokens);
+
+    bool finished = false;
+
+    for (int i = 0; i < chunks_length; i++) {
+        joint_parallel_tokenizer_chunk_t * chunk = &chunks[i];
+        size_t current = 0;
+
+        while (!finished) {
+            joint_tokenizer_skip_whitespaces(tokenizer);
+
+            while (current < chunk->tokens_length && chunk->tokens[current]->start_position->position < tokenizer->current_position) {
+                joint_token_free(tokenizer, chunk->tokens[current++]);
+            }
+
+            if (current == chunk->tokens_length) {
+                break;
+            }
+
+            joint_source_file_position_t * start_position = chunk->tokens[current]->start_position;
+
+            if (start_position->position == tokenizer->current_position) {
+                size_t line = start_position->line;
+                int64_t line_delta = (int64_t) (tokenizer->current_line_number - start_position->line);
+                int64_t column_delta = (int64_t) ((tokenizer->current_position - tokenizer->current_line_start_position) - start_position->column);
+                int64_t code_point_column_delta = (int64_t) (joint_tokenizer_code_point_column(tokenizer) - start_position->code_point_column);
+
+                for (; current < chunk->tokens_length; current++) {
+                    joint_token_t * token = chunk->tokens[current];
+                    joint_parallel_tokenizer_shift_position(token->start_position, line, line_delta, column_delta, code_point_column_delta);
+                    joint_parallel_tokenizer_shift_position(token->end_position, line, line_delta, column_delta, code_point_column_delta);
+                    joint_parallel_tokenizer_append(tokenizer, &tokens_capacity, token);
+                    finished = token->type == EOF_TOKEN;
+                }
+
+                /* Comments before the matched token were already recorded
+                 * by the tokenizer, those past the end state were lexed
+                 * again by it. */
+                for (size_t j = 0; j < chunk->comments_length; j++) {
+                    joint_tokenizer_comment_t comment = chunk->comments[j];
+
+                    if (comment.start >= tokenizer->current_position && comment.start < chunk->end_state.position) {
+                        if (comment.line == line) {
+                            comment.column += (size_t) column_delta;
+                        }
+
+                        comment.line += (size_t) line_delta;
+                        joint_tokenizer_append_comment(tokenizer, &comment);
+                    }
+                }
+
+                tokenizer->current_position = chunk->end_state.position;
+                tokenizer->current_line_number = chunk->end_state.line + (size_t) line_delta;
+                tokenizer->current_line_start_position = chunk->end_state.line_start_position - (chunk->end_state.line == line ? (size_t) column_delta : 0);
+                break;
+            }
+
+            joint_token_t * token = joint_tokenizer_next_token(tokenizer);
+            joint_parallel_tokenizer_append(tokenizer, &tokens_capacity, token);
+            finished = token->type == EOF_TOKEN;
+        }
+
+        for (; current < chunk->tokens_length; current++) {
+            joint_token_free(tokenizer, chunk->tokens[current]);
+        }
+
+        free(chunk->tokens);
+
+        if (chunk->comments != NULL) {
+            JOINT_DEALLOCATE(tokenizer->allocator, chunk->comments);
+        }
+    }
+
+    while (!finished) {
+        joint_token_t * token = joint_tokenizer_next_token(tokenizer);
+        joint_parallel_tokenizer_append(tokenizer, &tokens_capacity, token);
+        finished = token->type == EOF_TOKEN;
+    }
+
+    free(chunks);
+}
@@ -0,0 +1,38 @@
+/* Copyright (c) 2014 Vyacheslav Slinko
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef joint_parallel_tokenizer_h
+#define joint_parallel_tokenizer_h
+
+#include "tokenizer.h"
+
+/* Sources at least this long are worth splitting between threads. */
+#define JOINT_PARALLEL_TOKENIZER_THRESHOLD (1 << 20)
+
+/* Tokenizes the whole source file like joint_tokenizer_tokenize, lexing up to
+ * threads_length newline-aligned chunks at once. Chunks are lexed on the
+ * assumption that they start outside of any token; the ones that actually
+ * start inside a string or character literal are re-lexed from the state the
+ * previous chunk ended in, so tokens and positions match the sequential
+ * tokenizer exactly. */
+void joint_parallel_tokenizer_tokenize(joint_tokenizer_t * tokenizer, int threads_length);
+
+#endif
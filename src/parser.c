@@ -25,445 +25,804 @@
 #include <string.h>
 #include "parser.h"
 
-static const char * joint_node_type_names[] = {
-    "PROGRAM_NODE",
-    "COMMENT_NODE",
-    "IDENTIFIER_NODE",
-    "LITERAL_NODE",
-    "CALL_EXPRESSION_NODE",
-    "IMPORT_DECLARATION_NODE",
-    "VARIABLE_DECLARATION_NODE"
+/* Precedences of binary operators, higher binds tighter. Prefix operators
+ * bind tighter than all of them. */
+static const int joint_parser_binary_precedences[GREATER_PUNCTUATOR + 1] = {
+    [LOGICAL_OR_PUNCTUATOR] = 1,
+    [LOGICAL_AND_PUNCTUATOR] = 2,
+    [BITWISE_OR_PUNCTUATOR] = 3,
+    [BITWISE_XOR_PUNCTUATOR] = 4,
+    [BITWISE_AND_PUNCTUATOR] = 5,
+    [EQUAL_PUNCTUATOR] = 6,
+    [NOT_EQUAL_PUNCTUATOR] = 6,
+    [LESS_PUNCTUATOR] = 7,
+    [GREATER_PUNCTUATOR] = 7,
+    [LEFT_SHIFT_PUNCTUATOR] = 8,
+    [RIGHT_SHIFT_PUNCTUATOR] = 8,
+    [UNSIGNED_RIGHT_SHIFT_PUNCTUATOR] = 8,
+    [PLUS_PUNCTUATOR] = 9,
+    [MINUS_PUNCTUATOR] = 9,
+    [MULTIPLY_PUNCTUATOR] = 10,
+    [DIVIDE_PUNCTUATOR] = 10,
+    [MODULO_PUNCTUATOR] = 10
 };
 
-static joint_source_file_position_t * joint_node_clone_position(const joint_source_file_position_t * position) {
-    joint_source_file_position_t * cloned_position = malloc(sizeof(joint_source_file_position_t));
-    assert(cloned_position);
-    cloned_position->path = malloc(sizeof(char) * (strlen(position->path) + 1));
-    assert(cloned_position->path);
-    strcpy(cloned_position->path, position->path);
-    cloned_position->position = position->position;
-    cloned_position->line = position->line;
-    cloned_position->column = position->column;
-    return cloned_position;
-}
-
-static joint_node_t * joint_node_alloc(enum joint_node_type type, const joint_source_file_position_t * start_position) {
-    joint_node_t * node = malloc(sizeof(joint_node_t));
-    node->type = type;
-    node->childrens_length = 0;
-    node->start_position = joint_node_clone_position(start_position);
-    return node;
-}
-
-static void joint_node_attach_children(joint_node_t * node, joint_node_children_t * children) {
-    if (node->childrens_length == 0) {
-        node->childrens = malloc(sizeof(joint_node_children_t *));
-    } else {
-        node->childrens = realloc(node->childrens, sizeof(joint_node_children_t *) * (node->childrens_length + 1));
-    }
-    assert(node->childrens);
-    node->childrens[node->childrens_length++] = children;
-}
-
-static void joint_node_attach_node(joint_node_t * node, char * name, joint_node_t * related) {
-    joint_node_children_t * relation = malloc(sizeof(joint_node_children_t));
-    assert(relation);
-    relation->type = NODE_CHILDREN;
-    relation->name = name;
-    relation->node = related;
-    joint_node_attach_children(node, relation);
-}
-
-static void joint_node_attach_number(joint_node_t * node, char * name, long double number) {
-    joint_node_children_t * relation = malloc(sizeof(joint_node_children_t));
-    assert(relation);
-    relation->type = NUMBER_CHILDREN;
-    relation->name = name;
-    relation->number = number;
-    joint_node_attach_children(node, relation);
-}
+static const bool joint_parser_unary_operators[GREATER_PUNCTUATOR + 1] = {
+    [PLUS_PUNCTUATOR] = true,
+    [MINUS_PUNCTUATOR] = true,
+    [BITWISE_NOT_PUNCTUATOR] = true,
+    [LOGICAL_NOT_PUNCTUATOR] = true
+};
 
-static void joint_node_attach_boolean(joint_node_t * node, char * name, bool boolean) {
-    joint_node_children_t * relation = malloc(sizeof(joint_node_children_t));
-    assert(relation);
-    relation->type = BOOLEAN_CHILDREN;
-    relation->name = name;
-    relation->boolean = boolean;
-    joint_node_attach_children(node, relation);
-}
+#define JOINT_PARSER_UNARY_PRECEDENCE 11
+
+/* Operator children point here instead of owning a copy of their token. */
+static const char * const joint_parser_operator_spellings[GREATER_PUNCTUATOR + 1] = {
+    [PLUS_PUNCTUATOR] = "+",
+    [MINUS_PUNCTUATOR] = "-",
+    [MULTIPLY_PUNCTUATOR] = "*",
+    [DIVIDE_PUNCTUATOR] = "/",
+    [MODULO_PUNCTUATOR] = "%",
+    [BITWISE_AND_PUNCTUATOR] = "&",
+    [BITWISE_OR_PUNCTUATOR] = "|",
+    [BITWISE_XOR_PUNCTUATOR] = "^",
+    [BITWISE_NOT_PUNCTUATOR] = "~",
+    [LEFT_SHIFT_PUNCTUATOR] = "<<",
+    [RIGHT_SHIFT_PUNCTUATOR] = ">>",
+    [UNSIGNED_RIGHT_SHIFT_PUNCTUATOR] = ">>>",
+    [LOGICAL_AND_PUNCTUATOR] = "&&",
+    [LOGICAL_OR_PUNCTUATOR] = "||",
+    [LOGICAL_NOT_PUNCTUATOR] = "!",
+    [EQUAL_PUNCTUATOR] = "==",
+    [NOT_EQUAL_PUNCTUATOR] = "!=",
+    [LESS_PUNCTUATOR] = "<",
+    [GREATER_PUNCTUATOR] = ">"
+};
 
-static void joint_node_attach_character(joint_node_t * node, char * name, char character) {
-    joint_node_children_t * relation = malloc(sizeof(joint_node_children_t));
-    assert(relation);
-    relation->type = CHARACTER_CHILDREN;
-    relation->name = name;
-    relation->character = character;
-    joint_node_attach_children(node, relation);
+static inline bool joint_parser_match_punctuator(const joint_parser_t * parser, enum joint_punctuator punctuator) {
+    return joint_tokenizer_punctuator(parser->next_token) == punctuator;
 }
 
-static void joint_node_attach_string(joint_node_t * node, char * name, const char * string) {
-    joint_node_children_t * relation = malloc(sizeof(joint_node_children_t));
-    assert(relation);
-
-    relation->type = STRING_CHILDREN;
-    relation->name = name;
-
-    relation->string = malloc(sizeof(char) * (strlen(string) + 1));
-    assert(relation->string);
-    strcpy(relation->string, string);
-
-    joint_node_attach_children(node, relation);
-}
+static void joint_parser_get_next_token(joint_parser_t * parser) {
+    if (parser->current_token + 1 >= parser->tokenizer->tokens_length) {
+        return;
+    }
 
-static void joint_node_attach_null(joint_node_t * node, char * name) {
-    joint_node_children_t * relation = malloc(sizeof(joint_node_children_t));
-    assert(relation);
-    relation->type = NULL_CHILDREN;
-    relation->name = name;
-    joint_node_attach_children(node, relation);
+    parser->current_token++;
+    parser->next_token = parser->tokenizer->tokens[parser->current_token];
 }
 
-static void joint_node_print(const joint_node_t * root, int level) {
-    char * indent = malloc(sizeof(char) * level * 4 + 1);
-    memset(indent, ' ', level * 4);
-    indent[level * 4] = '\0';
-
-    printf("%sTYPE: %s\n", indent, joint_node_type_names[root->type]);
-    printf("%sSTART: p %d l %d c %d\n", indent, root->start_position->position, root->start_position->line, root->start_position->column);
-    printf("%sEND: p %d l %d c %d\n", indent, root->end_position->position, root->end_position->line, root->end_position->column);
-
-    if (root->childrens_length > 0) {
-        printf("%sCHILDRENS:\n", indent);
-
-        for (int i = 0; i < root->childrens_length; i++) {
-            printf("%s    %s:", indent, root->childrens[i]->name);
-
-            switch (root->childrens[i]->type) {
-                case NODE_CHILDREN:
-                    printf("\n");
-                    joint_node_print(root->childrens[i]->node, level + 2);
-                    break;
-
-                case NUMBER_CHILDREN:
-                    printf(" %Lf\n", root->childrens[i]->number);
-                    break;
-
-                case BOOLEAN_CHILDREN:
-                    if (root->childrens[i]->boolean) {
-                        printf(" true\n");
-                    } else {
-                        printf(" false\n");
-                    }
-                    break;
-
-                case CHARACTER_CHILDREN:
-                    printf(" '%c'\n", root->childrens[i]->character);
-                    break;
-
-                case STRING_CHILDREN:
-                    printf(" \"%s\"\n", root->childrens[i]->string);
-                    break;
+/* Only the first error is kept. The parser does not advance past it and
+ * emits no more events, so the rest of the element unwinds without effect. */
+static void joint_parser_fail(joint_parser_t * parser, const joint_token_t * token) {
+    if (parser->error != NULL) {
+        return;
+    }
 
-                case NULL_CHILDREN:
-                    printf(" null\n");
-                    break;
-            }
-        }
+    if (token->type == EOF_TOKEN) {
+        parser->error = "Unexpected end of file";
+    } else if (token->type == ERROR_TOKEN) {
+        parser->error = "Invalid token";
     } else {
-        printf("%sCHILDRENS: ~\n", indent);
+        parser->error = "Unexpected token";
     }
 
-    free(indent);
+    parser->error_token = token;
 }
 
-static void joint_node_free(joint_node_t * node) {
-    for (int i = 0; i < node->childrens_length; i++) {
-        switch (node->childrens[i]->type) {
-            case NODE_CHILDREN:
-                joint_node_free(node->childrens[i]->node);
-                break;
-
-            case STRING_CHILDREN:
-                free(node->childrens[i]->string);
-                break;
-
-            default:
-                break;
-        }
-
-        free(node->childrens[i]);
-    }
-
-    if (node->childrens != NULL) {
-        free(node->childrens);
+static void joint_parser_expect_keyword(joint_parser_t * parser, const char * keyword) {
+    if (parser->next_token->type != KEYWORD_TOKEN || strcmp(parser->next_token->value->data, keyword) != 0) {
+        joint_parser_fail(parser, parser->next_token);
+        return;
     }
 
-    free(node->start_position->path);
-    free(node->start_position);
-    free(node->end_position->path);
-    free(node->end_position);
-    free(node);
-}
-
-static inline bool joint_parser_match_punctuator(const joint_parser_t * parser, const char * punctuator) {
-    return parser->next_token->type == PUNCTUATOR_TOKEN && strcmp(parser->next_token->value->data, punctuator) == 0;
+    joint_parser_get_next_token(parser);
 }
 
-static void joint_parser_get_next_token(joint_parser_t * parser) {
-    if (parser->current_token + 1 >= parser->tokenizer->tokens_length) {
+static void joint_parser_expect_punctuator(joint_parser_t * parser, enum joint_punctuator punctuator) {
+    if (joint_tokenizer_punctuator(parser->next_token) != punctuator) {
+        joint_parser_fail(parser, parser->next_token);
         return;
     }
 
-    parser->current_token++;
-    parser->next_token = parser->tokenizer->tokens[parser->current_token];
+    joint_parser_get_next_token(parser);
 }
 
-static void joint_parser_expect_keyword(joint_parser_t * parser, const char * keyword) {
-    assert(parser->next_token->type == KEYWORD_TOKEN);
-    assert(strcmp(parser->next_token->value->data, keyword) == 0);
-    joint_parser_get_next_token(parser);
+static void joint_parser_emit_enter(joint_parser_t * parser, enum joint_node_type type, char * relation, const joint_source_file_position_t * start_position) {
+    if (parser->error == NULL) {
+        parser->events->enter_node(type, relation, start_position, parser->events->data);
+    }
 }
 
-static void joint_parser_expect_punctuator(joint_parser_t * parser, const char * punctuator) {
-    assert(parser->next_token->type == PUNCTUATOR_TOKEN);
-    assert(strcmp(parser->next_token->value->data, punctuator) == 0);
-    joint_parser_get_next_token(parser);
+static void joint_parser_emit_leave(joint_parser_t * parser, enum joint_node_type type, const joint_source_file_position_t * end_position) {
+    if (parser->error == NULL) {
+        parser->events->leave_node(type, end_position, parser->events->data);
+    }
+}
+
+static void joint_parser_emit_scalar(joint_parser_t * parser, const joint_node_children_t * relation) {
+    if (parser->error == NULL) {
+        parser->events->scalar_child(relation, parser->events->data);
+    }
 }
 
-static joint_node_t * joint_parser_parse_comment(joint_parser_t * parser) {
+/* end_position overrides the end of the node, it is NULL when the node ends
+ * with its own last token. */
+static const joint_source_file_position_t * joint_parser_parse_comment(joint_parser_t * parser, char * relation) {
     assert(parser->next_token->type == COMMENT_TOKEN);
-    joint_node_t * comment = joint_node_alloc(COMMENT_NODE, parser->next_token->start_position);
-    comment->end_position = joint_node_clone_position(parser->next_token->end_position);
-    joint_node_attach_string(comment, "value", parser->next_token->value->data);
+    joint_token_t * token = parser->next_token;
+    joint_node_children_t value = {.type = STRING_CHILDREN, .constant = -1, .name = "value", .string = token->value->data};
+
+    joint_parser_emit_enter(parser, COMMENT_NODE, relation, token->start_position);
+    joint_parser_emit_scalar(parser, &value);
+    joint_parser_emit_leave(parser, COMMENT_NODE, token->end_position);
     joint_parser_get_next_token(parser);
-    return comment;
+
+    return token->end_position;
 }
 
-static joint_node_t * joint_parser_parse_identifier(joint_parser_t * parser) {
-    assert(parser->next_token->type == IDENTIFIER_TOKEN);
-    joint_node_t * indentifier = joint_node_alloc(IDENTIFIER_NODE, parser->next_token->start_position);
-    indentifier->end_position = joint_node_clone_position(parser->next_token->end_position);
-    joint_node_attach_string(indentifier, "value", parser->next_token->value->data);
+static void joint_parser_parse_identifier(joint_parser_t * parser, char * relation, const joint_source_file_position_t * end_position) {
+    if (parser->next_token->type != IDENTIFIER_TOKEN) {
+        joint_parser_fail(parser, parser->next_token);
+        return;
+    }
+
+    joint_token_t * token = parser->next_token;
+    joint_node_children_t value = {.type = STRING_CHILDREN, .constant = -1, .name = "value", .string = token->value->data};
+
+    joint_parser_emit_enter(parser, IDENTIFIER_NODE, relation, token->start_position);
+    joint_parser_emit_scalar(parser, &value);
+    joint_parser_emit_leave(parser, IDENTIFIER_NODE, end_position != NULL ? end_position : token->end_position);
     joint_parser_get_next_token(parser);
-    return indentifier;
 }
 
-static joint_node_t * joint_parser_parse_literal(joint_parser_t * parser) {
-    joint_node_t * literal = joint_node_alloc(LITERAL_NODE, parser->next_token->start_position);
-    literal->end_position = joint_node_clone_position(parser->next_token->end_position);
-    long double value;
+static void joint_parser_parse_literal(joint_parser_t * parser, char * relation, const joint_source_file_position_t * end_position) {
+    joint_token_t * token = parser->next_token;
+    joint_node_children_t value = {.name = "value"};
 
-    switch (parser->next_token->type) {
+    const joint_intern_string_t * string;
+
+    switch (token->type) {
         case NUMERIC_LITERAL_TOKEN:
-            sscanf(parser->next_token->value->data, "%Lf", &value);
-            joint_node_attach_number(literal, "value", value);
+            value.type = NUMBER_CHILDREN;
+            value.constant = joint_constants_add_number(parser->constants, token->value->data, token->value->length, &value.number);
             break;
 
         case BOOLEAN_LITERAL_TOKEN:
-            joint_node_attach_boolean(literal, "value", strcmp(parser->next_token->value->data, "true") == 0);
+            value.type = BOOLEAN_CHILDREN;
+            value.boolean = strcmp(token->value->data, "true") == 0;
+            value.constant = joint_constants_add(parser->constants, joint_value_boolean(value.boolean));
             break;
 
         case CHARACTER_LITERAL_TOKEN:
-            joint_node_attach_character(literal, "value", parser->next_token->value->data[0]);
+            value.type = CHARACTER_CHILDREN;
+            value.character = token->value->data[0];
+            value.constant = joint_constants_add(parser->constants, joint_value_character(value.character));
             break;
 
         case STRING_LITERAL_TOKEN:
-            joint_node_attach_string(literal, "value", parser->next_token->value->data);
+            string = joint_intern(token->value->data, token->value->length);
+            value.type = STRING_CHILDREN;
+            value.string = (char *) string->characters;
+            value.constant = joint_constants_add(parser->constants, joint_value_string(string));
             break;
 
         case NULL_LITERAL_TOKEN:
-            joint_node_attach_null(literal, "value");
+            value.type = NULL_CHILDREN;
+            value.constant = joint_constants_add(parser->constants, JOINT_VALUE_NULL);
             break;
 
         default:
-            assert(NULL);
+            joint_parser_fail(parser, token);
+            return;
     }
 
+    joint_parser_emit_enter(parser, LITERAL_NODE, relation, token->start_position);
+    joint_parser_emit_scalar(parser, &value);
+    joint_parser_emit_leave(parser, LITERAL_NODE, end_position != NULL ? end_position : token->end_position);
     joint_parser_get_next_token(parser);
-
-    return literal;
 }
 
-static joint_node_t * joint_parser_parse_primary_expression(joint_parser_t * parser) {
+static void joint_parser_parse_primary_expression(joint_parser_t * parser, char * relation, const joint_source_file_position_t * end_position) {
     switch (parser->next_token->type) {
         case IDENTIFIER_TOKEN:
-            return joint_parser_parse_identifier(parser);
+            joint_parser_parse_identifier(parser, relation, end_position);
+            break;
 
         case NUMERIC_LITERAL_TOKEN:
         case BOOLEAN_LITERAL_TOKEN:
         case CHARACTER_LITERAL_TOKEN:
         case STRING_LITERAL_TOKEN:
         case NULL_LITERAL_TOKEN:
-            return joint_parser_parse_literal(parser);
+            joint_parser_parse_literal(parser, relation, end_position);
+            break;
 
         default:
-            assert(NULL);
+            joint_parser_fail(parser, parser->next_token);
+            break;
+    }
+}
+
+static int joint_parser_add_expression(joint_parser_t * parser, enum joint_node_type type, size_t token) {
+    if (parser->expressions_length == parser->expressions_capacity) {
+        parser->expressions_capacity = parser->expressions_capacity > 0 ? parser->expressions_capacity * 2 : 16;
+        parser->expressions = JOINT_REALLOCATE(parser->allocator, parser->expressions, sizeof(joint_parser_expression_t) * parser->expressions_capacity);
+        assert(parser->expressions);
+    }
+
+    joint_parser_expression_t * expression = &parser->expressions[parser->expressions_length];
+    expression->type = type;
+    expression->relation = NULL;
+    expression->token = token;
+    expression->start_token = token;
+    expression->end_token = token;
+    expression->parent = -1;
+    expression->first = -1;
+    expression->next = -1;
+
+    return parser->expressions_length++;
+}
+
+/* Chains child after previous, or first when previous is -1. */
+static void joint_parser_adopt_expression(joint_parser_t * parser, int parent, int previous, int child, char * relation) {
+    if (previous < 0) {
+        parser->expressions[parent].first = child;
+    } else {
+        parser->expressions[previous].next = child;
+    }
+
+    parser->expressions[child].parent = parent;
+    parser->expressions[child].relation = relation;
+}
+
+static void joint_parser_push_operand(joint_parser_t * parser, int expression) {
+    if (parser->operands_length == parser->operands_capacity) {
+        parser->operands_capacity = parser->operands_capacity > 0 ? parser->operands_capacity * 2 : 16;
+        parser->operands = JOINT_REALLOCATE(parser->allocator, parser->operands, sizeof(int) * parser->operands_capacity);
+        assert(parser->operands);
+    }
+
+    parser->operands[parser->operands_length++] = expression;
+}
+
+static void joint_parser_push_operator(joint_parser_t * parser, size_t token, int precedence, bool unary, int callee) {
+    if (parser->operators_length == parser->operators_capacity) {
+        parser->operators_capacity = parser->operators_capacity > 0 ? parser->operators_capacity * 2 : 16;
+        parser->operators = JOINT_REALLOCATE(parser->allocator, parser->operators, sizeof(joint_parser_operator_t) * parser->operators_capacity);
+        assert(parser->operators);
+    }
+
+    joint_parser_operator_t * operator = &parser->operators[parser->operators_length++];
+    operator->token = token;
+    operator->precedence = precedence;
+    operator->unary = unary;
+    operator->callee = callee;
+}
+
+/* Replaces the operands of the innermost operator with its node. */
+static void joint_parser_reduce_operator(joint_parser_t * parser) {
+    joint_parser_operator_t operator = parser->operators[--parser->operators_length];
+    assert(operator.precedence > 0);
+
+    if (operator.unary) {
+        int argument = parser->operands[parser->operands_length - 1];
+        int unary = joint_parser_add_expression(parser, UNARY_EXPRESSION_NODE, operator.token);
+
+        parser->expressions[unary].end_token = parser->expressions[argument].end_token;
+        joint_parser_adopt_expression(parser, unary, -1, argument, "argument");
+        parser->operands[parser->operands_length - 1] = unary;
+    } else {
+        int right = parser->operands[--parser->operands_length];
+        int left = parser->operands[parser->operands_length - 1];
+        int binary = joint_parser_add_expression(parser, BINARY_EXPRESSION_NODE, operator.token);
+
+        parser->expressions[binary].start_token = parser->expressions[left].start_token;
+        parser->expressions[binary].end_token = parser->expressions[right].end_token;
+        joint_parser_adopt_expression(parser, binary, -1, left, "left");
+        joint_parser_adopt_expression(parser, binary, left, right, "right");
+        parser->operands[parser->operands_length - 1] = binary;
+    }
+}
+
+static void joint_parser_reduce_call(joint_parser_t * parser, const joint_parser_operator_t * call, size_t closing_token) {
+    int callee = parser->operands[call->callee];
+    int expression = joint_parser_add_expression(parser, CALL_EXPRESSION_NODE, call->token);
+    int previous = callee;
+
+    parser->expressions[expression].start_token = parser->expressions[callee].start_token;
+    parser->expressions[expression].end_token = closing_token;
+    joint_parser_adopt_expression(parser, expression, -1, callee, "callee");
+
+    for (int i = call->callee + 1; i < parser->operands_length; i++) {
+        joint_parser_adopt_expression(parser, expression, previous, parser->operands[i], "argument");
+        previous = parser->operands[i];
     }
+
+    parser->operands_length = call->callee + 1;
+    parser->operands[call->callee] = expression;
 }
 
-static joint_node_t * joint_parser_parse_call_expression(joint_parser_t * parser, joint_node_t * callee) {
-    joint_node_t * call_expression = joint_node_alloc(CALL_EXPRESSION_NODE, callee->start_position);
-    joint_node_attach_node(call_expression, "callee", callee);
+/* Lays out the expression at the next token by precedence climbing over
+ * an explicit operator stack, so long operator chains and deep nesting do
+ * not recurse. Stores the index of the first token past the expression in
+ * end_token and returns the root, or -1 after a syntax error. */
+static int joint_parser_layout_expression(joint_parser_t * parser, size_t * end_token) {
+    joint_token_t ** tokens = parser->tokenizer->tokens;
+    size_t token = parser->current_token;
+    bool operand = true;
 
-    joint_parser_expect_punctuator(parser, "(");
+    parser->expressions_length = 0;
+    parser->operators_length = 0;
+    parser->operands_length = 0;
 
     while (true) {
-        if (joint_parser_match_punctuator(parser, ")")) {
-            break;
+        enum joint_punctuator punctuator = joint_tokenizer_punctuator(tokens[token]);
+
+        if (operand) {
+            switch (tokens[token]->type) {
+                case IDENTIFIER_TOKEN:
+                    joint_parser_push_operand(parser, joint_parser_add_expression(parser, IDENTIFIER_NODE, token));
+                    operand = false;
+                    break;
+
+                case NUMERIC_LITERAL_TOKEN:
+                case BOOLEAN_LITERAL_TOKEN:
+                case CHARACTER_LITERAL_TOKEN:
+                case STRING_LITERAL_TOKEN:
+                case NULL_LITERAL_TOKEN:
+                    joint_parser_push_operand(parser, joint_parser_add_expression(parser, LITERAL_NODE, token));
+                    operand = false;
+                    break;
+
+                default:
+                    if (punctuator == LEFT_PARENTHESIS_PUNCTUATOR) {
+                        joint_parser_push_operator(parser, token, 0, false, -1);
+                    } else if (punctuator == RIGHT_PARENTHESIS_PUNCTUATOR && parser->operators_length > 0 && parser->operators[parser->operators_length - 1].callee >= 0 && joint_tokenizer_punctuator(tokens[token - 1]) == COMMA_PUNCTUATOR) {
+                        /* Argument lists may end with a comma. */
+                        joint_parser_reduce_call(parser, &parser->operators[--parser->operators_length], token);
+                        operand = false;
+                    } else if (joint_parser_unary_operators[punctuator]) {
+                        joint_parser_push_operator(parser, token, JOINT_PARSER_UNARY_PRECEDENCE, true, -1);
+                    } else {
+                        joint_parser_fail(parser, tokens[token]);
+                        return -1;
+                    }
+                    break;
+            }
+
+            token++;
+            continue;
         }
 
-        joint_node_t * argument = joint_parser_parse_primary_expression(parser);
-        joint_node_attach_node(call_expression, "argument", argument);
+        int precedence = joint_parser_binary_precedences[punctuator];
 
-        if (joint_parser_match_punctuator(parser, ",")) {
-            joint_parser_get_next_token(parser);
+        if (precedence > 0) {
+            while (parser->operators_length > 0 && parser->operators[parser->operators_length - 1].precedence >= precedence) {
+                joint_parser_reduce_operator(parser);
+            }
+
+            joint_parser_push_operator(parser, token++, precedence, false, -1);
+            operand = true;
+        } else if (punctuator == LEFT_PARENTHESIS_PUNCTUATOR) {
+            joint_parser_push_operator(parser, token++, 0, false, parser->operands_length - 1);
+
+            if (joint_tokenizer_punctuator(tokens[token]) == RIGHT_PARENTHESIS_PUNCTUATOR) {
+                joint_parser_reduce_call(parser, &parser->operators[--parser->operators_length], token++);
+            } else {
+                operand = true;
+            }
+        } else if (punctuator == COMMA_PUNCTUATOR || punctuator == RIGHT_PARENTHESIS_PUNCTUATOR) {
+            while (parser->operators_length > 0 && parser->operators[parser->operators_length - 1].precedence > 0) {
+                joint_parser_reduce_operator(parser);
+            }
+
+            /* Belongs to the syntax around the expression. */
+            if (parser->operators_length == 0) {
+                break;
+            }
+
+            joint_parser_operator_t * parenthesis = &parser->operators[parser->operators_length - 1];
+
+            if (punctuator == COMMA_PUNCTUATOR) {
+                if (parenthesis->callee < 0) {
+                    joint_parser_fail(parser, tokens[token]);
+                    return -1;
+                }
+
+                operand = true;
+            } else {
+                parser->operators_length--;
+
+                if (parenthesis->callee >= 0) {
+                    joint_parser_reduce_call(parser, parenthesis, token);
+                }
+            }
+
+            token++;
         } else {
             break;
         }
     }
 
-    call_expression->end_position = joint_node_clone_position(parser->next_token->end_position);
+    while (parser->operators_length > 0) {
+        /* An unclosed parenthesis. */
+        if (parser->operators[parser->operators_length - 1].precedence == 0) {
+            joint_parser_fail(parser, tokens[token]);
+            return -1;
+        }
+
+        joint_parser_reduce_operator(parser);
+    }
+
+    assert(parser->operands_length == 1);
+    *end_token = token;
+
+    return parser->operands[0];
+}
+
+/* Emits the laid out expression in document order, walking up through the
+ * parents instead of recursing. end_position overrides the end of the root. */
+static void joint_parser_emit_expression(joint_parser_t * parser, int root, char * relation, const joint_source_file_position_t * end_position) {
+    joint_token_t ** tokens = parser->tokenizer->tokens;
+    int index = root;
+
+    parser->expressions[root].relation = relation;
+
+    while (true) {
+        const joint_parser_expression_t * expression = &parser->expressions[index];
+
+        if (expression->first >= 0) {
+            joint_parser_emit_enter(parser, expression->type, expression->relation, tokens[expression->start_token]->start_position);
+
+            if (expression->type != CALL_EXPRESSION_NODE) {
+                const char * spelling = joint_parser_operator_spellings[joint_tokenizer_punctuator(tokens[expression->token])];
+                joint_node_children_t operator = {.type = STRING_CHILDREN, .constant = JOINT_NODE_STATIC_STRING, .name = "operator", .string = (char *) spelling};
+                joint_parser_emit_scalar(parser, &operator);
+            }
+
+            index = expression->first;
+            continue;
+        }
+
+        joint_parser_seek(parser, expression->token);
+        joint_parser_parse_primary_expression(parser, expression->relation, index == root ? end_position : NULL);
+
+        while (index != root && parser->expressions[index].next < 0) {
+            index = parser->expressions[index].parent;
+            expression = &parser->expressions[index];
+            joint_parser_emit_leave(parser, expression->type, index == root && end_position != NULL ? end_position : tokens[expression->end_token]->end_position);
+        }
+
+        if (index == root) {
+            break;
+        }
+
+        index = parser->expressions[index].next;
+    }
+}
+
+static void joint_parser_parse_expression(joint_parser_t * parser, char * relation) {
+    size_t end_token;
+    int root = joint_parser_layout_expression(parser, &end_token);
 
-    joint_parser_expect_punctuator(parser, ")");
+    if (root < 0) {
+        return;
+    }
 
-    return call_expression;
+    joint_parser_emit_expression(parser, root, relation, NULL);
+    joint_parser_seek(parser, end_token);
 }
 
-static joint_node_t * joint_parser_parse_left_hand_side_expression_allow_call(joint_parser_t * parser) {
-    joint_node_t * expression = joint_parser_parse_primary_expression(parser);
+/* The expression node of a statement ends with its semicolon. */
+static const joint_source_file_position_t * joint_parser_parse_expression_statement(joint_parser_t * parser, char * relation) {
+    size_t end_token;
+    int root = joint_parser_layout_expression(parser, &end_token);
 
-    while (joint_parser_match_punctuator(parser, "(")) {
-        expression = joint_parser_parse_call_expression(parser, expression);
+    if (root < 0) {
+        return NULL;
     }
 
-    free(expression->end_position->path);
-    free(expression->end_position);
-    expression->end_position = joint_node_clone_position(parser->next_token->end_position);
+    const joint_source_file_position_t * end_position = parser->tokenizer->tokens[end_token]->end_position;
 
-    joint_parser_expect_punctuator(parser, ";");
+    joint_parser_emit_expression(parser, root, relation, end_position);
+    joint_parser_seek(parser, end_token);
+    joint_parser_expect_punctuator(parser, SEMICOLON_PUNCTUATOR);
 
-    return expression;
+    return end_position;
 }
 
-static joint_node_t * joint_parser_parse_import_declaration(joint_parser_t * parser) {
-    joint_node_t * import_declaration = joint_node_alloc(IMPORT_DECLARATION_NODE, parser->next_token->start_position);
+static const joint_source_file_position_t * joint_parser_parse_import_declaration(joint_parser_t * parser, char * relation) {
+    joint_parser_emit_enter(parser, IMPORT_DECLARATION_NODE, relation, parser->next_token->start_position);
 
     joint_parser_expect_keyword(parser, "import");
-    joint_parser_expect_punctuator(parser, "{");
+    joint_parser_expect_punctuator(parser, LEFT_BRACE_PUNCTUATOR);
 
     while (true) {
-        joint_node_t * specifier = joint_parser_parse_identifier(parser);
-        joint_node_attach_node(import_declaration, "specifier", specifier);
+        joint_parser_parse_identifier(parser, "specifier", NULL);
 
-        if (joint_parser_match_punctuator(parser, ",")) {
+        if (joint_parser_match_punctuator(parser, COMMA_PUNCTUATOR)) {
             joint_parser_get_next_token(parser);
         } else {
             break;
         }
     }
 
-    joint_parser_expect_punctuator(parser, "}");
+    joint_parser_expect_punctuator(parser, RIGHT_BRACE_PUNCTUATOR);
     joint_parser_expect_keyword(parser, "from");
 
-    assert(parser->next_token->type == STRING_LITERAL_TOKEN);
-    joint_node_t * source = joint_parser_parse_literal(parser);
-    joint_node_attach_node(import_declaration, "source", source);
+    if (parser->next_token->type == STRING_LITERAL_TOKEN) {
+        joint_parser_parse_literal(parser, "source", NULL);
+    } else {
+        joint_parser_fail(parser, parser->next_token);
+    }
 
-    import_declaration->end_position = joint_node_clone_position(parser->next_token->end_position);
+    const joint_source_file_position_t * end_position = parser->next_token->end_position;
+    joint_parser_emit_leave(parser, IMPORT_DECLARATION_NODE, end_position);
 
-    joint_parser_expect_punctuator(parser, ";");
+    joint_parser_expect_punctuator(parser, SEMICOLON_PUNCTUATOR);
 
-    return import_declaration;
+    return end_position;
 }
 
-static joint_node_t * joint_parser_parse_variable_declaration(joint_parser_t * parser) {
-    joint_node_t * variable_declaration = joint_node_alloc(VARIABLE_DECLARATION_NODE, parser->next_token->start_position);
+static const joint_source_file_position_t * joint_parser_parse_variable_declaration(joint_parser_t * parser, char * relation) {
+    joint_parser_emit_enter(parser, VARIABLE_DECLARATION_NODE, relation, parser->next_token->start_position);
 
     joint_parser_expect_keyword(parser, "let");
 
-    joint_node_t * id = joint_parser_parse_identifier(parser);
-    joint_node_attach_node(variable_declaration, "id", id);
+    joint_parser_parse_identifier(parser, "id", NULL);
 
-    joint_parser_expect_punctuator(parser, ":");
+    joint_parser_expect_punctuator(parser, COLON_PUNCTUATOR);
 
-    joint_node_t * type = joint_parser_parse_identifier(parser);
-    joint_node_attach_node(variable_declaration, "type", type);
+    joint_parser_parse_identifier(parser, "type", NULL);
 
-    if (joint_parser_match_punctuator(parser, "?")) {
+    joint_node_children_t optional = {.type = BOOLEAN_CHILDREN, .constant = -1, .name = "optional", .boolean = false};
+
+    if (joint_parser_match_punctuator(parser, QUESTION_PUNCTUATOR)) {
         joint_parser_get_next_token(parser);
-        joint_node_attach_boolean(variable_declaration, "optional", true);
-    } else {
-        joint_node_attach_boolean(variable_declaration, "optional", false);
+        optional.boolean = true;
     }
 
-    joint_parser_expect_punctuator(parser, "=");
+    joint_parser_emit_scalar(parser, &optional);
 
-    joint_node_t * init = joint_parser_parse_primary_expression(parser);
-    joint_node_attach_node(variable_declaration, "init", init);
+    joint_parser_expect_punctuator(parser, ASSIGN_PUNCTUATOR);
 
-    variable_declaration->end_position = joint_node_clone_position(parser->next_token->end_position);
+    joint_parser_parse_expression(parser, "init");
 
-    joint_parser_expect_punctuator(parser, ";");
+    const joint_source_file_position_t * end_position = parser->next_token->end_position;
+    joint_parser_emit_leave(parser, VARIABLE_DECLARATION_NODE, end_position);
 
-    return variable_declaration;
+    joint_parser_expect_punctuator(parser, SEMICOLON_PUNCTUATOR);
+
+    return end_position;
 }
 
-static joint_node_t * joint_parser_parse_program_element(joint_parser_t * parser) {
+/* Returns the end of the element, or NULL after a syntax error. */
+static const joint_source_file_position_t * joint_parser_parse_program_element(joint_parser_t * parser, char * relation) {
     if (parser->next_token->type == COMMENT_TOKEN) {
-        return joint_parser_parse_comment(parser);
+        return joint_parser_parse_comment(parser, relation);
     } else if (parser->next_token->type == KEYWORD_TOKEN) {
         if (strcmp(parser->next_token->value->data, "import") == 0) {
-            return joint_parser_parse_import_declaration(parser);
+            return joint_parser_parse_import_declaration(parser, relation);
         } else if (strcmp(parser->next_token->value->data, "let") == 0) {
-            return joint_parser_parse_variable_declaration(parser);
+            return joint_parser_parse_variable_declaration(parser, relation);
         }
     } else {
-        return joint_parser_parse_left_hand_side_expression_allow_call(parser);
+        return joint_parser_parse_expression_statement(parser, relation);
     }
 
+    joint_parser_fail(parser, parser->next_token);
+
     return NULL;
 }
 
-static joint_node_t * joint_parser_parse_program(joint_parser_t * parser) {
-    joint_node_t * program = joint_node_alloc(PROGRAM_NODE, parser->next_token->start_position);
-    joint_node_t * program_element = NULL;
+static void joint_parser_parse_program(joint_parser_t * parser) {
+    const joint_source_file_position_t * end_position = NULL;
+
+    joint_parser_emit_enter(parser, PROGRAM_NODE, NULL, parser->next_token->start_position);
+
+    while (parser->next_token->type != EOF_TOKEN && parser->error == NULL) {
+        end_position = joint_parser_parse_program_element(parser, "body");
+    }
+
+    joint_parser_emit_leave(parser, PROGRAM_NODE, end_position != NULL ? end_position : parser->next_token->end_position);
+}
+
+typedef struct joint_parser_builder {
+    joint_allocator_t * allocator;
+    int nodes_length;
+    int nodes_capacity;
+    joint_node_t ** nodes;
+    joint_node_t * root;
+} joint_parser_builder_t;
+
+static void joint_parser_builder_enter_node(enum joint_node_type type, char * relation, const joint_source_file_position_t * start_position, void * data) {
+    joint_parser_builder_t * builder = data;
+    joint_node_t * node = joint_node_alloc(builder->allocator, type, start_position);
+
+    if (builder->nodes_length > 0) {
+        joint_node_attach_node(builder->nodes[builder->nodes_length - 1], relation, node);
+    }
+
+    if (builder->nodes_length == builder->nodes_capacity) {
+        builder->nodes_capacity = builder->nodes_capacity > 0 ? builder->nodes_capacity * 2 : 8;
+        builder->nodes = realloc(builder->nodes, builder->nodes_capacity * sizeof(joint_node_t *));
+        assert(builder->nodes);
+    }
+
+    builder->nodes[builder->nodes_length++] = node;
+}
+
+static void joint_parser_builder_scalar_child(const joint_node_children_t * relation, void * data) {
+    joint_parser_builder_t * builder = data;
+    joint_node_attach_scalar(builder->nodes[builder->nodes_length - 1], relation);
+}
+
+static void joint_parser_builder_leave_node(enum joint_node_type type, const joint_source_file_position_t * end_position, void * data) {
+    joint_parser_builder_t * builder = data;
+    joint_node_t * node = builder->nodes[--builder->nodes_length];
+
+    assert(node->type == type);
+    node->end_position = joint_node_clone_position(builder->allocator, end_position);
 
-    while (parser->next_token->type != EOF_TOKEN) {
-        program_element = joint_parser_parse_program_element(parser);
-        joint_node_attach_node(program, "body", program_element);
+    if (builder->nodes_length == 0) {
+        builder->root = node;
     }
+}
+
+static void joint_parser_builder_begin(joint_parser_t * parser, joint_parser_builder_t * builder, joint_parser_events_t * events) {
+    builder->allocator = parser->allocator;
+    builder->nodes_length = 0;
+    builder->nodes_capacity = 0;
+    builder->nodes = NULL;
+    builder->root = NULL;
+
+    events->enter_node = joint_parser_builder_enter_node;
+    events->scalar_child = joint_parser_builder_scalar_child;
+    events->leave_node = joint_parser_builder_leave_node;
+    events->data = builder;
+
+    parser->events = events;
+}
 
-    if (program_element == NULL) {
-        program->end_position = joint_node_clone_position(parser->next_token->end_position);
+/* After a syntax error the nodes still open hold the partial tree, which is
+ * freed from its root. */
+static joint_node_t * joint_parser_builder_end(joint_parser_t * parser, joint_parser_builder_t * builder) {
+    joint_node_t * root = builder->root;
+
+    if (parser->error != NULL) {
+        if (builder->nodes_length > 0) {
+            root = builder->nodes[0];
+        }
+
+        if (root != NULL) {
+            joint_node_free(root);
+        }
+
+        root = NULL;
     } else {
-        program->end_position = joint_node_clone_position(program_element->end_position);
+        assert(builder->nodes_length == 0);
     }
 
-    return program;
+    free(builder->nodes);
+    parser->events = NULL;
+    return root;
 }
 
-joint_parser_t * joint_parser_alloc(joint_tokenizer_t * tokenizer) {
+joint_parser_t * joint_parser_alloc(joint_allocator_t * allocator, joint_tokenizer_t * tokenizer) {
     assert(tokenizer->tokens_length > 0);
 
-    joint_parser_t * parser = malloc(sizeof(joint_parser_t));
+    joint_parser_t * parser = JOINT_ALLOCATE(allocator, sizeof(joint_parser_t));
     assert(parser);
 
+    parser->allocator = allocator;
     parser->tokenizer = tokenizer;
     parser->current_token = 0;
     parser->next_token = tokenizer->tokens[0];
+    parser->events = NULL;
+    parser->program = NULL;
+    parser->error = NULL;
+    parser->error_token = NULL;
+    parser->constants = joint_constants_alloc();
+
+    parser->expressions_length = 0;
+    parser->expressions_capacity = 0;
+    parser->expressions = NULL;
+    parser->operators_length = 0;
+    parser->operators_capacity = 0;
+    parser->operators = NULL;
+    parser->operands_length = 0;
+    parser->operands_capacity = 0;
+    parser->operands = NULL;
 
     return parser;
 }
 
-void joint_parser_parse(joint_parser_t * parser) {
-    parser->program = joint_parser_parse_program(parser);
+void joint_parser_seek(joint_parser_t * parser, size_t token) {
+    assert(token < parser->tokenizer->tokens_length);
+    parser->current_token = token;
+    parser->next_token = parser->tokenizer->tokens[token];
+}
+
+joint_node_t * joint_parser_parse_element(joint_parser_t * parser) {
+    joint_parser_builder_t builder;
+    joint_parser_events_t events;
+
+    parser->error = NULL;
+    parser->error_token = NULL;
+    joint_parser_builder_begin(parser, &builder, &events);
+    joint_parser_parse_program_element(parser, "body");
+
+    return joint_parser_builder_end(parser, &builder);
+}
+
+bool joint_parser_parse(joint_parser_t * parser) {
+    joint_parser_builder_t builder;
+    joint_parser_events_t events;
+
+    parser->error = NULL;
+    parser->error_token = NULL;
+    joint_parser_builder_begin(parser, &builder, &events);
+    joint_parser_parse_program(parser);
+
+    parser->program = joint_parser_builder_end(parser, &builder);
+
+    return parser->error == NULL;
+}
+
+bool joint_parser_stream(joint_parser_t * parser, const joint_parser_events_t * events) {
+    parser->error = NULL;
+    parser->error_token = NULL;
+    parser->events = events;
+    joint_parser_parse_program(parser);
+    parser->events = NULL;
+
+    return parser->error == NULL;
+}
+
+int joint_parser_format_error(const joint_parser_t * parser, char * buffer, size_t size) {
+    const joint_token_t * token = parser->error_token;
+
+    assert(parser->error != NULL);
+
+    if (token->type == EOF_TOKEN || token->value == NULL) {
+        return snprintf(buffer, size, "%s:%zu:%zu: %s", token->start_position->path, token->start_position->line + 1, token->start_position->code_point_column + 1, parser->error);
+    }
+
+    return snprintf(buffer, size, "%s:%zu:%zu: %s \"%s\"", token->start_position->path, token->start_position->line + 1, token->start_position->code_point_column + 1, parser->error, token->value->data);
+}
+
+void joint_parser_print_error(const joint_parser_t * parser) {
+    int length = joint_parser_format_error(parser, NULL, 0);
+    char * buffer = malloc(length + 1);
+    assert(buffer);
+
+    joint_parser_format_error(parser, buffer, length + 1);
+    fprintf(stderr, "%s\n", buffer);
+    free(buffer);
 }
 
 void joint_parser_print(const joint_parser_t * parser) {
-    joint_node_print(parser->program, 0);
+    joint_node_print(parser->program);
 }
 
 void joint_parser_free(joint_parser_t * parser) {
-    joint_node_free(parser->program);
-    free(parser);
+    if (parser->program != NULL) {
+        joint_node_free(parser->program);
+    }
+
+    joint_constants_free(parser->constants);
+
+    if (parser->expressions != NULL) {
+        JOINT_DEALLOCATE(parser->allocator, parser->expressions);
+    }
+
+    if (parser->operators != NULL) {
+        JOINT_DEALLOCATE(parser->allocator, parser->operators);
+    }
+
+    if (parser->operands != NULL) {
+        JOINT_DEALLOCATE(parser->allocator, parser->operands);
+    }
+
+    JOINT_DEALLOCATE(parser->allocator, parser);
 }
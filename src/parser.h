@@ -23,58 +23,98 @@
 #define joint_parser_h
 
 #include <stdbool.h>
+#include "allocator.h"
+#include "constants.h"
+#include "node.h"
 #include "tokenizer.h"
 
-enum joint_node_type {
-    PROGRAM_NODE,
-    COMMENT_NODE,
-    IDENTIFIER_NODE,
-    LITERAL_NODE,
-    CALL_EXPRESSION_NODE,
-    IMPORT_DECLARATION_NODE,
-    VARIABLE_DECLARATION_NODE
-};
-
-typedef struct joint_node {
+/* Events arrive in document order. enter_node receives the relation through
+ * which the node hangs off its parent (NULL for the root), scalar_child a
+ * relation of the innermost open node. Positions and strings point into the
+ * tokenizer and must be copied to outlive it, except strings of scalars with
+ * a constant, which are interned. */
+typedef struct joint_parser_events {
+    void (* enter_node)(enum joint_node_type type, char * relation, const joint_source_file_position_t * start_position, void * data);
+    void (* scalar_child)(const joint_node_children_t * relation, void * data);
+    void (* leave_node)(enum joint_node_type type, const joint_source_file_position_t * end_position, void * data);
+    void * data;
+} joint_parser_events_t;
+
+/* A node of an expression laid out by its operators before any event of it
+ * is emitted. Tokens are indexes into the tokenizer, childrens are chained
+ * from first through next. */
+typedef struct joint_parser_expression {
     enum joint_node_type type;
-    int childrens_length;
-    struct joint_node_children ** childrens;
-
-    joint_source_file_position_t * start_position;
-    joint_source_file_position_t * end_position;
-} joint_node_t;
-
-typedef struct joint_node_children {
-    enum {
-        NODE_CHILDREN,
-        NUMBER_CHILDREN,
-        BOOLEAN_CHILDREN,
-        CHARACTER_CHILDREN,
-        STRING_CHILDREN,
-        NULL_CHILDREN
-    } type;
-
-    char * name;
-
-    union {
-        joint_node_t * node;
-        long double number;
-        bool boolean;
-        char character;
-        char * string;
-    };
-} joint_node_children_t;
+    char * relation;
+    size_t token;
+    size_t start_token;
+    size_t end_token;
+    int parent;
+    int first;
+    int next;
+} joint_parser_expression_t;
+
+/* An operator waiting for its right operand. Parentheses have precedence 0
+ * and stop reductions, callee is the operand index of the callee of a call
+ * and -1 for a parenthesized expression. */
+typedef struct joint_parser_operator {
+    size_t token;
+    int precedence;
+    bool unary;
+    int callee;
+} joint_parser_operator_t;
 
 typedef struct joint_parser {
+    joint_allocator_t * allocator;
     joint_tokenizer_t * tokenizer;
-    int current_token;
+    size_t current_token;
     joint_token_t * next_token;
+    const joint_parser_events_t * events;
     joint_node_t * program;
+
+    /* The first syntax error and the token it was found at, parsing stops
+     * there. NULL while there is none. */
+    const char * error;
+    const joint_token_t * error_token;
+
+    /* Literals of every parsed element, scalars of literal nodes carry
+     * their index. */
+    joint_constants_t * constants;
+
+    /* Scratch space of the operator parser, reused by every expression. */
+    int expressions_length;
+    int expressions_capacity;
+    joint_parser_expression_t * expressions;
+    int operators_length;
+    int operators_capacity;
+    joint_parser_operator_t * operators;
+    int operands_length;
+    int operands_capacity;
+    int * operands;
 } joint_parser_t;
 
-joint_parser_t * joint_parser_alloc(joint_tokenizer_t * tokenizer);
+/* Nodes of the program are allocated from allocator. */
+joint_parser_t * joint_parser_alloc(joint_allocator_t * allocator, joint_tokenizer_t * tokenizer);
+
+void joint_parser_seek(joint_parser_t * parser, size_t token);
+
+/* Returns NULL after a syntax error. */
+joint_node_t * joint_parser_parse_element(joint_parser_t * parser);
+
+/* Leaves program NULL and returns false after a syntax error. */
+bool joint_parser_parse(joint_parser_t * parser);
+
+/* Parses the program into events without building a tree, so memory stays
+ * proportional to the nesting depth. After a syntax error the events stop,
+ * leaving the nodes entered so far open, and false is returned. */
+bool joint_parser_stream(joint_parser_t * parser, const joint_parser_events_t * events);
+
+/* Writes the syntax error as path:line:column: message, the way semantic
+ * diagnostics are reported, and returns its length like snprintf. */
+int joint_parser_format_error(const joint_parser_t * parser, char * buffer, size_t size);
 
-void joint_parser_parse(joint_parser_t * parser);
+/* Writes the syntax error to stderr. */
+void joint_parser_print_error(const joint_parser_t * parser);
 
 void joint_parser_print(const joint_parser_t * parser);
 
@@ -0,0 +1,341 @@
+/* Copyright (c) 2014 Vyacheslav Slinko
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include "intern.h"
+#include "passes.h"
+#include "symbol_table.h"
+
+/* Identifiers reached through these relations name a binding instead of
+ * using one. */
+static bool joint_passes_is_use(const joint_node_children_t * relation) {
+    return relation->type == NODE_CHILDREN && relation->node->type == IDENTIFIER_NODE && strcmp(relation->name, "id") != 0 && strcmp(relation->name, "type") != 0 && strcmp(relation->name, "specifier") != 0;
+}
+
+static const joint_node_children_t * joint_passes_children(const joint_node_t * node, const char * name) {
+    for (int i = 0; i < node->childrens_length; i++) {
+        if (strcmp(node->childrens[i]->name, name) == 0) {
+            return node->childrens[i];
+        }
+    }
+
+    return NULL;
+}
+
+/* The first lookup swaps the name of the identifier for its interned copy, so
+ * that later passes over the same node do not intern it again. */
+static const joint_intern_string_t * joint_passes_name(joint_node_t * identifier) {
+    joint_node_children_t * name = identifier->childrens[0];
+
+    if (name->constant != JOINT_NODE_INTERNED_STRING) {
+        const joint_intern_string_t * string = joint_intern_cstring(name->string);
+
+        if (name->constant == -1) {
+            JOINT_DEALLOCATE(identifier->allocator, name->string);
+        }
+
+        name->constant = JOINT_NODE_INTERNED_STRING;
+        name->string = (char *) string->characters;
+    }
+
+    return joint_intern_of(name->string);
+}
+
+static const joint_intern_string_t * joint_passes_declared_name(const joint_node_t * variable_declaration) {
+    return joint_passes_name(joint_passes_children(variable_declaration, "id")->node);
+}
+
+/* Calls use for every identifier used by the element, the element itself
+ * included, through the relation pointing at the identifier. */
+typedef void (* joint_passes_use_t)(joint_node_children_t * relation, void * data);
+
+typedef struct joint_passes_uses_state {
+    joint_passes_use_t use;
+    void * data;
+} joint_passes_uses_state_t;
+
+static joint_node_walk_action_t joint_passes_uses_enter(joint_node_t * node, const joint_node_children_t * relation, int depth, void * data) {
+    joint_passes_uses_state_t * state = data;
+
+    for (int i = 0; i < node->childrens_length; i++) {
+        if (joint_passes_is_use(node->childrens[i])) {
+            state->use(node->childrens[i], state->data);
+        }
+    }
+
+    return JOINT_NODE_WALK_CONTINUE;
+}
+
+static void joint_passes_uses(joint_node_walker_t * walker, joint_node_children_t * element, joint_passes_use_t use, void * data) {
+    joint_passes_uses_state_t state = {.use = use, .data = data};
+    joint_node_visitor_t visitor = {.enter = joint_passes_uses_enter, .scalar = NULL, .leave = NULL, .data = &state};
+
+    if (joint_passes_is_use(element)) {
+        use(element, data);
+    }
+
+    joint_node_walker_walk(walker, element->node, &visitor);
+}
+
+/* Constant propagation */
+
+typedef struct joint_passes_constants {
+    joint_symbol_table_t * table;
+    int literals_length;
+    int literals_capacity;
+    const joint_node_t ** literals;
+    int changes;
+} joint_passes_constants_t;
+
+static joint_node_t * joint_passes_clone_literal(const joint_node_t * literal, const joint_node_t * identifier) {
+    joint_node_t * clone = joint_node_alloc(identifier->allocator, LITERAL_NODE, identifier->start_position);
+    const joint_node_children_t * value = literal->childrens[0];
+
+    clone->end_position = joint_node_clone_position(identifier->allocator, identifier->end_position);
+    joint_node_attach_scalar(clone, value);
+
+    return clone;
+}
+
+static void joint_passes_constants_use(joint_node_children_t * relation, void * data) {
+    joint_passes_constants_t * constants = data;
+    int literal = joint_symbol_table_lookup(constants->table, joint_passes_name(relation->node));
+
+    if (literal < 0 || constants->literals[literal] == NULL) {
+        return;
+    }
+
+    joint_node_t * identifier = relation->node;
+    relation->node = joint_passes_clone_literal(constants->literals[literal], identifier);
+    joint_node_free(identifier);
+    constants->changes++;
+}
+
+/* A NULL literal marks a binding that is not a constant but shadows one. */
+static void joint_passes_constants_declare(joint_passes_constants_t * constants, const joint_intern_string_t * name, const joint_node_t * literal) {
+    if (constants->literals_length == constants->literals_capacity) {
+        constants->literals_capacity *= 2;
+        constants->literals = realloc(constants->literals, sizeof(joint_node_t *) * constants->literals_capacity);
+        assert(constants->literals);
+    }
+
+    constants->literals[constants->literals_length] = literal;
+    joint_symbol_table_declare(constants->table, name, constants->literals_length++);
+}
+
+int joint_passes_propagate_constants(joint_node_t * program, void * data) {
+    joint_passes_constants_t constants = {
+        .table = joint_symbol_table_alloc(),
+        .literals_length = 0,
+        .literals_capacity = 64,
+        .literals = malloc(sizeof(joint_node_t *) * 64),
+        .changes = 0
+    };
+    assert(constants.literals);
+
+    joint_node_walker_t * walker = joint_node_walker_alloc();
+
+    for (int i = 0; i < program->childrens_length; i++) {
+        joint_node_t * element = program->childrens[i]->node;
+
+        joint_passes_uses(walker, program->childrens[i], joint_passes_constants_use, &constants);
+
+        if (element->type == VARIABLE_DECLARATION_NODE) {
+            const joint_node_t * init = joint_passes_children(element, "init")->node;
+            joint_passes_constants_declare(&constants, joint_passes_declared_name(element), init->type == LITERAL_NODE ? init : NULL);
+        } else if (element->type == IMPORT_DECLARATION_NODE) {
+            for (int j = 0; j < element->childrens_length; j++) {
+                if (strcmp(element->childrens[j]->name, "specifier") == 0) {
+                    joint_passes_constants_declare(&constants, joint_passes_name(element->childrens[j]->node), NULL);
+                }
+            }
+        }
+    }
+
+    joint_node_walker_free(walker);
+    joint_symbol_table_free(constants.table);
+    free(constants.literals);
+
+    return constants.changes;
+}
+
+/* Use counting shared by dead binding elimination and import pruning */
+
+typedef struct joint_passes_binding {
+    int element;
+    /* Index of the specifier in the import declaration, -1 for lets. */
+    int specifier;
+    int uses;
+} joint_passes_binding_t;
+
+typedef struct joint_passes_bindings {
+    joint_symbol_table_t * table;
+    int length;
+    int capacity;
+    joint_passes_binding_t * bindings;
+} joint_passes_bindings_t;
+
+static void joint_passes_bindings_use(joint_node_children_t * relation, void * data) {
+    joint_passes_bindings_t * bindings = data;
+    int binding = joint_symbol_table_lookup(bindings->table, joint_passes_name(relation->node));
+
+    if (binding >= 0) {
+        bindings->bindings[binding].uses++;
+    }
+}
+
+static void joint_passes_bindings_declare(joint_passes_bindings_t * bindings, const joint_intern_string_t * name, int element, int specifier) {
+    if (bindings->length == bindings->capacity) {
+        bindings->capacity *= 2;
+        bindings->bindings = realloc(bindings->bindings, sizeof(joint_passes_binding_t) * bindings->capacity);
+        assert(bindings->bindings);
+    }
+
+    bindings->bindings[bindings->length].element = element;
+    bindings->bindings[bindings->length].specifier = specifier;
+    bindings->bindings[bindings->length].uses = 0;
+    joint_symbol_table_declare(bindings->table, name, bindings->length++);
+}
+
+static void joint_passes_count_uses(joint_node_t * program, joint_passes_bindings_t * bindings) {
+    bindings->table = joint_symbol_table_alloc();
+    bindings->length = 0;
+    bindings->capacity = 64;
+    bindings->bindings = malloc(sizeof(joint_passes_binding_t) * bindings->capacity);
+    assert(bindings->bindings);
+
+    joint_node_walker_t * walker = joint_node_walker_alloc();
+
+    for (int i = 0; i < program->childrens_length; i++) {
+        joint_node_t * element = program->childrens[i]->node;
+
+        joint_passes_uses(walker, program->childrens[i], joint_passes_bindings_use, bindings);
+
+        if (element->type == VARIABLE_DECLARATION_NODE) {
+            joint_passes_bindings_declare(bindings, joint_passes_declared_name(element), i, -1);
+        } else if (element->type == IMPORT_DECLARATION_NODE) {
+            for (int j = 0; j < element->childrens_length; j++) {
+                if (strcmp(element->childrens[j]->name, "specifier") == 0) {
+                    joint_passes_bindings_declare(bindings, joint_passes_name(element->childrens[j]->node), i, j);
+                }
+            }
+        }
+    }
+
+    joint_node_walker_free(walker);
+    joint_symbol_table_free(bindings->table);
+}
+
+/* Dead binding elimination */
+
+int joint_passes_eliminate_dead_bindings(joint_node_t * program, void * data) {
+    joint_passes_bindings_t bindings;
+    joint_passes_count_uses(program, &bindings);
+
+    bool * removed = calloc(program->childrens_length > 0 ? program->childrens_length : 1, sizeof(bool));
+    assert(removed);
+    int changes = 0;
+
+    for (int i = 0; i < bindings.length; i++) {
+        if (bindings.bindings[i].specifier >= 0 || bindings.bindings[i].uses > 0) {
+            continue;
+        }
+
+        const joint_node_t * init = joint_passes_children(program->childrens[bindings.bindings[i].element]->node, "init")->node;
+
+        /* Only calls can have side effects. */
+        if (init->type == LITERAL_NODE || init->type == IDENTIFIER_NODE) {
+            removed[bindings.bindings[i].element] = true;
+            changes++;
+        }
+    }
+
+    if (changes > 0) {
+        joint_node_remove_childrens(program, removed);
+    }
+
+    free(removed);
+    free(bindings.bindings);
+
+    return changes;
+}
+
+/* Unused import pruning */
+
+int joint_passes_prune_imports(joint_node_t * program, void * data) {
+    joint_passes_bindings_t bindings;
+    joint_passes_count_uses(program, &bindings);
+
+    bool * removed = calloc(program->childrens_length > 0 ? program->childrens_length : 1, sizeof(bool));
+    assert(removed);
+    int changes = 0;
+
+    for (int i = 0; i < bindings.length;) {
+        int element_index = bindings.bindings[i].element;
+
+        if (bindings.bindings[i].specifier < 0) {
+            i++;
+            continue;
+        }
+
+        /* Specifiers of one import are declared next to each other. */
+        joint_node_t * element = program->childrens[element_index]->node;
+        bool * removed_specifiers = calloc(element->childrens_length, sizeof(bool));
+        assert(removed_specifiers);
+        int specifiers_length = 0;
+        int removed_length = 0;
+
+        for (; i < bindings.length && bindings.bindings[i].element == element_index; i++) {
+            specifiers_length++;
+
+            if (bindings.bindings[i].uses == 0) {
+                removed_specifiers[bindings.bindings[i].specifier] = true;
+                removed_length++;
+            }
+        }
+
+        if (removed_length == specifiers_length) {
+            removed[element_index] = true;
+        } else if (removed_length > 0) {
+            joint_node_remove_childrens(element, removed_specifiers);
+        }
+
+        changes += removed_length;
+        free(removed_specifiers);
+    }
+
+    if (changes > 0) {
+        joint_node_remove_childrens(program, removed);
+    }
+
+    free(removed);
+    free(bindings.bindings);
+
+    return changes;
+}
+
+void joint_passes_add_defaults(joint_optimizer_t * optimizer) {
+    joint_optimizer_add_pass(optimizer, "constant propagation", joint_passes_propagate_constants, NULL);
+    joint_optimizer_add_pass(optimizer, "dead binding elimination", joint_passes_eliminate_dead_bindings, NULL);
+    joint_optimizer_add_pass(optimizer, "unused import pruning", joint_passes_prune_imports, NULL);
+}
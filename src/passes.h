@@ -0,0 +1,39 @@
+/* Copyright (c) 2014 Vyacheslav Slinko
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef joint_passes_h
+#define joint_passes_h
+
+#include "node.h"
+#include "optimizer.h"
+
+/* Replaces uses of bindings initialized with a literal by the literal. */
+int joint_passes_propagate_constants(joint_node_t * program, void * data);
+
+/* Removes let declarations that are never used and have no side effects. */
+int joint_passes_eliminate_dead_bindings(joint_node_t * program, void * data);
+
+/* Removes imported names that are never used, and imports left empty. */
+int joint_passes_prune_imports(joint_node_t * program, void * data);
+
+void joint_passes_add_defaults(joint_optimizer_t * optimizer);
+
+#endif
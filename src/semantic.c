@@ -0,0 +1,533 @@
+/* Copyright (c) 2014 Vyacheslav Slinko
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <assert.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "builtins.h"
+#include "interface.h"
+#include "intern.h"
+#include "loader.h"
+#include "module.h"
+#include "semantic.h"
+#include "symbol_table.h"
+
+typedef struct joint_semantic_symbol {
+    joint_type_t type;
+    const joint_builtin_t * builtin;
+} joint_semantic_symbol_t;
+
+/* The type of a checked subexpression, and the builtin an identifier
+ * refers to so that calls can check their arguments count. */
+typedef struct joint_semantic_value {
+    joint_type_t type;
+    const joint_builtin_t * builtin;
+} joint_semantic_value_t;
+
+typedef struct joint_semantic {
+    joint_symbol_table_t * table;
+
+    int symbols_length;
+    int symbols_capacity;
+    joint_semantic_symbol_t * symbols;
+
+    /* Interned names of the built-in types, annotations are resolved by
+     * pointer comparison. */
+    const joint_intern_string_t * type_names[STRING_TYPE + 1];
+
+    /* Resolved paths of the imported modules in program order, NULL for
+     * built-in and unresolved ones. Their sources are loaded ahead while
+     * the imports before them are checked, unless find_interface supplies
+     * their interfaces. */
+    int imports_length;
+    int next_import;
+    char ** imports;
+    joint_loader_t * loader;
+    joint_semantic_find_interface_t find_interface;
+    void * find_interface_data;
+
+    /* Expressions are checked bottom up with a walk, calls and operator
+     * chains nest as deep as they are long. */
+    joint_node_walker_t * walker;
+    int values_length;
+    int values_capacity;
+    joint_semantic_value_t * values;
+
+    FILE * stream;
+    int diagnostics;
+} joint_semantic_t;
+
+static const char * joint_type_names[] = {
+    [ERROR_TYPE] = "<error>",
+    [ANY_TYPE] = "Any",
+    [NULL_TYPE] = "Null",
+    [NUMBER_TYPE] = "Number",
+    [BOOLEAN_TYPE] = "Boolean",
+    [CHARACTER_TYPE] = "Character",
+    [STRING_TYPE] = "String",
+    [FUNCTION_TYPE] = "Function"
+};
+
+static const char * joint_optional_type_names[] = {
+    [ERROR_TYPE] = "<error>",
+    [ANY_TYPE] = "Any",
+    [NULL_TYPE] = "Null",
+    [NUMBER_TYPE] = "Number?",
+    [BOOLEAN_TYPE] = "Boolean?",
+    [CHARACTER_TYPE] = "Character?",
+    [STRING_TYPE] = "String?",
+    [FUNCTION_TYPE] = "Function?"
+};
+
+const char * joint_type_name(joint_type_t type) {
+    joint_type_t base = type & ~JOINT_TYPE_OPTIONAL;
+
+    if (base > FUNCTION_TYPE) {
+        return NULL;
+    }
+
+    return (type & JOINT_TYPE_OPTIONAL) != 0 ? joint_optional_type_names[base] : joint_type_names[base];
+}
+
+joint_type_t joint_type_from_name(const char * name) {
+    for (joint_type_t i = NUMBER_TYPE; i <= STRING_TYPE; i++) {
+        if (strcmp(joint_type_names[i], name) == 0) {
+            return i;
+        }
+    }
+
+    return ERROR_TYPE;
+}
+
+static void joint_semantic_error(joint_semantic_t * semantic, const joint_node_t * node, const char * format, ...) {
+    va_list arguments;
+
+    fprintf(semantic->stream, "%s:%zu:%zu: ", node->start_position->path, node->start_position->line + 1, node->start_position->code_point_column + 1);
+    va_start(arguments, format);
+    vfprintf(semantic->stream, format, arguments);
+    va_end(arguments);
+    fputc('\n', semantic->stream);
+
+    semantic->diagnostics++;
+}
+
+static const joint_node_children_t * joint_semantic_children(const joint_node_t * node, const char * name) {
+    for (int i = 0; i < node->childrens_length; i++) {
+        if (strcmp(node->childrens[i]->name, name) == 0) {
+            return node->childrens[i];
+        }
+    }
+
+    return NULL;
+}
+
+static const joint_intern_string_t * joint_semantic_identifier(const joint_node_t * identifier) {
+    return joint_intern_cstring(identifier->childrens[0]->string);
+}
+
+static void joint_semantic_declare(joint_semantic_t * semantic, const joint_node_t * identifier, joint_type_t type, const joint_builtin_t * builtin) {
+    if (semantic->symbols_length == semantic->symbols_capacity) {
+        semantic->symbols_capacity *= 2;
+        semantic->symbols = realloc(semantic->symbols, sizeof(joint_semantic_symbol_t) * semantic->symbols_capacity);
+        assert(semantic->symbols);
+    }
+
+    semantic->symbols[semantic->symbols_length].type = type;
+    semantic->symbols[semantic->symbols_length].builtin = builtin;
+
+    if (joint_symbol_table_declare(semantic->table, joint_semantic_identifier(identifier), semantic->symbols_length) >= 0) {
+        joint_semantic_error(semantic, identifier, "Identifier \"%s\" is already declared", identifier->childrens[0]->string);
+    }
+
+    semantic->symbols_length++;
+}
+
+static const joint_semantic_symbol_t * joint_semantic_lookup(joint_semantic_t * semantic, const joint_node_t * identifier) {
+    int symbol = joint_symbol_table_lookup(semantic->table, joint_semantic_identifier(identifier));
+
+    if (symbol < 0) {
+        joint_semantic_error(semantic, identifier, "Undefined identifier \"%s\"", identifier->childrens[0]->string);
+        return NULL;
+    }
+
+    return &semantic->symbols[symbol];
+}
+
+static bool joint_semantic_assignable(joint_type_t target, joint_type_t source) {
+    if (target == ERROR_TYPE || source == ERROR_TYPE || target == ANY_TYPE || source == ANY_TYPE) {
+        return true;
+    }
+
+    if (source == NULL_TYPE) {
+        return (target & JOINT_TYPE_OPTIONAL) != 0;
+    }
+
+    return (source | JOINT_TYPE_OPTIONAL) == (target | JOINT_TYPE_OPTIONAL) && ((source & JOINT_TYPE_OPTIONAL) == 0 || (target & JOINT_TYPE_OPTIONAL) != 0);
+}
+
+static joint_type_t joint_semantic_check_literal(const joint_node_t * literal) {
+    switch (literal->childrens[0]->type) {
+        case NUMBER_CHILDREN:
+            return NUMBER_TYPE;
+
+        case BOOLEAN_CHILDREN:
+            return BOOLEAN_TYPE;
+
+        case CHARACTER_CHILDREN:
+            return CHARACTER_TYPE;
+
+        case STRING_CHILDREN:
+            return STRING_TYPE;
+
+        default:
+            return NULL_TYPE;
+    }
+}
+
+/* The callee and the arguments of a call are on top of the values. */
+static joint_type_t joint_semantic_check_call(joint_semantic_t * semantic, const joint_node_t * call) {
+    int arguments_length = 0;
+
+    for (int i = 0; i < call->childrens_length; i++) {
+        if (strcmp(call->childrens[i]->name, "argument") == 0) {
+            arguments_length++;
+        }
+    }
+
+    semantic->values_length -= arguments_length + 1;
+    const joint_semantic_value_t * callee = &semantic->values[semantic->values_length];
+
+    if (callee->type == ERROR_TYPE || callee->type == ANY_TYPE) {
+        return callee->type;
+    } else if (callee->type != FUNCTION_TYPE) {
+        joint_semantic_error(semantic, call, "Value of type %s is not callable", joint_type_name(callee->type));
+        return ERROR_TYPE;
+    } else if (callee->builtin != NULL && callee->builtin->arguments_length != arguments_length) {
+        joint_semantic_error(semantic, call, "%s expects %d arguments, %d given", callee->builtin->name, callee->builtin->arguments_length, arguments_length);
+        return ERROR_TYPE;
+    }
+
+    /* Builtins take arguments of any type and return null. */
+    return callee->builtin != NULL ? NULL_TYPE : ANY_TYPE;
+}
+
+/* Arithmetic, bitwise and shift operators take numbers and give a number,
+ * comparisons give a boolean. */
+static joint_type_t joint_semantic_check_operator(joint_semantic_t * semantic, const joint_node_t * expression, const joint_semantic_value_t * operands, int operands_length) {
+    const char * operator = joint_semantic_children(expression, "operator")->string;
+    joint_type_t operand_type = NUMBER_TYPE;
+    joint_type_t type = NUMBER_TYPE;
+
+    if (strcmp(operator, "==") == 0 || strcmp(operator, "!=") == 0) {
+        return BOOLEAN_TYPE;
+    } else if (strcmp(operator, "&&") == 0 || strcmp(operator, "||") == 0 || strcmp(operator, "!") == 0) {
+        operand_type = BOOLEAN_TYPE;
+        type = BOOLEAN_TYPE;
+    } else if (strcmp(operator, "<") == 0 || strcmp(operator, ">") == 0) {
+        type = BOOLEAN_TYPE;
+    }
+
+    for (int i = 0; i < operands_length; i++) {
+        if (!joint_semantic_assignable(operand_type, operands[i].type)) {
+            joint_semantic_error(semantic, expression, "Operator \"%s\" expects %s operands, got %s", operator, joint_type_name(operand_type), joint_type_name(operands[i].type));
+            return ERROR_TYPE;
+        }
+    }
+
+    return type;
+}
+
+static joint_node_walk_action_t joint_semantic_expression_enter(joint_node_t * node, const joint_node_children_t * relation, int depth, void * data) {
+    switch (node->type) {
+        case CALL_EXPRESSION_NODE:
+        case BINARY_EXPRESSION_NODE:
+        case UNARY_EXPRESSION_NODE:
+            return JOINT_NODE_WALK_CONTINUE;
+
+        default:
+            return JOINT_NODE_WALK_SKIP;
+    }
+}
+
+static joint_node_walk_action_t joint_semantic_expression_leave(joint_node_t * node, const joint_node_children_t * relation, int depth, void * data) {
+    joint_semantic_t * semantic = data;
+    joint_semantic_value_t value = {.type = ERROR_TYPE, .builtin = NULL};
+    const joint_semantic_symbol_t * symbol;
+
+    switch (node->type) {
+        case LITERAL_NODE:
+            value.type = joint_semantic_check_literal(node);
+            break;
+
+        case IDENTIFIER_NODE:
+            symbol = joint_semantic_lookup(semantic, node);
+
+            if (symbol != NULL) {
+                value.type = symbol->type;
+                value.builtin = symbol->builtin;
+            }
+            break;
+
+        case CALL_EXPRESSION_NODE:
+            value.type = joint_semantic_check_call(semantic, node);
+            break;
+
+        case BINARY_EXPRESSION_NODE:
+            semantic->values_length -= 2;
+            value.type = joint_semantic_check_operator(semantic, node, &semantic->values[semantic->values_length], 2);
+            break;
+
+        case UNARY_EXPRESSION_NODE:
+            semantic->values_length -= 1;
+            value.type = joint_semantic_check_operator(semantic, node, &semantic->values[semantic->values_length], 1);
+            break;
+
+        default:
+            joint_semantic_error(semantic, node, "Unsupported expression %s", joint_node_type_name(node->type));
+            break;
+    }
+
+    if (semantic->values_length == semantic->values_capacity) {
+        semantic->values_capacity *= 2;
+        semantic->values = realloc(semantic->values, sizeof(joint_semantic_value_t) * semantic->values_capacity);
+        assert(semantic->values);
+    }
+
+    semantic->values[semantic->values_length++] = value;
+
+    return JOINT_NODE_WALK_CONTINUE;
+}
+
+static joint_type_t joint_semantic_check_expression(joint_semantic_t * semantic, const joint_node_t * expression) {
+    joint_node_visitor_t visitor = {
+        .enter = joint_semantic_expression_enter,
+        .scalar = NULL,
+        .leave = joint_semantic_expression_leave,
+        .data = semantic
+    };
+
+    semantic->values_length = 0;
+    joint_node_walker_walk(semantic->walker, (joint_node_t *) expression, &visitor);
+    assert(semantic->values_length == 1);
+
+    return semantic->values[0].type;
+}
+
+static void joint_semantic_check_import(joint_semantic_t * semantic, const joint_node_t * import_declaration) {
+    const joint_node_t * source = joint_semantic_children(import_declaration, "source")->node;
+    const char * module = source->childrens[0]->string;
+    bool builtin_module = joint_builtins_has_module(module);
+    const joint_interface_t * interface = NULL;
+    joint_interface_t * loaded = NULL;
+    const char * path = semantic->imports[semantic->next_import++];
+
+    if (!builtin_module) {
+        if (path != NULL && semantic->find_interface != NULL) {
+            interface = semantic->find_interface(path, semantic->find_interface_data);
+        } else if (path != NULL) {
+            joint_source_file_t * source_file = joint_loader_next(semantic->loader);
+
+            if (source_file != NULL) {
+                interface = loaded = joint_interface_load_source(source_file);
+                joint_source_file_free(source_file);
+            }
+        }
+
+        if (interface == NULL) {
+            joint_semantic_error(semantic, source, "Unknown module \"%s\"", module);
+        }
+    }
+
+    for (int i = 0; i < import_declaration->childrens_length; i++) {
+        if (strcmp(import_declaration->childrens[i]->name, "specifier") != 0) {
+            continue;
+        }
+
+        const joint_node_t * specifier = import_declaration->childrens[i]->node;
+        const char * name = specifier->childrens[0]->string;
+        const joint_builtin_t * builtin = NULL;
+        joint_type_t type = ERROR_TYPE;
+
+        if (builtin_module) {
+            builtin = joint_builtins_find(module, name);
+            type = builtin != NULL ? FUNCTION_TYPE : ERROR_TYPE;
+        }
+
+        if ((builtin_module && builtin == NULL) || (interface != NULL && !joint_interface_lookup(interface, name, &type))) {
+            joint_semantic_error(semantic, specifier, "Module \"%s\" has no export \"%s\"", module, name);
+        }
+
+        joint_semantic_declare(semantic, specifier, type, builtin);
+    }
+
+    if (loaded != NULL) {
+        joint_interface_free(loaded);
+    }
+}
+
+static void joint_semantic_load_imports(joint_semantic_t * semantic, const joint_node_t * program) {
+    for (int i = 0; i < program->childrens_length; i++) {
+        const joint_node_t * element = program->childrens[i]->node;
+
+        if (element->type != IMPORT_DECLARATION_NODE) {
+            continue;
+        }
+
+        const joint_node_t * source = joint_semantic_children(element, "source")->node;
+        const char * module = source->childrens[0]->string;
+        char * path = NULL;
+
+        if (!joint_builtins_has_module(module)) {
+            path = joint_module_resolve_import(source->start_position->path, module);
+        }
+
+        if (path != NULL && semantic->find_interface == NULL) {
+            if (semantic->loader == NULL) {
+                semantic->loader = joint_loader_alloc(joint_allocator_system(), JOINT_LOADER_DEPTH);
+            }
+
+            joint_loader_submit(semantic->loader, path);
+        }
+
+        semantic->imports = realloc(semantic->imports, sizeof(char *) * (semantic->imports_length + 1));
+        assert(semantic->imports);
+        semantic->imports[semantic->imports_length++] = path;
+    }
+}
+
+static void joint_semantic_check_variable_declaration(joint_semantic_t * semantic, const joint_node_t * variable_declaration) {
+    const joint_node_t * id = joint_semantic_children(variable_declaration, "id")->node;
+    const joint_node_t * annotation = joint_semantic_children(variable_declaration, "type")->node;
+    const joint_node_children_t * optional = joint_semantic_children(variable_declaration, "optional");
+    const joint_node_t * init = joint_semantic_children(variable_declaration, "init")->node;
+
+    const joint_intern_string_t * annotation_name = joint_semantic_identifier(annotation);
+    joint_type_t type = ERROR_TYPE;
+
+    for (joint_type_t i = NUMBER_TYPE; i <= STRING_TYPE; i++) {
+        if (semantic->type_names[i] == annotation_name) {
+            type = i;
+            break;
+        }
+    }
+
+    if (type == ERROR_TYPE) {
+        joint_semantic_error(semantic, annotation, "Unknown type \"%s\"", annotation_name->characters);
+    } else if (optional != NULL && optional->boolean) {
+        type |= JOINT_TYPE_OPTIONAL;
+    }
+
+    /* The initializer still sees the previous binding of the name. */
+    joint_type_t init_type = joint_semantic_check_expression(semantic, init);
+
+    if (!joint_semantic_assignable(type, init_type)) {
+        if (init_type == NULL_TYPE) {
+            joint_semantic_error(semantic, init, "Cannot initialize \"%s\" of type %s with null, declare it as %s?", id->childrens[0]->string, joint_type_name(type), joint_type_name(type));
+        } else {
+            joint_semantic_error(semantic, init, "Cannot initialize \"%s\" of type %s with a value of type %s", id->childrens[0]->string, joint_type_name(type), joint_type_name(init_type));
+        }
+    }
+
+    joint_semantic_declare(semantic, id, type, NULL);
+}
+
+bool joint_semantic_check(const joint_node_t * program, FILE * stream, joint_semantic_result_t * result) {
+    return joint_semantic_check_interfaces(program, stream, result, NULL, NULL);
+}
+
+bool joint_semantic_check_interfaces(const joint_node_t * program, FILE * stream, joint_semantic_result_t * result, joint_semantic_find_interface_t find_interface, void * data) {
+    joint_semantic_t semantic = {
+        .table = joint_symbol_table_alloc(),
+        .symbols_length = 0,
+        .symbols_capacity = 256,
+        .symbols = malloc(sizeof(joint_semantic_symbol_t) * 256),
+        .imports_length = 0,
+        .next_import = 0,
+        .imports = NULL,
+        .loader = NULL,
+        .find_interface = find_interface,
+        .find_interface_data = data,
+        .walker = joint_node_walker_alloc(),
+        .values_length = 0,
+        .values_capacity = 16,
+        .values = malloc(sizeof(joint_semantic_value_t) * 16),
+        .stream = stream,
+        .diagnostics = 0
+    };
+    assert(semantic.symbols);
+    assert(semantic.values);
+
+    joint_semantic_load_imports(&semantic, program);
+
+    for (joint_type_t i = NUMBER_TYPE; i <= STRING_TYPE; i++) {
+        semantic.type_names[i] = joint_intern_cstring(joint_type_names[i]);
+    }
+
+    int watermark = joint_symbol_table_push_scope(semantic.table);
+
+    for (int i = 0; i < program->childrens_length; i++) {
+        const joint_node_t * element = program->childrens[i]->node;
+
+        switch (element->type) {
+            case COMMENT_NODE:
+                break;
+
+            case IMPORT_DECLARATION_NODE:
+                joint_semantic_check_import(&semantic, element);
+                break;
+
+            case VARIABLE_DECLARATION_NODE:
+                joint_semantic_check_variable_declaration(&semantic, element);
+                break;
+
+            default:
+                joint_semantic_check_expression(&semantic, element);
+                break;
+        }
+    }
+
+    joint_symbol_table_pop_scope(semantic.table, watermark);
+
+    if (result != NULL) {
+        result->diagnostics = semantic.diagnostics;
+        result->symbols = semantic.symbols_length;
+        result->imports = semantic.loader != NULL ? semantic.loader->stats : (joint_loader_stats_t) {0};
+    }
+
+    if (semantic.loader != NULL) {
+        joint_loader_free(semantic.loader);
+    }
+
+    for (int i = 0; i < semantic.imports_length; i++) {
+        free(semantic.imports[i]);
+    }
+
+    free(semantic.imports);
+
+    joint_node_walker_free(semantic.walker);
+    free(semantic.values);
+    joint_symbol_table_free(semantic.table);
+    free(semantic.symbols);
+
+    return semantic.diagnostics == 0;
+}
@@ -0,0 +1,72 @@
+/* Copyright (c) 2014 Vyacheslav Slinko
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef joint_semantic_h
+#define joint_semantic_h
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "loader.h"
+#include "node.h"
+
+enum joint_type {
+    ERROR_TYPE,
+    ANY_TYPE,
+    NULL_TYPE,
+    NUMBER_TYPE,
+    BOOLEAN_TYPE,
+    CHARACTER_TYPE,
+    STRING_TYPE,
+    FUNCTION_TYPE
+};
+
+/* A type id is a joint_type, optionally or'ed with JOINT_TYPE_OPTIONAL. */
+typedef uint8_t joint_type_t;
+
+#define JOINT_TYPE_OPTIONAL 0x80
+
+typedef struct joint_semantic_result {
+    int diagnostics;
+    int symbols;
+    joint_loader_stats_t imports;
+} joint_semantic_result_t;
+
+struct joint_interface;
+
+/* Returns the interface of the module at path, which stays owned by the
+ * caller, or NULL when the module is unknown. */
+typedef const struct joint_interface * (* joint_semantic_find_interface_t)(const char * path, void * data);
+
+/* Resolves names and checks types of the whole program, every problem is
+ * reported to stream. Returns true when there were none. */
+bool joint_semantic_check(const joint_node_t * program, FILE * stream, joint_semantic_result_t * result);
+
+/* Same as joint_semantic_check, but the interfaces of the imported modules
+ * come from find_interface instead of their files. */
+bool joint_semantic_check_interfaces(const joint_node_t * program, FILE * stream, joint_semantic_result_t * result, joint_semantic_find_interface_t find_interface, void * data);
+
+const char * joint_type_name(joint_type_t type);
+
+/* Returns the type annotated as name or ERROR_TYPE. */
+joint_type_t joint_type_from_name(const char * name);
+
+#endif
@@ -0,0 +1,466 @@
+/* Copyright (c) 2014 Vyacheslav Slinko
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <assert.h>
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "hash.h"
+#include "parser.h"
+#include "semantic.h"
+#include "server.h"
+#include "source_file.h"
+#include "tokenizer.h"
+#include "writer.h"
+
+#define JOINT_SERVER_BUCKETS_LENGTH 1024
+
+typedef struct joint_server_module {
+    char * path;
+    struct timespec modified;
+    off_t size;
+    uint64_t hash;
+    int references;
+    bool building;
+
+    joint_source_file_t * source_file;
+    joint_tokenizer_t * tokenizer;
+    joint_parser_t * parser;
+
+    /* The syntax error of the file, its program is NULL then. */
+    char * error;
+
+    struct joint_server_module * next;
+} joint_server_module_t;
+
+static pthread_mutex_t joint_server_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t joint_server_built = PTHREAD_COND_INITIALIZER;
+static joint_server_module_t * joint_server_buckets[JOINT_SERVER_BUCKETS_LENGTH];
+static joint_allocator_t * joint_server_allocator = NULL;
+
+static bool joint_server_read_exact(int fd, void * data, size_t length) {
+    while (length > 0) {
+        ssize_t received = read(fd, data, length);
+
+        if (received < 0 && errno == EINTR) {
+            continue;
+        }
+
+        if (received <= 0) {
+            return false;
+        }
+
+        data = (char *) data + received;
+        length -= (size_t) received;
+    }
+
+    return true;
+}
+
+static bool joint_server_write_exact(int fd, const void * data, size_t length) {
+    while (length > 0) {
+        ssize_t sent = write(fd, data, length);
+
+        if (sent < 0 && errno == EINTR) {
+            continue;
+        }
+
+        if (sent <= 0) {
+            return false;
+        }
+
+        data = (const char *) data + sent;
+        length -= (size_t) sent;
+    }
+
+    return true;
+}
+
+static void joint_server_module_free(joint_server_module_t * module) {
+    joint_parser_free(module->parser);
+    joint_tokenizer_free(module->tokenizer);
+    joint_source_file_free(module->source_file);
+    free(module->error);
+    free(module->path);
+    free(module);
+}
+
+static void joint_server_module_release(joint_server_module_t * module) {
+    pthread_mutex_lock(&joint_server_mutex);
+    bool unused = --module->references == 0;
+    pthread_mutex_unlock(&joint_server_mutex);
+
+    if (unused) {
+        joint_server_module_free(module);
+    }
+}
+
+static joint_server_module_t ** joint_server_module_find(const char * path) {
+    joint_server_module_t ** module = &joint_server_buckets[joint_hash_string(path, 0) % JOINT_SERVER_BUCKETS_LENGTH];
+
+    while (*module != NULL && strcmp((*module)->path, path) != 0) {
+        module = &(*module)->next;
+    }
+
+    return module;
+}
+
+static bool joint_server_module_is_fresh(const joint_server_module_t * module, const struct stat * status) {
+    return module->size == status->st_size && module->modified.tv_sec == status->st_mtim.tv_sec && module->modified.tv_nsec == status->st_mtim.tv_nsec;
+}
+
+/* Puts module in the place of the module of path, or drops that one for a
+ * NULL module, and returns it. Called with the mutex held. */
+static joint_server_module_t * joint_server_module_swap(const char * path, joint_server_module_t * module) {
+    joint_server_module_t ** slot = joint_server_module_find(path);
+    joint_server_module_t * replaced = *slot;
+    joint_server_module_t * next = replaced != NULL ? replaced->next : NULL;
+
+    if (replaced != NULL) {
+        replaced->next = NULL;
+    }
+
+    if (module != NULL) {
+        module->next = next;
+        *slot = module;
+    } else {
+        *slot = next;
+    }
+
+    return replaced;
+}
+
+/* A module missing or stale in the table is replaced by an entry that is
+ * still building, so concurrent requests for it wait for one parse
+ * instead of starting their own. */
+static joint_server_module_t * joint_server_module_acquire(const char * path) {
+    struct stat status;
+
+    if (stat(path, &status) != 0) {
+        return NULL;
+    }
+
+    pthread_mutex_lock(&joint_server_mutex);
+    joint_server_module_t * module = *joint_server_module_find(path);
+
+    while (module != NULL && module->building) {
+        pthread_cond_wait(&joint_server_built, &joint_server_mutex);
+        module = *joint_server_module_find(path);
+    }
+
+    if (module != NULL && joint_server_module_is_fresh(module, &status)) {
+        module->references++;
+        pthread_mutex_unlock(&joint_server_mutex);
+        return module;
+    }
+
+    module = malloc(sizeof(joint_server_module_t));
+    assert(module);
+
+    module->path = malloc(sizeof(char) * (strlen(path) + 1));
+    assert(module->path);
+    strcpy(module->path, path);
+
+    module->modified = status.st_mtim;
+    module->size = status.st_size;
+    module->references = 2;
+    module->building = true;
+    module->source_file = NULL;
+    module->tokenizer = NULL;
+    module->parser = NULL;
+    module->error = NULL;
+
+    joint_server_module_t * replaced = joint_server_module_swap(path, module);
+    pthread_mutex_unlock(&joint_server_mutex);
+
+    joint_source_file_t * source_file = joint_source_file_alloc(joint_server_allocator, path);
+    bool read = joint_source_file_read(source_file);
+    uint64_t hash = read ? joint_hash_bytes(source_file->content->data, (size_t) source_file->content->length, 0) : 0;
+
+    if (!read || (replaced != NULL && replaced->hash == hash)) {
+        pthread_mutex_lock(&joint_server_mutex);
+        joint_server_module_swap(path, replaced);
+
+        if (read) {
+            replaced->modified = status.st_mtim;
+            replaced->size = status.st_size;
+            replaced->references++;
+        }
+
+        pthread_cond_broadcast(&joint_server_built);
+        pthread_mutex_unlock(&joint_server_mutex);
+
+        joint_source_file_free(source_file);
+        free(module->path);
+        free(module);
+
+        return read ? replaced : NULL;
+    }
+
+    module->hash = hash;
+    module->source_file = source_file;
+    module->tokenizer = joint_tokenizer_alloc(joint_server_allocator, source_file);
+    joint_tokenizer_tokenize(module->tokenizer);
+    module->parser = joint_parser_alloc(joint_server_allocator, module->tokenizer);
+
+    if (!joint_parser_parse(module->parser)) {
+        int length = joint_parser_format_error(module->parser, NULL, 0);
+        module->error = malloc(length + 1);
+        assert(module->error);
+        joint_parser_format_error(module->parser, module->error, length + 1);
+    }
+
+    pthread_mutex_lock(&joint_server_mutex);
+    module->building = false;
+    pthread_cond_broadcast(&joint_server_built);
+    pthread_mutex_unlock(&joint_server_mutex);
+
+    if (replaced != NULL) {
+        joint_server_module_release(replaced);
+    }
+
+    return module;
+}
+
+static void joint_server_reply_error(int fd, const char * message, const char * path) {
+    uint32_t status = 1;
+    joint_server_write_exact(fd, &status, sizeof(status));
+
+    joint_writer_t * writer = joint_writer_alloc(fd, 4096);
+    joint_writer_write_string(writer, message);
+    joint_writer_write_string(writer, " \"");
+    joint_writer_write_string(writer, path);
+    joint_writer_write_string(writer, "\"\n");
+    joint_writer_free(writer);
+}
+
+static void * joint_server_handle(void * argument) {
+    int fd = (int) (intptr_t) argument;
+    uint32_t header[3];
+
+    if (!joint_server_read_exact(fd, header, sizeof(header)) || header[2] == 0 || header[2] > 4096) {
+        close(fd);
+        return NULL;
+    }
+
+    char * path = malloc(sizeof(char) * (header[2] + 1));
+    assert(path);
+
+    if (!joint_server_read_exact(fd, path, header[2])) {
+        free(path);
+        close(fd);
+        return NULL;
+    }
+
+    path[header[2]] = '\0';
+
+    enum joint_server_command command = header[0];
+    enum joint_dump_format format = header[1];
+
+    if (command > AST_SERVER_COMMAND || format > BINARY_DUMP_FORMAT) {
+        joint_server_reply_error(fd, "Unknown request for file", path);
+        free(path);
+        close(fd);
+        return NULL;
+    }
+
+    joint_server_module_t * module = joint_server_module_acquire(path);
+
+    if (module == NULL) {
+        joint_server_reply_error(fd, "Unable to read file", path);
+        free(path);
+        close(fd);
+        return NULL;
+    }
+
+    /* Tokens are still dumped for a file with a syntax error. */
+    uint32_t status = module->error != NULL && command != TOKENS_SERVER_COMMAND ? 1 : 0;
+    char * diagnostics = NULL;
+    size_t diagnostics_length = 0;
+
+    /* Imports may have changed since the module was parsed, so the check
+     * is not cached. */
+    if (status == 0 && command == COMPILE_SERVER_COMMAND) {
+        FILE * stream = open_memstream(&diagnostics, &diagnostics_length);
+        assert(stream);
+        status = joint_semantic_check(module->parser->program, stream, NULL) ? 0 : 1;
+        fclose(stream);
+    }
+
+    joint_server_write_exact(fd, &status, sizeof(status));
+
+    joint_writer_t * writer = joint_writer_alloc(fd, 1 << 20);
+
+    if (module->error != NULL && command != TOKENS_SERVER_COMMAND) {
+        joint_writer_write_string(writer, module->error);
+        joint_writer_write_character(writer, '\n');
+    } else if (command == COMPILE_SERVER_COMMAND) {
+        joint_writer_write(writer, diagnostics, diagnostics_length);
+    } else if (command == TOKENS_SERVER_COMMAND) {
+        joint_dump_tokens(writer, module->tokenizer, format);
+    } else if (command == AST_SERVER_COMMAND) {
+        joint_dump_node(writer, module->parser->program, format);
+    }
+
+    free(diagnostics);
+
+    joint_writer_free(writer);
+    joint_server_module_release(module);
+
+    free(path);
+    close(fd);
+
+    return NULL;
+}
+
+static int joint_server_connect(const char * socket_path, bool listening) {
+    struct sockaddr_un address;
+
+    if (strlen(socket_path) >= sizeof(address.sun_path)) {
+        fprintf(stderr, "Socket path \"%s\" is too long\n", socket_path);
+        return -1;
+    }
+
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, socket_path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+
+    if (fd < 0) {
+        perror("socket");
+        return -1;
+    }
+
+    if (listening) {
+        unlink(socket_path);
+
+        if (bind(fd, (struct sockaddr *) &address, sizeof(address)) != 0 || listen(fd, 128) != 0) {
+            perror(socket_path);
+            close(fd);
+            return -1;
+        }
+    } else if (connect(fd, (struct sockaddr *) &address, sizeof(address)) != 0) {
+        perror(socket_path);
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+int joint_server_serve(const char * socket_path) {
+    int fd = joint_server_connect(socket_path, true);
+
+    if (fd < 0) {
+        return 1;
+    }
+
+    signal(SIGPIPE, SIG_IGN);
+
+    /* Modules are rebuilt whenever their files change, the pool hands the
+     * memory of the replaced ones to the next builds. */
+    joint_server_allocator = joint_allocator_pool_alloc();
+
+    pthread_attr_t attributes;
+    pthread_attr_init(&attributes);
+    pthread_attr_setdetachstate(&attributes, PTHREAD_CREATE_DETACHED);
+
+    while (true) {
+        int client = accept(fd, NULL, NULL);
+
+        if (client < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+
+            perror("accept");
+            break;
+        }
+
+        pthread_t thread;
+
+        if (pthread_create(&thread, &attributes, joint_server_handle, (void *) (intptr_t) client) != 0) {
+            close(client);
+        }
+    }
+
+    pthread_attr_destroy(&attributes);
+    close(fd);
+    unlink(socket_path);
+
+    return 1;
+}
+
+int joint_server_request(const char * socket_path, enum joint_server_command command, enum joint_dump_format format, const char * source_file_path) {
+    char * path = realpath(source_file_path, NULL);
+
+    if (path == NULL) {
+        fprintf(stderr, "Unable to read file \"%s\"\n", source_file_path);
+        return 1;
+    }
+
+    int fd = joint_server_connect(socket_path, false);
+
+    if (fd < 0) {
+        free(path);
+        return 1;
+    }
+
+    uint32_t header[3] = {command, format, (uint32_t) strlen(path)};
+    uint32_t status = 1;
+
+    if (!joint_server_write_exact(fd, header, sizeof(header)) || !joint_server_write_exact(fd, path, header[2]) || !joint_server_read_exact(fd, &status, sizeof(status))) {
+        fprintf(stderr, "Connection to \"%s\" failed\n", socket_path);
+        free(path);
+        close(fd);
+        return 1;
+    }
+
+    int output = status == 0 ? 1 : 2;
+    char buffer[65536];
+    ssize_t received;
+
+    while ((received = read(fd, buffer, sizeof(buffer))) != 0) {
+        if (received < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+
+            break;
+        }
+
+        joint_server_write_exact(output, buffer, (size_t) received);
+    }
+
+    free(path);
+    close(fd);
+
+    return (int) status;
+}
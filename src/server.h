@@ -0,0 +1,43 @@
+/* Copyright (c) 2014 Vyacheslav Slinko
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef joint_server_h
+#define joint_server_h
+
+#include <stdbool.h>
+#include "dump.h"
+
+/* A request is a u32 command, a u32 dump format, a u32 path length and the
+ * absolute source path. The reply is a u32 exit status followed by the
+ * output, which runs until the server closes the connection and goes to
+ * stdout on success and to stderr otherwise. Compiling runs the semantic
+ * checks and replies with their diagnostics. */
+enum joint_server_command {
+    COMPILE_SERVER_COMMAND,
+    TOKENS_SERVER_COMMAND,
+    AST_SERVER_COMMAND
+};
+
+int joint_server_serve(const char * socket_path);
+
+int joint_server_request(const char * socket_path, enum joint_server_command command, enum joint_dump_format format, const char * source_file_path);
+
+#endif
@@ -20,46 +20,130 @@
  */
 
 #include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #include "source_file.h"
-#include "string.h"
+#include "joint_string.h"
+#include "utf8.h"
 
-joint_source_file_t * joint_source_file_alloc(const char * path) {
-    joint_source_file_t * source_file = malloc(sizeof(joint_source_file_t));
+joint_source_file_t * joint_source_file_alloc(joint_allocator_t * allocator, const char * path) {
+    joint_source_file_t * source_file = JOINT_ALLOCATE(allocator, sizeof(joint_source_file_t));
     assert(source_file);
 
-    source_file->path = malloc(sizeof(char) * strlen(path));
+    source_file->allocator = allocator;
+
+    source_file->path = JOINT_ALLOCATE(allocator, sizeof(char) * (strlen(path) + 1));
     assert(source_file->path);
     strcpy(source_file->path, path);
 
-    source_file->content = joint_string_alloc(512);
+    source_file->content = joint_string_alloc(allocator, 512);
+    source_file->ascii = true;
 
     return source_file;
 }
 
-bool joint_source_file_read(joint_source_file_t * source_file) {
-    FILE * handle = fopen(source_file->path, "r");
+joint_source_file_t * joint_source_file_alloc_borrowed(joint_allocator_t * allocator, const char * path, const char * data, size_t length) {
+    joint_source_file_t * source_file = JOINT_ALLOCATE(allocator, sizeof(joint_source_file_t));
+    assert(source_file);
+
+    source_file->allocator = allocator;
+
+    source_file->path = JOINT_ALLOCATE(allocator, sizeof(char) * (strlen(path) + 1));
+    assert(source_file->path);
+    strcpy(source_file->path, path);
+
+    source_file->content = joint_string_borrow(allocator, data, length);
+    source_file->ascii = true;
+
+    return source_file;
+}
+
+bool joint_source_file_load(joint_allocator_t * allocator, const char * path, char ** data, size_t * length) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
 
-    if (handle == NULL) {
+    if (fd < 0) {
         return false;
     }
 
-    char character;
+    /* Files without a size, like pipes, are read until their end. */
+    struct stat status;
+    bool sized = fstat(fd, &status) == 0 && S_ISREG(status.st_mode) && status.st_size > 0;
+    size_t capacity = sized ? (size_t) status.st_size : 4096;
+
+    *data = JOINT_ALLOCATE(allocator, sizeof(char) * (capacity + 1));
+    assert(*data);
+    *length = 0;
+
+    while (!sized || *length < capacity) {
+        ssize_t received = read(fd, *data + *length, capacity - *length);
+
+        if (received < 0 && errno == EINTR) {
+            continue;
+        }
 
-    while (true) {
-        character = fgetc(handle);
+        if (received < 0) {
+            JOINT_DEALLOCATE(allocator, *data);
+            close(fd);
+            return false;
+        }
 
-        if (character == EOF) {
+        if (received == 0) {
             break;
         }
 
-        joint_string_append_character(source_file->content, character);
+        *length += (size_t) received;
+
+        if (!sized && *length == capacity) {
+            capacity *= 2;
+            *data = JOINT_REALLOCATE(allocator, *data, sizeof(char) * (capacity + 1));
+            assert(*data);
+        }
+    }
+
+    close(fd);
+
+    if (*length != capacity) {
+        *data = JOINT_REALLOCATE(allocator, *data, sizeof(char) * (*length + 1));
+        assert(*data);
+    }
+
+    (*data)[*length] = '\0';
+
+    return true;
+}
+
+void joint_source_file_adopt(joint_source_file_t * source_file, char * data, size_t length) {
+    joint_string_free(source_file->content);
+    source_file->content = joint_string_adopt(source_file->allocator, data, length);
+}
+
+bool joint_source_file_read(joint_source_file_t * source_file) {
+    char * data;
+    size_t length;
+
+    if (!joint_source_file_load(source_file->allocator, source_file->path, &data, &length)) {
+        return false;
     }
 
-    fclose(handle);
+    joint_source_file_adopt(source_file, data, length);
+
+    return joint_source_file_validate(source_file);
+}
+
+bool joint_source_file_validate(joint_source_file_t * source_file) {
+    const joint_string_t * content = source_file->content;
+    size_t valid_length = joint_utf8_validate(content->data, content->length, &source_file->ascii);
+
+    if (valid_length != content->length) {
+        fprintf(stderr, "%s: invalid UTF-8 at byte %zu\n", source_file->path, valid_length);
+        return false;
+    }
 
     return true;
 }
@@ -72,6 +156,6 @@ void joint_source_file_print(const joint_source_file_t * source_file) {
 
 void joint_source_file_free(joint_source_file_t * source_file) {
     joint_string_free(source_file->content);
-    free(source_file->path);
-    free(source_file);
+    JOINT_DEALLOCATE(source_file->allocator, source_file->path);
+    JOINT_DEALLOCATE(source_file->allocator, source_file);
 }
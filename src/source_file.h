@@ -23,17 +23,33 @@
 #define joint_source_file_h
 
 #include <stdbool.h>
-#include "string.h"
+#include "allocator.h"
+#include "joint_string.h"
 
 typedef struct joint_source_file {
+    joint_allocator_t * allocator;
     char * path;
     joint_string_t * content;
+    bool ascii;
 } joint_source_file_t;
 
-joint_source_file_t * joint_source_file_alloc(const char * path);
+joint_source_file_t * joint_source_file_alloc(joint_allocator_t * allocator, const char * path);
 
+/* The content is the caller's data, which must outlive the source file. */
+joint_source_file_t * joint_source_file_alloc_borrowed(joint_allocator_t * allocator, const char * path, const char * data, size_t length);
+
+/* Reads the whole file at path into data allocated from allocator, which
+ * holds exactly its length bytes followed by a NUL. */
+bool joint_source_file_load(joint_allocator_t * allocator, const char * path, char ** data, size_t * length);
+
+/* Replaces the content with data as left by joint_source_file_load. */
+void joint_source_file_adopt(joint_source_file_t * source_file, char * data, size_t length);
+
+/* Fails for unreadable files and content that is not UTF-8. */
 bool joint_source_file_read(joint_source_file_t * source_file);
 
+bool joint_source_file_validate(joint_source_file_t * source_file);
+
 void joint_source_file_print(const joint_source_file_t * source_file);
 
 void joint_source_file_free(joint_source_file_t * source_file);
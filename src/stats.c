@@ -0,0 +1,97 @@
+/* Copyright (c) 2014 Vyacheslav Slinko
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "stats.h"
+
+uint64_t joint_stats_now(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t) now.tv_sec * 1000000000 + (uint64_t) now.tv_nsec;
+}
+
+uint64_t joint_stats_cpu_now(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+    return (uint64_t) now.tv_sec * 1000000000 + (uint64_t) now.tv_nsec;
+}
+
+joint_stats_t * joint_stats_alloc(void) {
+    joint_stats_t * stats = malloc(sizeof(joint_stats_t));
+    assert(stats);
+
+    stats->entries_length = 0;
+    stats->entries = NULL;
+
+    return stats;
+}
+
+static void joint_stats_accumulate(joint_stats_t * stats, const char * name, bool is_time, uint64_t value) {
+    for (int i = 0; i < stats->entries_length; i++) {
+        if (strcmp(stats->entries[i].name, name) == 0) {
+            stats->entries[i].value += value;
+            return;
+        }
+    }
+
+    stats->entries = realloc(stats->entries, sizeof(joint_stats_entry_t) * (stats->entries_length + 1));
+    assert(stats->entries);
+
+    joint_stats_entry_t * entry = &stats->entries[stats->entries_length++];
+    entry->name = name;
+    entry->is_time = is_time;
+    entry->value = value;
+}
+
+void joint_stats_add(joint_stats_t * stats, const char * name, uint64_t value) {
+    joint_stats_accumulate(stats, name, false, value);
+}
+
+void joint_stats_add_time(joint_stats_t * stats, const char * name, uint64_t nanoseconds) {
+    joint_stats_accumulate(stats, name, true, nanoseconds);
+}
+
+void joint_stats_print(const joint_stats_t * stats, joint_writer_t * writer) {
+    for (int i = 0; i < stats->entries_length; i++) {
+        joint_writer_write_string(writer, stats->entries[i].name);
+        joint_writer_write_string(writer, ": ");
+
+        if (stats->entries[i].is_time) {
+            joint_writer_write_integer(writer, (int64_t) (stats->entries[i].value / 1000));
+            joint_writer_write_string(writer, " us");
+        } else {
+            joint_writer_write_integer(writer, (int64_t) stats->entries[i].value);
+        }
+
+        joint_writer_write_character(writer, '\n');
+    }
+}
+
+void joint_stats_free(joint_stats_t * stats) {
+    if (stats->entries != NULL) {
+        free(stats->entries);
+    }
+
+    free(stats);
+}
@@ -0,0 +1,55 @@
+/* Copyright (c) 2014 Vyacheslav Slinko
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef joint_stats_h
+#define joint_stats_h
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "writer.h"
+
+typedef struct joint_stats_entry {
+    const char * name;
+    bool is_time;
+    uint64_t value;
+} joint_stats_entry_t;
+
+typedef struct joint_stats {
+    int entries_length;
+    joint_stats_entry_t * entries;
+} joint_stats_t;
+
+uint64_t joint_stats_now(void);
+
+/* CPU time of the calling thread, time spent blocked is not counted. */
+uint64_t joint_stats_cpu_now(void);
+
+joint_stats_t * joint_stats_alloc(void);
+
+void joint_stats_add(joint_stats_t * stats, const char * name, uint64_t value);
+
+void joint_stats_add_time(joint_stats_t * stats, const char * name, uint64_t nanoseconds);
+
+void joint_stats_print(const joint_stats_t * stats, joint_writer_t * writer);
+
+void joint_stats_free(joint_stats_t * stats);
+
+#endif
@@ -0,0 +1,162 @@
+/* Copyright (c) 2014 Vyacheslav Slinko
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <assert.h>
+#include <stdlib.h>
+#include "symbol_table.h"
+
+joint_symbol_table_t * joint_symbol_table_alloc(void) {
+    joint_symbol_table_t * table = malloc(sizeof(joint_symbol_table_t));
+    assert(table);
+
+    table->length = 0;
+    table->capacity = 256;
+    table->entries = calloc(table->capacity, sizeof(joint_symbol_table_entry_t));
+    assert(table->entries);
+
+    table->depth = 0;
+    table->shadows_length = 0;
+    table->shadows_capacity = 256;
+    table->shadows = malloc(sizeof(joint_symbol_table_shadow_t) * table->shadows_capacity);
+    assert(table->shadows);
+
+    return table;
+}
+
+/* Unbound names keep their slot with a -1 value, so lookups never have to
+ * probe past a hole left by a popped scope. */
+static joint_symbol_table_entry_t * joint_symbol_table_slot(joint_symbol_table_entry_t * entries, int capacity, const joint_intern_string_t * name) {
+    int slot = (int) (name->hash & (uint64_t) (capacity - 1));
+
+    while (entries[slot].name != NULL && entries[slot].name != name) {
+        slot = (slot + 1) & (capacity - 1);
+    }
+
+    return &entries[slot];
+}
+
+static void joint_symbol_table_grow(joint_symbol_table_t * table) {
+    int capacity = table->capacity * 2;
+    joint_symbol_table_entry_t * entries = calloc(capacity, sizeof(joint_symbol_table_entry_t));
+    assert(entries);
+
+    table->length = 0;
+
+    for (int i = 0; i < table->capacity; i++) {
+        if (table->entries[i].name != NULL && table->entries[i].value >= 0) {
+            *joint_symbol_table_slot(entries, capacity, table->entries[i].name) = table->entries[i];
+            table->length++;
+        }
+    }
+
+    /* Shadowed names that are unbound right now still need a slot to be
+     * restored into. */
+    for (int i = 0; i < table->shadows_length; i++) {
+        joint_symbol_table_entry_t * entry = joint_symbol_table_slot(entries, capacity, table->shadows[i].name);
+
+        if (entry->name == NULL) {
+            entry->name = table->shadows[i].name;
+            entry->value = -1;
+            entry->depth = -1;
+            table->length++;
+        }
+    }
+
+    free(table->entries);
+    table->entries = entries;
+    table->capacity = capacity;
+}
+
+int joint_symbol_table_push_scope(joint_symbol_table_t * table) {
+    table->depth++;
+
+    return table->shadows_length;
+}
+
+void joint_symbol_table_pop_scope(joint_symbol_table_t * table, int watermark) {
+    while (table->shadows_length > watermark) {
+        const joint_symbol_table_shadow_t * shadow = &table->shadows[--table->shadows_length];
+        joint_symbol_table_entry_t * entry = joint_symbol_table_slot(table->entries, table->capacity, shadow->name);
+
+        entry->value = shadow->value;
+        entry->depth = shadow->depth;
+    }
+
+    table->depth--;
+}
+
+int joint_symbol_table_declare(joint_symbol_table_t * table, const joint_intern_string_t * name, int value) {
+    if ((table->length + 1) * 2 > table->capacity) {
+        joint_symbol_table_grow(table);
+    }
+
+    joint_symbol_table_entry_t * entry = joint_symbol_table_slot(table->entries, table->capacity, name);
+
+    if (entry->name == NULL) {
+        entry->name = name;
+        entry->value = -1;
+        entry->depth = -1;
+        table->length++;
+    }
+
+    if (entry->value >= 0 && entry->depth == table->depth) {
+        int previous = entry->value;
+        entry->value = value;
+
+        return previous;
+    }
+
+    if (table->shadows_length == table->shadows_capacity) {
+        table->shadows_capacity *= 2;
+        table->shadows = realloc(table->shadows, sizeof(joint_symbol_table_shadow_t) * table->shadows_capacity);
+        assert(table->shadows);
+    }
+
+    table->shadows[table->shadows_length].name = name;
+    table->shadows[table->shadows_length].value = entry->value;
+    table->shadows[table->shadows_length].depth = entry->depth;
+    table->shadows_length++;
+
+    entry->value = value;
+    entry->depth = table->depth;
+
+    return -1;
+}
+
+int joint_symbol_table_lookup(const joint_symbol_table_t * table, const joint_intern_string_t * name) {
+    int slot = (int) (name->hash & (uint64_t) (table->capacity - 1));
+
+    while (table->entries[slot].name != NULL) {
+        if (table->entries[slot].name == name) {
+            return table->entries[slot].value;
+        }
+
+        slot = (slot + 1) & (table->capacity - 1);
+    }
+
+    return -1;
+}
+
+void joint_symbol_table_free(joint_symbol_table_t * table) {
+    free(table->entries);
+    free(table->shadows);
+    free(table);
+}
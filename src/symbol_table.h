@@ -0,0 +1,70 @@
+/* Copyright (c) 2014 Vyacheslav Slinko
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef joint_symbol_table_h
+#define joint_symbol_table_h
+
+#include <stdbool.h>
+#include "intern.h"
+
+/* Maps interned names to non-negative values. Entries are never moved out
+ * of their slot until the table grows, popping a scope restores the values
+ * it shadowed from an undo log instead of rehashing. */
+
+typedef struct joint_symbol_table_entry {
+    const joint_intern_string_t * name;
+    int value;
+    int depth;
+} joint_symbol_table_entry_t;
+
+typedef struct joint_symbol_table_shadow {
+    const joint_intern_string_t * name;
+    int value;
+    int depth;
+} joint_symbol_table_shadow_t;
+
+typedef struct joint_symbol_table {
+    int length;
+    int capacity;
+    joint_symbol_table_entry_t * entries;
+
+    int depth;
+    int shadows_length;
+    int shadows_capacity;
+    joint_symbol_table_shadow_t * shadows;
+} joint_symbol_table_t;
+
+joint_symbol_table_t * joint_symbol_table_alloc(void);
+
+/* Returns the watermark to pass to joint_symbol_table_pop_scope. */
+int joint_symbol_table_push_scope(joint_symbol_table_t * table);
+
+void joint_symbol_table_pop_scope(joint_symbol_table_t * table, int watermark);
+
+/* Returns the value the name had in the current scope or -1. */
+int joint_symbol_table_declare(joint_symbol_table_t * table, const joint_intern_string_t * name, int value);
+
+/* Returns -1 when the name is not bound. */
+int joint_symbol_table_lookup(const joint_symbol_table_t * table, const joint_intern_string_t * name);
+
+void joint_symbol_table_free(joint_symbol_table_t * table);
+
+#endif
@@ -24,7 +24,10 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include "dump.h"
 #include "tokenizer.h"
+#include "utf8.h"
+#include "writer.h"
 
 static const char * joint_tokenizer_token_type_names[] = {
     "COMMENT_TOKEN",
@@ -36,7 +39,37 @@ static const char * joint_tokenizer_token_type_names[] = {
     "CHARACTER_LITERAL_TOKEN",
     "STRING_LITERAL_TOKEN",
     "NULL_LITERAL_TOKEN",
-    "EOF_TOKEN"
+    "EOF_TOKEN",
+    "ERROR_TOKEN"
+};
+
+/* Punctuators by their first character, longer ones are told apart by the
+ * characters that follow. */
+static const enum joint_punctuator joint_tokenizer_punctuators[128] = {
+    ['('] = LEFT_PARENTHESIS_PUNCTUATOR,
+    [')'] = RIGHT_PARENTHESIS_PUNCTUATOR,
+    ['['] = LEFT_BRACKET_PUNCTUATOR,
+    [']'] = RIGHT_BRACKET_PUNCTUATOR,
+    ['{'] = LEFT_BRACE_PUNCTUATOR,
+    ['}'] = RIGHT_BRACE_PUNCTUATOR,
+    [','] = COMMA_PUNCTUATOR,
+    ['.'] = DOT_PUNCTUATOR,
+    [':'] = COLON_PUNCTUATOR,
+    [';'] = SEMICOLON_PUNCTUATOR,
+    ['?'] = QUESTION_PUNCTUATOR,
+    ['='] = ASSIGN_PUNCTUATOR,
+    ['+'] = PLUS_PUNCTUATOR,
+    ['-'] = MINUS_PUNCTUATOR,
+    ['*'] = MULTIPLY_PUNCTUATOR,
+    ['/'] = DIVIDE_PUNCTUATOR,
+    ['%'] = MODULO_PUNCTUATOR,
+    ['&'] = BITWISE_AND_PUNCTUATOR,
+    ['|'] = BITWISE_OR_PUNCTUATOR,
+    ['^'] = BITWISE_XOR_PUNCTUATOR,
+    ['~'] = BITWISE_NOT_PUNCTUATOR,
+    ['!'] = LOGICAL_NOT_PUNCTUATOR,
+    ['<'] = LESS_PUNCTUATOR,
+    ['>'] = GREATER_PUNCTUATOR
 };
 
 static inline bool joint_tokenizer_is_whitespace(char character) {
@@ -75,22 +108,99 @@ static inline bool joint_tokenizer_is_string_quote(char character) {
     return character == 0x22;
 }
 
-static joint_source_file_position_t * joint_tokenizer_fixate_position(const joint_tokenizer_t * tokenizer) {
-    joint_source_file_position_t * position = malloc(sizeof(joint_source_file_position_t));
+/* Returns the length of the identifier code point at the current position,
+ * or 0 when there is none. Above ASCII identifiers follow XID_Start and
+ * XID_Continue. */
+static int joint_tokenizer_match_identifier(const joint_tokenizer_t * tokenizer, bool start) {
+    const joint_string_t * content = tokenizer->source_file->content;
+    char character = content->data[tokenizer->current_position];
+    uint32_t code_point;
+
+    if ((unsigned char) character < 0x80) {
+        return (start ? joint_tokenizer_is_identifier_start(character) : joint_tokenizer_is_identifier_part(character)) ? 1 : 0;
+    }
+
+    int length = joint_utf8_decode(content->data + tokenizer->current_position, content->length - tokenizer->current_position, &code_point);
+
+    if (length == 0) {
+        return 0;
+    }
+
+    return (start ? joint_utf8_is_xid_start(code_point) : joint_utf8_is_xid_continue(code_point)) ? length : 0;
+}
+
+size_t joint_tokenizer_code_point_column(joint_tokenizer_t * tokenizer) {
+    size_t column = tokenizer->current_position - tokenizer->current_line_start_position;
+
+    if (tokenizer->source_file->ascii) {
+        return column;
+    }
+
+    if (tokenizer->counted_line_start_position != tokenizer->current_line_start_position || tokenizer->counted_position > tokenizer->current_position) {
+        tokenizer->counted_line_start_position = tokenizer->current_line_start_position;
+        tokenizer->counted_position = tokenizer->current_line_start_position;
+        tokenizer->counted_continuation_bytes = 0;
+    }
+
+    size_t length = tokenizer->current_position - tokenizer->counted_position;
+    tokenizer->counted_continuation_bytes += length - joint_utf8_count_code_points(tokenizer->source_file->content->data + tokenizer->counted_position, length);
+    tokenizer->counted_position = tokenizer->current_position;
+
+    return column - tokenizer->counted_continuation_bytes;
+}
+
+static joint_source_file_position_t * joint_tokenizer_fixate_position(joint_tokenizer_t * tokenizer) {
+    joint_source_file_position_t * position = JOINT_ALLOCATE(tokenizer->allocator, sizeof(joint_source_file_position_t));
     assert(position);
 
-    position->path = malloc(sizeof(char) * (strlen(tokenizer->source_file->path) + 1));
+    position->path = JOINT_ALLOCATE(tokenizer->allocator, sizeof(char) * (strlen(tokenizer->source_file->path) + 1));
     assert(position->path);
     strcpy(position->path, tokenizer->source_file->path);
 
     position->position = tokenizer->current_position;
     position->line = tokenizer->current_line_number;
     position->column = tokenizer->current_position - tokenizer->current_line_start_position;
+    position->code_point_column = joint_tokenizer_code_point_column(tokenizer);
 
     return position;
 }
 
-static void joint_tokenizer_skip_whitespaces(joint_tokenizer_t * tokenizer) {
+static void joint_tokenizer_fail(joint_tokenizer_t * tokenizer) {
+    tokenizer->failed = true;
+}
+
+void joint_tokenizer_append_comment(joint_tokenizer_t * tokenizer, const joint_tokenizer_comment_t * comment) {
+    if (tokenizer->comments_length == tokenizer->comments_capacity) {
+        tokenizer->comments_capacity = tokenizer->comments_capacity > 0 ? tokenizer->comments_capacity * 2 : 16;
+        tokenizer->comments = JOINT_REALLOCATE(tokenizer->allocator, tokenizer->comments, sizeof(joint_tokenizer_comment_t) * tokenizer->comments_capacity);
+        assert(tokenizer->comments);
+    }
+
+    tokenizer->comments[tokenizer->comments_length++] = *comment;
+}
+
+static void joint_tokenizer_skip_comment(joint_tokenizer_t * tokenizer) {
+    const char * data = tokenizer->source_file->content->data;
+    size_t length = tokenizer->source_file->content->length;
+    size_t start = tokenizer->current_position;
+    const char * newline = memchr(data + start + 1, '\n', length - start - 1);
+    size_t end = newline != NULL ? (size_t) (newline - data) : length;
+
+    if (tokenizer->record_comments) {
+        joint_tokenizer_comment_t comment = {
+            .start = start,
+            .end = end,
+            .line = tokenizer->current_line_number,
+            .column = start - tokenizer->current_line_start_position
+        };
+
+        joint_tokenizer_append_comment(tokenizer, &comment);
+    }
+
+    tokenizer->current_position = end;
+}
+
+void joint_tokenizer_skip_whitespaces(joint_tokenizer_t * tokenizer) {
     char character;
 
     while (tokenizer->current_position < tokenizer->source_file->content->length) {
@@ -102,6 +212,8 @@ static void joint_tokenizer_skip_whitespaces(joint_tokenizer_t * tokenizer) {
             tokenizer->current_position++;
             tokenizer->current_line_number++;
             tokenizer->current_line_start_position = tokenizer->current_position;
+        } else if (tokenizer->skip_comments && joint_tokenizer_is_comment_start(character)) {
+            joint_tokenizer_skip_comment(tokenizer);
         } else {
             break;
         }
@@ -128,22 +240,20 @@ static void joint_tokenizer_lex_comment(joint_tokenizer_t * tokenizer, joint_tok
 }
 
 static void joint_tokenizer_lex_identifier(joint_tokenizer_t * tokenizer, joint_token_t * token) {
-    char character = tokenizer->source_file->content->data[tokenizer->current_position];
-    assert(joint_tokenizer_is_identifier_start(character));
-    tokenizer->current_position++;
-
-    joint_string_append_character(token->value, character);
+    int length = joint_tokenizer_match_identifier(tokenizer, true);
+    assert(length > 0);
 
-    while (tokenizer->current_position < tokenizer->source_file->content->length) {
-        character = tokenizer->source_file->content->data[tokenizer->current_position];
+    do {
+        for (int i = 0; i < length; i++) {
+            joint_string_append_character(token->value, tokenizer->source_file->content->data[tokenizer->current_position++]);
+        }
 
-        if (joint_tokenizer_is_identifier_part(character)) {
-            tokenizer->current_position++;
-            joint_string_append_character(token->value, character);
-        } else {
+        if (tokenizer->current_position >= tokenizer->source_file->content->length) {
             break;
         }
-    }
+
+        length = joint_tokenizer_match_identifier(tokenizer, false);
+    } while (length > 0);
 
     if (strcmp(token->value->data, "let") == 0 || strcmp(token->value->data, "import") == 0 || strcmp(token->value->data, "from") == 0) {
         token->type = KEYWORD_TOKEN;
@@ -182,13 +292,24 @@ static void joint_tokenizer_lex_character_literal(joint_tokenizer_t * tokenizer,
     assert(joint_tokenizer_is_character_quote(character));
     tokenizer->current_position++;
 
+    if (tokenizer->current_position + 1 >= tokenizer->source_file->content->length) {
+        joint_tokenizer_fail(tokenizer);
+        return;
+    }
+
     character = tokenizer->source_file->content->data[tokenizer->current_position];
-    assert(!joint_tokenizer_is_character_quote(character));
+    if (joint_tokenizer_is_character_quote(character)) {
+        joint_tokenizer_fail(tokenizer);
+        return;
+    }
     tokenizer->current_position++;
     joint_string_append_character(token->value, character);
 
     character = tokenizer->source_file->content->data[tokenizer->current_position];
-    assert(joint_tokenizer_is_character_quote(character));
+    if (!joint_tokenizer_is_character_quote(character)) {
+        joint_tokenizer_fail(tokenizer);
+        return;
+    }
     tokenizer->current_position++;
 
     token->type = CHARACTER_LITERAL_TOKEN;
@@ -217,7 +338,7 @@ static void joint_tokenizer_lex_string_literal(joint_tokenizer_t * tokenizer, jo
         joint_string_append_character(token->value, character);
     }
 
-    assert(NULL);
+    joint_tokenizer_fail(tokenizer);
 }
 
 static void joint_tokenizer_lex_punctuator(joint_tokenizer_t * tokenizer, joint_token_t * token) {
@@ -249,7 +370,7 @@ static void joint_tokenizer_lex_punctuator(joint_tokenizer_t * tokenizer, joint_
     }
 
     if ((tokenizer->source_file->content->length - tokenizer->current_position) >= 3) {
-        char * character3 = malloc(sizeof(char) * 4);
+        char * character3 = JOINT_ALLOCATE(tokenizer->allocator, sizeof(char) * 4);
         assert(character3);
         memcpy(character3, tokenizer->source_file->content->data + tokenizer->current_position, 3);
         character3[3] = '\0';
@@ -257,14 +378,14 @@ static void joint_tokenizer_lex_punctuator(joint_tokenizer_t * tokenizer, joint_
             tokenizer->current_position += 3;
             joint_string_set_content(token->value, character3);
             token->type = PUNCTUATOR_TOKEN;
-            free(character3);
+            JOINT_DEALLOCATE(tokenizer->allocator, character3);
             return;
         }
-        free(character3);
+        JOINT_DEALLOCATE(tokenizer->allocator, character3);
     }
 
     if ((tokenizer->source_file->content->length - tokenizer->current_position) >= 2) {
-        char * character2 = malloc(sizeof(char) * 3);
+        char * character2 = JOINT_ALLOCATE(tokenizer->allocator, sizeof(char) * 3);
         assert(character2);
         memcpy(character2, tokenizer->source_file->content->data + tokenizer->current_position, 2);
         character2[2] = '\0';
@@ -272,29 +393,30 @@ static void joint_tokenizer_lex_punctuator(joint_tokenizer_t * tokenizer, joint_
             tokenizer->current_position += 2;
             joint_string_set_content(token->value, character2);
             token->type = PUNCTUATOR_TOKEN;
-            free(character2);
+            JOINT_DEALLOCATE(tokenizer->allocator, character2);
             return;
         }
-        free(character2);
+        JOINT_DEALLOCATE(tokenizer->allocator, character2);
     }
 
+    joint_string_append_character(token->value, character);
+    tokenizer->current_position++;
+
     if (strchr("<>=!&|", character) != NULL) {
-        joint_string_append_character(token->value, character);
-        tokenizer->current_position++;
         token->type = PUNCTUATOR_TOKEN;
         return;
     }
 
-    assert(NULL);
+    joint_tokenizer_fail(tokenizer);
 }
 
 static joint_token_t * joint_tokenizer_lex(joint_tokenizer_t * tokenizer) {
-    joint_token_t * token = malloc(sizeof(joint_token_t));
+    joint_token_t * token = JOINT_ALLOCATE(tokenizer->allocator, sizeof(joint_token_t));
     assert(token);
 
     joint_tokenizer_skip_whitespaces(tokenizer);
 
-    token->value = joint_string_alloc(8);
+    token->value = joint_string_alloc(tokenizer->allocator, 8);
     token->start_position = joint_tokenizer_fixate_position(tokenizer);
 
     if (tokenizer->current_position >= tokenizer->source_file->content->length) {
@@ -307,7 +429,7 @@ static joint_token_t * joint_tokenizer_lex(joint_tokenizer_t * tokenizer) {
 
     if (joint_tokenizer_is_comment_start(character)) {
         joint_tokenizer_lex_comment(tokenizer, token);
-    } else if (joint_tokenizer_is_identifier_start(character)) {
+    } else if (joint_tokenizer_match_identifier(tokenizer, true) > 0) {
         joint_tokenizer_lex_identifier(tokenizer, token);
     } else if (joint_tokenizer_is_numeric(character)) {
         joint_tokenizer_lex_numeric_literal(tokenizer, token);
@@ -319,35 +441,59 @@ static joint_token_t * joint_tokenizer_lex(joint_tokenizer_t * tokenizer) {
         joint_tokenizer_lex_punctuator(tokenizer, token);
     }
 
+    /* Speculative runs stop at the failure, others go on past the error. */
+    if (tokenizer->failed && !tokenizer->speculative) {
+        token->type = ERROR_TOKEN;
+        tokenizer->failed = false;
+    }
+
     token->end_position = joint_tokenizer_fixate_position(tokenizer);
 
     return token;
 }
 
-joint_tokenizer_t * joint_tokenizer_alloc(joint_source_file_t * source_file) {
-    joint_tokenizer_t * tokenizer = malloc(sizeof(joint_tokenizer_t));
+joint_tokenizer_t * joint_tokenizer_alloc(joint_allocator_t * allocator, joint_source_file_t * source_file) {
+    joint_tokenizer_t * tokenizer = JOINT_ALLOCATE(allocator, sizeof(joint_tokenizer_t));
     assert(tokenizer);
 
+    tokenizer->allocator = allocator;
     tokenizer->source_file = source_file;
 
     tokenizer->current_position = 0;
     tokenizer->current_line_number = 0;
     tokenizer->current_line_start_position = 0;
 
+    tokenizer->counted_line_start_position = 0;
+    tokenizer->counted_position = 0;
+    tokenizer->counted_continuation_bytes = 0;
+
+    tokenizer->speculative = false;
+    tokenizer->failed = false;
+
+    tokenizer->skip_comments = false;
+    tokenizer->record_comments = false;
+    tokenizer->comments_length = 0;
+    tokenizer->comments_capacity = 0;
+    tokenizer->comments = NULL;
+
     tokenizer->tokens_length = 0;
     tokenizer->tokens = NULL;
 
     return tokenizer;
 }
 
+joint_token_t * joint_tokenizer_next_token(joint_tokenizer_t * tokenizer) {
+    return joint_tokenizer_lex(tokenizer);
+}
+
 void joint_tokenizer_tokenize(joint_tokenizer_t * tokenizer) {
     while (true) {
         joint_token_t * token = joint_tokenizer_lex(tokenizer);
 
         if (tokenizer->tokens_length == 0) {
-            tokenizer->tokens = malloc(sizeof(joint_token_t *));
+            tokenizer->tokens = JOINT_ALLOCATE(tokenizer->allocator, sizeof(joint_token_t *));
         } else {
-            tokenizer->tokens = realloc(tokenizer->tokens, sizeof(joint_token_t *) * (tokenizer->tokens_length + 1));
+            tokenizer->tokens = JOINT_REALLOCATE(tokenizer->allocator, tokenizer->tokens, sizeof(joint_token_t *) * (tokenizer->tokens_length + 1));
         }
         assert(tokenizer->tokens);
 
@@ -359,31 +505,77 @@ void joint_tokenizer_tokenize(joint_tokenizer_t * tokenizer) {
     }
 }
 
-void joint_tokeinzer_print(const joint_tokenizer_t * tokenizer) {
-    for (int i = 0; i < tokenizer->tokens_length; i++) {
-        joint_token_t * token = tokenizer->tokens[i];
-
-        printf("TYPE: %s\n", joint_tokenizer_token_type_names[token->type]);
-        printf("VALUE: \"%s\"\n", token->value->data);
-        printf("START: p %d l %d c %d\n", token->start_position->position, token->start_position->line, token->start_position->column);
-        printf("END: p %d l %d c %d\n", token->end_position->position, token->end_position->line, token->end_position->column);
-        puts("---");
+const char * joint_tokenizer_token_type_name(int type) {
+    if (type < 0 || (size_t) type >= sizeof(joint_tokenizer_token_type_names) / sizeof(joint_tokenizer_token_type_names[0])) {
+        return NULL;
     }
+
+    return joint_tokenizer_token_type_names[type];
+}
+
+enum joint_punctuator joint_tokenizer_punctuator(const joint_token_t * token) {
+    if (token->type != PUNCTUATOR_TOKEN) {
+        return NO_PUNCTUATOR;
+    }
+
+    const char * data = token->value->data;
+    enum joint_punctuator punctuator = joint_tokenizer_punctuators[(unsigned char) data[0] & 0x7F];
+
+    if (data[1] == '\0') {
+        return punctuator;
+    }
+
+    switch (punctuator) {
+        case BITWISE_AND_PUNCTUATOR:
+            return LOGICAL_AND_PUNCTUATOR;
+
+        case BITWISE_OR_PUNCTUATOR:
+            return LOGICAL_OR_PUNCTUATOR;
+
+        case ASSIGN_PUNCTUATOR:
+            return EQUAL_PUNCTUATOR;
+
+        case LOGICAL_NOT_PUNCTUATOR:
+            return NOT_EQUAL_PUNCTUATOR;
+
+        case LESS_PUNCTUATOR:
+            return LEFT_SHIFT_PUNCTUATOR;
+
+        case GREATER_PUNCTUATOR:
+            return data[2] == '\0' ? RIGHT_SHIFT_PUNCTUATOR : UNSIGNED_RIGHT_SHIFT_PUNCTUATOR;
+
+        default:
+            return NO_PUNCTUATOR;
+    }
+}
+
+void joint_tokeinzer_print(const joint_tokenizer_t * tokenizer) {
+    joint_writer_t * writer = joint_writer_alloc(1, 65536);
+    joint_dump_tokens(writer, tokenizer, TEXT_DUMP_FORMAT);
+    joint_writer_free(writer);
+}
+
+void joint_token_free(const joint_tokenizer_t * tokenizer, joint_token_t * token) {
+    joint_string_free(token->value);
+    JOINT_DEALLOCATE(tokenizer->allocator, token->start_position->path);
+    JOINT_DEALLOCATE(tokenizer->allocator, token->end_position->path);
+    JOINT_DEALLOCATE(tokenizer->allocator, token->start_position);
+    JOINT_DEALLOCATE(tokenizer->allocator, token->end_position);
+    JOINT_DEALLOCATE(tokenizer->allocator, token);
 }
 
 void joint_tokenizer_free(joint_tokenizer_t * tokenizer) {
-    for (int i = 0; i < tokenizer->tokens_length; i++) {
-        joint_string_free(tokenizer->tokens[i]->value);
-        free(tokenizer->tokens[i]->start_position->path);
-        free(tokenizer->tokens[i]->end_position->path);
-        free(tokenizer->tokens[i]->start_position);
-        free(tokenizer->tokens[i]->end_position);
-        free(tokenizer->tokens[i]);
+    for (size_t i = 0; i < tokenizer->tokens_length; i++) {
+        joint_token_free(tokenizer, tokenizer->tokens[i]);
     }
 
     if (tokenizer->tokens != NULL) {
-        free(tokenizer->tokens);
+        JOINT_DEALLOCATE(tokenizer->allocator, tokenizer->tokens);
+    }
+
+    if (tokenizer->comments != NULL) {
+        JOINT_DEALLOCATE(tokenizer->allocator, tokenizer->comments);
     }
 
-    free(tokenizer);
+    JOINT_DEALLOCATE(tokenizer->allocator, tokenizer);
 }
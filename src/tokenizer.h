@@ -22,14 +22,17 @@
 #ifndef joint_tokenizer_h
 #define joint_tokenizer_h
 
+#include <stdbool.h>
+#include "allocator.h"
 #include "source_file.h"
-#include "string.h"
+#include "joint_string.h"
 
 typedef struct joint_source_file_position {
     char * path;
-    int position;
-    int line;
-    int column;
+    size_t position;
+    size_t line;
+    size_t column;
+    size_t code_point_column;
 } joint_source_file_position_t;
 
 typedef struct joint_token {
@@ -43,7 +46,9 @@ typedef struct joint_token {
         CHARACTER_LITERAL_TOKEN,
         STRING_LITERAL_TOKEN,
         NULL_LITERAL_TOKEN,
-        EOF_TOKEN
+        EOF_TOKEN,
+        /* Input that is no valid token, left for the parser to report. */
+        ERROR_TOKEN
     } type;
 
     joint_string_t * value;
@@ -52,23 +57,99 @@ typedef struct joint_token {
     joint_source_file_position_t * end_position;
 } joint_token_t;
 
+enum joint_punctuator {
+    NO_PUNCTUATOR,
+    LEFT_PARENTHESIS_PUNCTUATOR,
+    RIGHT_PARENTHESIS_PUNCTUATOR,
+    LEFT_BRACKET_PUNCTUATOR,
+    RIGHT_BRACKET_PUNCTUATOR,
+    LEFT_BRACE_PUNCTUATOR,
+    RIGHT_BRACE_PUNCTUATOR,
+    COMMA_PUNCTUATOR,
+    DOT_PUNCTUATOR,
+    COLON_PUNCTUATOR,
+    SEMICOLON_PUNCTUATOR,
+    QUESTION_PUNCTUATOR,
+    ASSIGN_PUNCTUATOR,
+    PLUS_PUNCTUATOR,
+    MINUS_PUNCTUATOR,
+    MULTIPLY_PUNCTUATOR,
+    DIVIDE_PUNCTUATOR,
+    MODULO_PUNCTUATOR,
+    BITWISE_AND_PUNCTUATOR,
+    BITWISE_OR_PUNCTUATOR,
+    BITWISE_XOR_PUNCTUATOR,
+    BITWISE_NOT_PUNCTUATOR,
+    LEFT_SHIFT_PUNCTUATOR,
+    RIGHT_SHIFT_PUNCTUATOR,
+    UNSIGNED_RIGHT_SHIFT_PUNCTUATOR,
+    LOGICAL_AND_PUNCTUATOR,
+    LOGICAL_OR_PUNCTUATOR,
+    LOGICAL_NOT_PUNCTUATOR,
+    EQUAL_PUNCTUATOR,
+    NOT_EQUAL_PUNCTUATOR,
+    LESS_PUNCTUATOR,
+    GREATER_PUNCTUATOR
+};
+
+/* The range of a skipped comment, from its # up to the end of the line. */
+typedef struct joint_tokenizer_comment {
+    size_t start;
+    size_t end;
+    size_t line;
+    size_t column;
+} joint_tokenizer_comment_t;
+
 typedef struct joint_tokenizer {
+    joint_allocator_t * allocator;
     joint_source_file_t * source_file;
 
-    int current_position;
-    int current_line_number;
-    int current_line_start_position;
+    size_t current_position;
+    size_t current_line_number;
+    size_t current_line_start_position;
+
+    /* Continuation bytes between the line start and the counted position,
+     * counted once per line for code point columns. */
+    size_t counted_line_start_position;
+    size_t counted_position;
+    size_t counted_continuation_bytes;
 
-    int tokens_length;
+    bool speculative;
+    bool failed;
+
+    /* Skipped comments produce no tokens, their ranges are kept only when
+     * record_comments is set. */
+    bool skip_comments;
+    bool record_comments;
+    size_t comments_length;
+    size_t comments_capacity;
+    joint_tokenizer_comment_t * comments;
+
+    size_t tokens_length;
     joint_token_t ** tokens;
 } joint_tokenizer_t;
 
-joint_tokenizer_t * joint_tokenizer_alloc(joint_source_file_t * source_file);
+joint_tokenizer_t * joint_tokenizer_alloc(joint_allocator_t * allocator, joint_source_file_t * source_file);
+
+void joint_tokenizer_skip_whitespaces(joint_tokenizer_t * tokenizer);
+
+size_t joint_tokenizer_code_point_column(joint_tokenizer_t * tokenizer);
+
+void joint_tokenizer_append_comment(joint_tokenizer_t * tokenizer, const joint_tokenizer_comment_t * comment);
+
+joint_token_t * joint_tokenizer_next_token(joint_tokenizer_t * tokenizer);
 
 void joint_tokenizer_tokenize(joint_tokenizer_t * tokenizer);
 
+const char * joint_tokenizer_token_type_name(int type);
+
+/* Returns NO_PUNCTUATOR for tokens other than punctuators. */
+enum joint_punctuator joint_tokenizer_punctuator(const joint_token_t * token);
+
 void joint_tokeinzer_print(const joint_tokenizer_t * tokenizer);
 
+void joint_token_free(const joint_tokenizer_t * tokenizer, joint_token_t * token);
+
 void joint_tokenizer_free(joint_tokenizer_t * tokenizer);
 
 #endif
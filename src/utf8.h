@@ -0,0 +1,48 @@
+/* Copyright (c) 2014 Vyacheslav Slinko
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef joint_utf8_h
+#define joint_utf8_h
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Returns the length of the longest well-formed UTF-8 prefix of data, which
+ * is length when all of it is valid. ascii, when given, tells whether all
+ * of data is plain ASCII. */
+size_t joint_utf8_validate(const char * data, size_t length, bool * ascii);
+
+bool joint_utf8_is_ascii(const char * data, size_t length);
+
+/* Decodes the code point at the start of data and returns its length in
+ * bytes, or 0 when the sequence is malformed. */
+int joint_utf8_decode(const char * data, size_t length, uint32_t * code_point);
+
+size_t joint_utf8_count_code_points(const char * data, size_t length);
+
+/* Both only answer for code points above ASCII, the tokenizer keeps its own
+ * rules for ASCII identifiers. */
+bool joint_utf8_is_xid_start(uint32_t code_point);
+
+bool joint_utf8_is_xid_continue(uint32_t code_point);
+
+#endif
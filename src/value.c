@@ -0,0 +1,43 @@
+/* Copyright (c) 2014 Vyacheslav Slinko
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stdint.h>
+#include "builtins.h"
+#include "value.h"
+
+void joint_value_write(joint_writer_t * writer, joint_value_t value) {
+    if (joint_value_is_number(value)) {
+        joint_writer_write_number(writer, joint_value_as_number(value));
+    } else if (joint_value_is_boolean(value)) {
+        joint_writer_write_string(writer, joint_value_as_boolean(value) ? "true" : "false");
+    } else if (joint_value_is_character(value)) {
+        joint_writer_write_character(writer, joint_value_as_character(value));
+    } else if (joint_value_is_string(value)) {
+        const joint_intern_string_t * string = joint_value_as_string(value);
+        joint_writer_write(writer, string->characters, string->length);
+    } else if (joint_value_is_function(value)) {
+        joint_writer_write_string(writer, "[function ");
+        joint_writer_write_string(writer, joint_value_as_function(value)->name);
+        joint_writer_write_character(writer, ']');
+    } else {
+        joint_writer_write_string(writer, "null");
+    }
+}
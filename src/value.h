@@ -0,0 +1,131 @@
+/* Copyright (c) 2014 Vyacheslav Slinko
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef joint_value_h
+#define joint_value_h
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include "intern.h"
+#include "writer.h"
+
+struct joint_builtin;
+
+/* Values are NaN-boxed into 64 bits. Every bit pattern below 0xFFF9 << 48 is
+ * a double (NaNs produced by arithmetic are canonicalized to a positive quiet
+ * NaN when boxed), the remaining patterns carry a 16-bit tag and a 48-bit
+ * payload: a boolean, a character or a pointer. Null is a tag without a
+ * payload. */
+typedef uint64_t joint_value_t;
+
+#define JOINT_VALUE_TAG_MASK 0xFFFF000000000000ULL
+#define JOINT_VALUE_PAYLOAD_MASK 0x0000FFFFFFFFFFFFULL
+#define JOINT_VALUE_CANONICAL_NAN 0x7FF8000000000000ULL
+
+#define JOINT_VALUE_NULL_TAG 0xFFF9000000000000ULL
+#define JOINT_VALUE_BOOLEAN_TAG 0xFFFA000000000000ULL
+#define JOINT_VALUE_CHARACTER_TAG 0xFFFB000000000000ULL
+#define JOINT_VALUE_STRING_TAG 0xFFFC000000000000ULL
+#define JOINT_VALUE_FUNCTION_TAG 0xFFFD000000000000ULL
+
+#define JOINT_VALUE_NULL JOINT_VALUE_NULL_TAG
+#define JOINT_VALUE_FALSE JOINT_VALUE_BOOLEAN_TAG
+#define JOINT_VALUE_TRUE (JOINT_VALUE_BOOLEAN_TAG | 1)
+
+static inline joint_value_t joint_value_number(double number) {
+    joint_value_t value;
+
+    if (number != number) {
+        return JOINT_VALUE_CANONICAL_NAN;
+    }
+
+    memcpy(&value, &number, sizeof(value));
+
+    return value;
+}
+
+static inline joint_value_t joint_value_boolean(bool boolean) {
+    return boolean ? JOINT_VALUE_TRUE : JOINT_VALUE_FALSE;
+}
+
+static inline joint_value_t joint_value_character(char character) {
+    return JOINT_VALUE_CHARACTER_TAG | (unsigned char) character;
+}
+
+static inline joint_value_t joint_value_string(const joint_intern_string_t * string) {
+    return JOINT_VALUE_STRING_TAG | (uint64_t) (uintptr_t) string;
+}
+
+static inline joint_value_t joint_value_function(const struct joint_builtin * function) {
+    return JOINT_VALUE_FUNCTION_TAG | (uint64_t) (uintptr_t) function;
+}
+
+static inline bool joint_value_is_number(joint_value_t value) {
+    return value < JOINT_VALUE_NULL_TAG;
+}
+
+static inline bool joint_value_is_null(joint_value_t value) {
+    return value == JOINT_VALUE_NULL;
+}
+
+static inline bool joint_value_is_boolean(joint_value_t value) {
+    return (value & JOINT_VALUE_TAG_MASK) == JOINT_VALUE_BOOLEAN_TAG;
+}
+
+static inline bool joint_value_is_character(joint_value_t value) {
+    return (value & JOINT_VALUE_TAG_MASK) == JOINT_VALUE_CHARACTER_TAG;
+}
+
+static inline bool joint_value_is_string(joint_value_t value) {
+    return (value & JOINT_VALUE_TAG_MASK) == JOINT_VALUE_STRING_TAG;
+}
+
+static inline bool joint_value_is_function(joint_value_t value) {
+    return (value & JOINT_VALUE_TAG_MASK) == JOINT_VALUE_FUNCTION_TAG;
+}
+
+static inline double joint_value_as_number(joint_value_t value) {
+    double number;
+    memcpy(&number, &value, sizeof(number));
+
+    return number;
+}
+
+static inline bool joint_value_as_boolean(joint_value_t value) {
+    return (value & 1) != 0;
+}
+
+static inline char joint_value_as_character(joint_value_t value) {
+    return (char) (value & 0xFF);
+}
+
+static inline const joint_intern_string_t * joint_value_as_string(joint_value_t value) {
+    return (const joint_intern_string_t *) (uintptr_t) (value & JOINT_VALUE_PAYLOAD_MASK);
+}
+
+static inline const struct joint_builtin * joint_value_as_function(joint_value_t value) {
+    return (const struct joint_builtin *) (uintptr_t) (value & JOINT_VALUE_PAYLOAD_MASK);
+}
+
+void joint_value_write(joint_writer_t * writer, joint_value_t value);
+
+#endif
@@ -0,0 +1,428 @@
+/* Copyright (c) 2014 Vyacheslav Slinko
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <assert.h>
+#include <poll.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/inotify.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "dump.h"
+#include "hash.h"
+#include "interface.h"
+#include "loader.h"
+#include "module.h"
+#include "parser.h"
+#include "semantic.h"
+#include "stats.h"
+#include "watch.h"
+#include "writer.h"
+
+#define JOINT_WATCH_DEBOUNCE_MILLISECONDS 50
+
+typedef struct joint_watch_directory {
+    int descriptor;
+    char * path;
+} joint_watch_directory_t;
+
+typedef struct joint_watch {
+    int fd;
+
+    int modules_length;
+    joint_module_t ** modules;
+    bool * changed;
+
+    /* Built from the last program of each module that compiled, dependents
+     * are checked against them without reading the imports again. */
+    joint_interface_t ** interfaces;
+
+    int directories_length;
+    joint_watch_directory_t * directories;
+} joint_watch_t;
+
+static bool joint_watch_read_output(int fd, char ** data, size_t * length) {
+    size_t capacity = 65536;
+    *data = malloc(capacity);
+    assert(*data);
+    *length = 0;
+
+    while (true) {
+        if (*length == capacity) {
+            capacity *= 2;
+            *data = realloc(*data, capacity);
+            assert(*data);
+        }
+
+        ssize_t received = read(fd, *data + *length, capacity - *length);
+
+        if (received == 0) {
+            return true;
+        }
+
+        if (received < 0) {
+            return false;
+        }
+
+        *length += (size_t) received;
+    }
+}
+
+/* Parsing asserts on syntax errors, so it runs in a child process that
+ * sends back the tokens and AST in the binary dump format. A broken save
+ * then only leaves the previous result of the module in place. */
+static bool joint_watch_compile(joint_module_t * module, joint_source_file_t * source_file) {
+    if (source_file == NULL) {
+        fprintf(stderr, "Unable to read file \"%s\"\n", module->path);
+        return false;
+    }
+
+    int pipe_fds[2];
+
+    if (pipe(pipe_fds) != 0) {
+        perror("pipe");
+        joint_source_file_free(source_file);
+        return false;
+    }
+
+    pid_t pid = fork();
+
+    if (pid == 0) {
+        close(pipe_fds[0]);
+
+        joint_tokenizer_t * tokenizer = joint_tokenizer_alloc(source_file->allocator, source_file);
+        joint_tokenizer_tokenize(tokenizer);
+        joint_parser_t * parser = joint_parser_alloc(source_file->allocator, tokenizer);
+
+        if (!joint_parser_parse(parser)) {
+            joint_parser_print_error(parser);
+            _exit(1);
+        }
+
+        joint_writer_t * writer = joint_writer_alloc(pipe_fds[1], 1 << 20);
+        joint_dump_tokens(writer, tokenizer, BINARY_DUMP_FORMAT);
+        joint_dump_node(writer, parser->program, BINARY_DUMP_FORMAT);
+        _exit(joint_writer_flush(writer) ? 0 : 1);
+    }
+
+    close(pipe_fds[1]);
+
+    if (pid < 0) {
+        perror("fork");
+        close(pipe_fds[0]);
+        joint_source_file_free(source_file);
+        return false;
+    }
+
+    char * data;
+    size_t length;
+    int status;
+    bool received = joint_watch_read_output(pipe_fds[0], &data, &length);
+
+    close(pipe_fds[0]);
+    waitpid(pid, &status, 0);
+
+    joint_tokenizer_t * tokenizer = joint_tokenizer_alloc(source_file->allocator, source_file);
+    joint_node_t * program = NULL;
+    size_t tokens_length;
+    size_t program_length;
+
+    if (received && WIFEXITED(status) && WEXITSTATUS(status) == 0 && joint_dump_load_tokens(data, length, tokenizer, &tokens_length)) {
+        program = joint_dump_load_node(source_file->allocator, data + tokens_length, length - tokens_length, source_file->path, &program_length);
+    }
+
+    free(data);
+
+    if (program == NULL) {
+        fprintf(stderr, "Unable to compile file \"%s\"\n", module->path);
+        joint_tokenizer_free(tokenizer);
+        joint_source_file_free(source_file);
+        return false;
+    }
+
+    joint_module_replace(module, source_file, tokenizer, program);
+
+    return true;
+}
+
+static void joint_watch_directory(joint_watch_t * watch, const char * path) {
+    const char * directory_end = strrchr(path, '/');
+    size_t length = (size_t) (directory_end - path);
+
+    for (int i = 0; i < watch->directories_length; i++) {
+        if (strlen(watch->directories[i].path) == length && strncmp(watch->directories[i].path, path, length) == 0) {
+            return;
+        }
+    }
+
+    char * directory = malloc(sizeof(char) * (length + 2));
+    assert(directory);
+
+    if (length == 0) {
+        strcpy(directory, "/");
+    } else {
+        memcpy(directory, path, length);
+        directory[length] = '\0';
+    }
+
+    int descriptor = inotify_add_watch(watch->fd, directory, IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_DELETE);
+
+    if (descriptor < 0) {
+        perror(directory);
+        free(directory);
+        return;
+    }
+
+    if (length == 0) {
+        directory[0] = '\0';
+    }
+
+    watch->directories = realloc(watch->directories, sizeof(joint_watch_directory_t) * (watch->directories_length + 1));
+    assert(watch->directories);
+    watch->directories[watch->directories_length].descriptor = descriptor;
+    watch->directories[watch->directories_length].path = directory;
+    watch->directories_length++;
+}
+
+static int joint_watch_find_module(const joint_watch_t * watch, const char * path) {
+    for (int i = 0; i < watch->modules_length; i++) {
+        if (strcmp(watch->modules[i]->path, path) == 0) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+static const joint_interface_t * joint_watch_find_interface(const char * path, void * data) {
+    const joint_watch_t * watch = data;
+    int index = joint_watch_find_module(watch, path);
+
+    return index >= 0 ? watch->interfaces[index] : NULL;
+}
+
+static void joint_watch_add_module(joint_watch_t * watch, const char * path) {
+    watch->modules = realloc(watch->modules, sizeof(joint_module_t *) * (watch->modules_length + 1));
+    assert(watch->modules);
+    watch->changed = realloc(watch->changed, sizeof(bool) * (watch->modules_length + 1));
+    assert(watch->changed);
+    watch->interfaces = realloc(watch->interfaces, sizeof(joint_interface_t *) * (watch->modules_length + 1));
+    assert(watch->interfaces);
+
+    watch->modules[watch->modules_length] = joint_module_alloc(path);
+    watch->changed[watch->modules_length] = true;
+    watch->interfaces[watch->modules_length] = NULL;
+    watch->modules_length++;
+
+    joint_watch_directory(watch, path);
+}
+
+static void joint_watch_cycle(joint_watch_t * watch, uint64_t started_at) {
+    int changed_length = 0;
+    int dependents_length = 0;
+    int failed_length = 0;
+
+    /* Changed modules are loaded in the order they are compiled, newly
+     * imported ones are appended and so come after all of them. */
+    joint_loader_t * loader = joint_loader_alloc(joint_allocator_system(), JOINT_LOADER_DEPTH);
+
+    for (int i = 0; i < watch->modules_length; i++) {
+        if (watch->changed[i]) {
+            joint_loader_submit(loader, watch->modules[i]->path);
+        }
+    }
+
+    for (int i = 0; i < watch->modules_length; i++) {
+        if (!watch->changed[i]) {
+            continue;
+        }
+
+        changed_length++;
+
+        /* A broken save keeps the previous result, so there is nothing new
+         * for its dependents to check against. */
+        if (!joint_watch_compile(watch->modules[i], joint_loader_next(loader))) {
+            watch->changed[i] = false;
+            failed_length++;
+            continue;
+        }
+
+        joint_module_t * module = watch->modules[i];
+
+        if (watch->interfaces[i] != NULL) {
+            joint_interface_free(watch->interfaces[i]);
+        }
+
+        watch->interfaces[i] = joint_interface_alloc(module->program, joint_hash_bytes(module->source_file->content->data, (size_t) module->source_file->content->length, 0));
+
+        for (int j = 0; j < module->imports_length; j++) {
+            if (joint_watch_find_module(watch, module->imports[j]) < 0) {
+                joint_watch_add_module(watch, module->imports[j]);
+                joint_loader_submit(loader, module->imports[j]);
+            }
+        }
+    }
+
+    uint64_t wait_time = loader->stats.wait_time;
+    joint_loader_free(loader);
+
+    bool spreading = true;
+
+    while (spreading) {
+        spreading = false;
+
+        for (int i = 0; i < watch->modules_length; i++) {
+            if (watch->changed[i]) {
+                continue;
+            }
+
+            for (int j = 0; j < watch->modules_length; j++) {
+                if (watch->changed[j] && joint_module_imports(watch->modules[i], watch->modules[j]->path)) {
+                    watch->changed[i] = true;
+                    dependents_length++;
+                    spreading = true;
+                    break;
+                }
+            }
+        }
+    }
+
+    /* Dependents are not reparsed, their unchanged trees are checked again
+     * against the new interfaces of their imports. Modules that never
+     * compiled have no interface and are reported as unknown. */
+    for (int i = 0; i < watch->modules_length; i++) {
+        if (watch->changed[i] && watch->modules[i]->program != NULL && !joint_semantic_check_interfaces(watch->modules[i]->program, stderr, NULL, joint_watch_find_interface, watch)) {
+            failed_length++;
+        }
+
+        watch->changed[i] = false;
+    }
+
+    uint64_t elapsed = joint_stats_now() - started_at;
+
+    fprintf(stderr, "watch: %d changed, %d dependents, %d failed, %d.%03d ms, %d.%03d ms waiting for I/O\n",
+        changed_length, dependents_length, failed_length, (int) (elapsed / 1000000), (int) (elapsed / 1000 % 1000),
+        (int) (wait_time / 1000000), (int) (wait_time / 1000 % 1000));
+}
+
+static bool joint_watch_collect_events(joint_watch_t * watch) {
+    char buffer[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+    bool any_changed = false;
+    ssize_t length = read(watch->fd, buffer, sizeof(buffer));
+
+    for (char * current = buffer; length > 0 && current < buffer + length;) {
+        struct inotify_event * event = (struct inotify_event *) current;
+        current += sizeof(struct inotify_event) + event->len;
+
+        if (event->len == 0) {
+            continue;
+        }
+
+        for (int i = 0; i < watch->directories_length; i++) {
+            if (watch->directories[i].descriptor != event->wd) {
+                continue;
+            }
+
+            size_t directory_length = strlen(watch->directories[i].path);
+
+            for (int j = 0; j < watch->modules_length; j++) {
+                const char * path = watch->modules[j]->path;
+
+                if (strncmp(path, watch->directories[i].path, directory_length) == 0 && path[directory_length] == '/' && strcmp(path + directory_length + 1, event->name) == 0) {
+                    watch->changed[j] = true;
+                    any_changed = true;
+                }
+            }
+        }
+    }
+
+    return any_changed;
+}
+
+int joint_watch(const char * path) {
+    char * root_path = realpath(path, NULL);
+
+    if (root_path == NULL) {
+        fprintf(stderr, "Unable to read file \"%s\"\n", path);
+        return 1;
+    }
+
+    joint_watch_t watch = {
+        .modules_length = 0,
+        .modules = NULL,
+        .changed = NULL,
+        .interfaces = NULL,
+        .directories_length = 0,
+        .directories = NULL
+    };
+
+    watch.fd = inotify_init1(IN_CLOEXEC);
+
+    if (watch.fd < 0) {
+        perror("inotify_init1");
+        free(root_path);
+        return 1;
+    }
+
+    joint_watch_add_module(&watch, root_path);
+    free(root_path);
+    joint_watch_cycle(&watch, joint_stats_now());
+
+    struct pollfd poll_fd = {.fd = watch.fd, .events = POLLIN};
+
+    while (poll(&poll_fd, 1, -1) > 0) {
+        uint64_t started_at = joint_stats_now();
+        bool any_changed = joint_watch_collect_events(&watch);
+
+        while (poll(&poll_fd, 1, JOINT_WATCH_DEBOUNCE_MILLISECONDS) > 0) {
+            any_changed = joint_watch_collect_events(&watch) || any_changed;
+        }
+
+        if (any_changed) {
+            joint_watch_cycle(&watch, started_at);
+        }
+    }
+
+    perror("poll");
+
+    for (int i = 0; i < watch.modules_length; i++) {
+        joint_module_free(watch.modules[i]);
+
+        if (watch.interfaces[i] != NULL) {
+            joint_interface_free(watch.interfaces[i]);
+        }
+    }
+
+    for (int i = 0; i < watch.directories_length; i++) {
+        free(watch.directories[i].path);
+    }
+
+    free(watch.modules);
+    free(watch.changed);
+    free(watch.interfaces);
+    free(watch.directories);
+    close(watch.fd);
+
+    return 1;
+}
@@ -0,0 +1,225 @@
+/* Copyright (c) 2014 Vyacheslav Slinko
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <assert.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include "writer.h"
+
+joint_writer_t * joint_writer_alloc(int fd, size_t capacity) {
+    joint_writer_t * writer = malloc(sizeof(joint_writer_t));
+    assert(writer);
+
+    writer->buffer = malloc(sizeof(char) * capacity);
+    assert(writer->buffer);
+
+    writer->fd = fd;
+    writer->failed = false;
+    writer->capacity = capacity;
+    writer->length = 0;
+
+    return writer;
+}
+
+static void joint_writer_writev(joint_writer_t * writer, struct iovec * iov, int iovcnt) {
+    while (iovcnt > 0 && !writer->failed) {
+        ssize_t written = writev(writer->fd, iov, iovcnt);
+
+        if (written < 0) {
+            if (errno != EINTR) {
+                writer->failed = true;
+            }
+            continue;
+        }
+
+        while (iovcnt > 0 && (size_t) written >= iov->iov_len) {
+            written -= iov->iov_len;
+            iov++;
+            iovcnt--;
+        }
+
+        if (iovcnt > 0) {
+            iov->iov_base = (char *) iov->iov_base + written;
+            iov->iov_len -= written;
+        }
+    }
+}
+
+void joint_writer_write(joint_writer_t * writer, const void * data, size_t length) {
+    if (writer->capacity - writer->length >= length) {
+        memcpy(writer->buffer + writer->length, data, length);
+        writer->length += length;
+        return;
+    }
+
+    struct iovec iov[2] = {
+        {.iov_base = writer->buffer, .iov_len = writer->length},
+        {.iov_base = (void *) data, .iov_len = length}
+    };
+
+    if (length < writer->capacity) {
+        joint_writer_writev(writer, iov, 1);
+        memcpy(writer->buffer, data, length);
+        writer->length = length;
+    } else {
+        joint_writer_writev(writer, iov, 2);
+        writer->length = 0;
+    }
+}
+
+void joint_writer_write_string(joint_writer_t * writer, const char * string) {
+    joint_writer_write(writer, string, strlen(string));
+}
+
+void joint_writer_write_character(joint_writer_t * writer, char character) {
+    if (writer->length == writer->capacity) {
+        joint_writer_flush(writer);
+    }
+
+    writer->buffer[writer->length++] = character;
+}
+
+void joint_writer_write_repeat(joint_writer_t * writer, char character, size_t count) {
+    while (count > 0) {
+        if (writer->length == writer->capacity) {
+            joint_writer_flush(writer);
+        }
+
+        size_t chunk = writer->capacity - writer->length;
+
+        if (chunk > count) {
+            chunk = count;
+        }
+
+        memset(writer->buffer + writer->length, character, chunk);
+        writer->length += chunk;
+        count -= chunk;
+    }
+}
+
+void joint_writer_write_integer(joint_writer_t * writer, int64_t value) {
+    char digits[20];
+    int length = 0;
+    uint64_t magnitude = value < 0 ? -(uint64_t) value : (uint64_t) value;
+
+    do {
+        digits[sizeof(digits) - ++length] = (char) ('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude > 0);
+
+    if (value < 0) {
+        joint_writer_write_character(writer, '-');
+    }
+
+    joint_writer_write(writer, digits + sizeof(digits) - length, length);
+}
+
+void joint_writer_write_number(joint_writer_t * writer, double value) {
+    if (value > -9e18 && value < 9e18 && value == (double) (int64_t) value) {
+        joint_writer_write_integer(writer, (int64_t) value);
+        return;
+    }
+
+    /* Fits any %.17g output, like -2.2250738585072014e-308. */
+    char number[32];
+    bool in_place = writer->capacity >= sizeof(number);
+
+    if (in_place && writer->capacity - writer->length < sizeof(number)) {
+        joint_writer_flush(writer);
+    }
+
+    char * target = in_place ? writer->buffer + writer->length : number;
+    int length = snprintf(target, sizeof(number), "%.17g", value);
+    assert(length > 0 && (size_t) length < sizeof(number));
+
+    if (in_place) {
+        writer->length += (size_t) length;
+    } else {
+        joint_writer_write(writer, number, (size_t) length);
+    }
+}
+
+void joint_writer_write_long_double(joint_writer_t * writer, long double value) {
+    char number[64];
+    int length = snprintf(number, sizeof(number), "%Lf", value);
+
+    if (length < 0 || (size_t) length >= sizeof(number)) {
+        assert(length >= 0);
+        char * large_number = malloc(sizeof(char) * (length + 1));
+        assert(large_number);
+        snprintf(large_number, length + 1, "%Lf", value);
+        joint_writer_write(writer, large_number, length);
+        free(large_number);
+        return;
+    }
+
+    joint_writer_write(writer, number, length);
+}
+
+void joint_writer_write_uint32(joint_writer_t * writer, uint32_t value) {
+    unsigned char bytes[4] = {
+        value & 0xFF,
+        (value >> 8) & 0xFF,
+        (value >> 16) & 0xFF,
+        (value >> 24) & 0xFF
+    };
+
+    joint_writer_write(writer, bytes, sizeof(bytes));
+}
+
+void joint_writer_write_uint64(joint_writer_t * writer, uint64_t value) {
+    joint_writer_write_uint32(writer, (uint32_t) value);
+    joint_writer_write_uint32(writer, (uint32_t) (value >> 32));
+}
+
+void joint_writer_write_double(joint_writer_t * writer, double value) {
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    joint_writer_write_uint64(writer, bits);
+}
+
+void joint_writer_write_padding(joint_writer_t * writer, size_t length, size_t alignment) {
+    size_t remainder = length % alignment;
+
+    if (remainder != 0) {
+        joint_writer_write_repeat(writer, '\0', alignment - remainder);
+    }
+}
+
+bool joint_writer_flush(joint_writer_t * writer) {
+    if (writer->length > 0) {
+        struct iovec iov = {.iov_base = writer->buffer, .iov_len = writer->length};
+        joint_writer_writev(writer, &iov, 1);
+        writer->length = 0;
+    }
+
+    return !writer->failed;
+}
+
+void joint_writer_free(joint_writer_t * writer) {
+    joint_writer_flush(writer);
+    free(writer->buffer);
+    free(writer);
+}
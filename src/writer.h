@@ -0,0 +1,67 @@
+/* Copyright (c) 2014 Vyacheslav Slinko
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef joint_writer_h
+#define joint_writer_h
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct joint_writer {
+    int fd;
+    bool failed;
+    size_t capacity;
+    size_t length;
+    char * buffer;
+} joint_writer_t;
+
+joint_writer_t * joint_writer_alloc(int fd, size_t capacity);
+
+void joint_writer_write(joint_writer_t * writer, const void * data, size_t length);
+
+void joint_writer_write_string(joint_writer_t * writer, const char * string);
+
+void joint_writer_write_character(joint_writer_t * writer, char character);
+
+void joint_writer_write_repeat(joint_writer_t * writer, char character, size_t count);
+
+void joint_writer_write_integer(joint_writer_t * writer, int64_t value);
+
+/* Writes value the way Joint prints numbers, integral values without a
+ * fraction and the rest with %.17g, formatted in the buffer itself. */
+void joint_writer_write_number(joint_writer_t * writer, double value);
+
+void joint_writer_write_long_double(joint_writer_t * writer, long double value);
+
+void joint_writer_write_uint32(joint_writer_t * writer, uint32_t value);
+
+void joint_writer_write_uint64(joint_writer_t * writer, uint64_t value);
+
+void joint_writer_write_double(joint_writer_t * writer, double value);
+
+void joint_writer_write_padding(joint_writer_t * writer, size_t length, size_t alignment);
+
+bool joint_writer_flush(joint_writer_t * writer);
+
+void joint_writer_free(joint_writer_t * writer);
+
+#endif
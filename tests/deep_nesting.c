@@ -0,0 +1,138 @@
+/* Copyright (c) 2014 Vyacheslav Slinko
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/* Checks, compiles and translates to C a call nested many levels deep on a
+ * thread with a small stack, so that any pass still recursing once per
+ * level crashes:
+ *
+ *     deep_nesting [DEPTH]
+ */
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "allocator.h"
+#include "bytecode.h"
+#include "c_backend.h"
+#include "parser.h"
+#include "semantic.h"
+#include "source_file.h"
+#include "tokenizer.h"
+#include "writer.h"
+
+#define JOINT_DEEP_NESTING_STACK_SIZE (256 * 1024)
+
+typedef struct joint_deep_nesting {
+    const char * data;
+    size_t length;
+    const char * failure;
+} joint_deep_nesting_t;
+
+static void * joint_deep_nesting_run(void * argument) {
+    joint_deep_nesting_t * test = argument;
+    joint_allocator_t * allocator = joint_allocator_system();
+
+    joint_source_file_t * source_file = joint_source_file_alloc_borrowed(allocator, "deep.joint", test->data, test->length);
+    joint_tokenizer_t * tokenizer = joint_tokenizer_alloc(allocator, source_file);
+    joint_tokenizer_tokenize(tokenizer);
+
+    joint_parser_t * parser = joint_parser_alloc(allocator, tokenizer);
+
+    int fd = open("/dev/null", O_WRONLY);
+    joint_writer_t * writer = joint_writer_alloc(fd, 1 << 16);
+    joint_bytecode_t * bytecode = NULL;
+
+    if (!joint_parser_parse(parser)) {
+        joint_parser_print_error(parser);
+        test->failure = "parse";
+    } else if (!joint_semantic_check(parser->program, stderr, NULL)) {
+        test->failure = "check";
+    } else if ((bytecode = joint_bytecode_compile(parser->program, parser->constants)) == NULL) {
+        test->failure = "bytecode";
+    } else if (!joint_c_backend_emit(writer, parser->program)) {
+        test->failure = "emit=c";
+    }
+
+    if (bytecode != NULL) {
+        joint_bytecode_free(bytecode);
+    }
+
+    joint_writer_free(writer);
+    close(fd);
+
+    joint_parser_free(parser);
+    joint_tokenizer_free(tokenizer);
+    joint_source_file_free(source_file);
+
+    return NULL;
+}
+
+int main(int argc, char ** argv) {
+    static const char header[] = "import {printLine} from \"io\";\n";
+    size_t depth = argc > 1 ? strtoull(argv[1], NULL, 10) : 200000;
+    size_t length = strlen(header) + depth * strlen("printLine()") + strlen("1;\n");
+    char * data = malloc(length + 1);
+
+    if (data == NULL) {
+        perror("malloc");
+        return 1;
+    }
+
+    char * end = data + strlen(header);
+    memcpy(data, header, strlen(header));
+
+    for (size_t i = 0; i < depth; i++, end += strlen("printLine(")) {
+        memcpy(end, "printLine(", strlen("printLine("));
+    }
+
+    *end++ = '1';
+    memset(end, ')', depth);
+    end += depth;
+    memcpy(end, ";\n", 3);
+
+    joint_deep_nesting_t test = {.data = data, .length = length, .failure = NULL};
+    pthread_attr_t attributes;
+    pthread_t thread;
+
+    pthread_attr_init(&attributes);
+    pthread_attr_setstacksize(&attributes, JOINT_DEEP_NESTING_STACK_SIZE);
+
+    if (pthread_create(&thread, &attributes, joint_deep_nesting_run, &test) != 0) {
+        perror("pthread_create");
+        return 1;
+    }
+
+    pthread_join(thread, NULL);
+    pthread_attr_destroy(&attributes);
+    free(data);
+
+    if (test.failure != NULL) {
+        fprintf(stderr, "Failed to %s %zu nested calls\n", test.failure, depth);
+        return 1;
+    }
+
+    printf("ok %zu nested calls\n", depth);
+
+    return 0;
+}
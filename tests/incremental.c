@@ -0,0 +1,329 @@
+/* Copyright (c) 2014 Vyacheslav Slinko
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/* Applies a fixed series of pseudo-random edits to a parsed buffer and
+ * compares its tokens and tree, or its syntax error, with a fresh parse of
+ * the edited source. Most edits keep the program valid, the others damage it
+ * and are undone by the next edit. Positions are flushed only every few
+ * edits, so that the offsets owed by several edits pile up in between:
+ *
+ *     incremental [EDITS]
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "allocator.h"
+#include "dump.h"
+#include "incremental.h"
+#include "parser.h"
+#include "source_file.h"
+#include "tokenizer.h"
+#include "writer.h"
+
+#define JOINT_INCREMENTAL_FLUSH_EVERY 5
+
+static const char * const joint_incremental_statements[] = {
+    "let a:Number = 1;\n",
+    "printLine(a + 2 * (3 - a));\n",
+    "let s:String = \"Привет\"; printLine(s);\n",
+    "# comment\n",
+    "import {printLine} from \"io\";\n"
+};
+
+static const char * const joint_incremental_fragments[] = {
+    "b",
+    "1",
+    " ",
+    "\n",
+    ";",
+    "(",
+    ")",
+    "+",
+    "\"",
+    "#",
+    ""
+};
+
+#define JOINT_INCREMENTAL_LENGTH(array) (sizeof(array) / sizeof((array)[0]))
+
+typedef struct joint_incremental_buffer {
+    joint_source_file_t * source_file;
+    joint_tokenizer_t * tokenizer;
+    joint_parser_t * parser;
+    bool parsed;
+} joint_incremental_buffer_t;
+
+static uint64_t joint_incremental_random(uint64_t * state) {
+    *state = *state * 6364136223846793005ull + 1442695040888963407ull;
+    return *state >> 33;
+}
+
+/* Moves offset forward to the start of a UTF-8 sequence, at most up to
+ * length. */
+static size_t joint_incremental_boundary(const char * data, size_t length, size_t offset) {
+    if (offset > length) {
+        return length;
+    }
+
+    while (offset < length && ((unsigned char) data[offset] & 0xC0) == 0x80) {
+        offset++;
+    }
+
+    return offset;
+}
+
+static void joint_incremental_open(joint_incremental_buffer_t * buffer, const char * data, size_t length) {
+    joint_allocator_t * allocator = joint_allocator_system();
+    char * content = malloc(length + 1);
+
+    if (content == NULL) {
+        perror("malloc");
+        exit(1);
+    }
+
+    memcpy(content, data, length);
+    content[length] = '\0';
+
+    buffer->source_file = joint_source_file_alloc(allocator, "edited.joint");
+    joint_source_file_adopt(buffer->source_file, content, length);
+    joint_source_file_validate(buffer->source_file);
+
+    buffer->tokenizer = joint_tokenizer_alloc(allocator, buffer->source_file);
+    joint_tokenizer_tokenize(buffer->tokenizer);
+
+    buffer->parser = joint_parser_alloc(allocator, buffer->tokenizer);
+    buffer->parsed = joint_parser_parse(buffer->parser);
+}
+
+static void joint_incremental_close(joint_incremental_buffer_t * buffer) {
+    joint_parser_free(buffer->parser);
+    joint_tokenizer_free(buffer->tokenizer);
+    joint_source_file_free(buffer->source_file);
+}
+
+/* The text dump of the tokens, followed by the tree or the syntax error. */
+static char * joint_incremental_dump(const joint_incremental_buffer_t * buffer, bool parsed) {
+    FILE * file = tmpfile();
+
+    if (file == NULL) {
+        perror("tmpfile");
+        exit(1);
+    }
+
+    joint_writer_t * writer = joint_writer_alloc(fileno(file), 1 << 16);
+    joint_dump_tokens(writer, buffer->tokenizer, TEXT_DUMP_FORMAT);
+
+    if (parsed) {
+        joint_dump_node(writer, buffer->parser->program, TEXT_DUMP_FORMAT);
+    } else {
+        char error[1024];
+        joint_parser_format_error(buffer->parser, error, sizeof(error));
+        joint_writer_write_string(writer, error);
+    }
+
+    joint_writer_free(writer);
+
+    long length = ftell(file);
+    char * dump = malloc((size_t) length + 1);
+
+    if (dump == NULL || fseek(file, 0, SEEK_SET) != 0 || fread(dump, 1, (size_t) length, file) != (size_t) length) {
+        perror("tmpfile");
+        exit(1);
+    }
+
+    dump[length] = '\0';
+    fclose(file);
+
+    return dump;
+}
+
+typedef struct joint_incremental_undo {
+    bool pending;
+    size_t offset;
+    size_t length;
+    char removed[16];
+} joint_incremental_undo_t;
+
+/* Offset of the first byte at or after offset that matches, or length. */
+static size_t joint_incremental_find(const joint_string_t * content, size_t offset, bool (* match)(char character)) {
+    while (offset < content->length && !match(content->data[offset])) {
+        offset++;
+    }
+
+    return offset;
+}
+
+static bool joint_incremental_is_newline(char character) {
+    return character == '\n';
+}
+
+static bool joint_incremental_is_semicolon(char character) {
+    return character == ';';
+}
+
+static bool joint_incremental_is_digit(char character) {
+    return character >= '0' && character <= '9';
+}
+
+static void joint_incremental_next_edit(const joint_string_t * content, uint64_t * state, joint_incremental_undo_t * undo, joint_incremental_edit_t * edit, char * inserted) {
+    size_t offset = joint_incremental_random(state) % (content->length + 1);
+    size_t found;
+
+    inserted[0] = '\0';
+    edit->offset = offset;
+    edit->removed_length = 0;
+
+    if (undo->pending) {
+        edit->offset = undo->offset;
+        edit->removed_length = undo->length;
+        strcpy(inserted, undo->removed);
+        undo->pending = false;
+    } else {
+        switch (joint_incremental_random(state) % 6) {
+            case 0:
+                found = joint_incremental_find(content, offset, joint_incremental_is_newline);
+                edit->offset = found < content->length ? found + 1 : content->length;
+                strcpy(inserted, joint_incremental_statements[joint_incremental_random(state) % JOINT_INCREMENTAL_LENGTH(joint_incremental_statements)]);
+                break;
+
+            case 1:
+                found = joint_incremental_find(content, offset, joint_incremental_is_newline);
+
+                if (found < content->length && content->length > 256) {
+                    size_t line_end = joint_incremental_find(content, found + 1, joint_incremental_is_newline);
+                    edit->offset = found + 1;
+                    edit->removed_length = (line_end < content->length ? line_end + 1 : line_end) - edit->offset;
+                }
+                break;
+
+            case 2:
+                found = joint_incremental_find(content, offset, joint_incremental_is_semicolon);
+                edit->offset = found < content->length ? found + 1 : content->length;
+                strcpy(inserted, joint_incremental_random(state) % 2 == 0 ? " " : "\n\n");
+                break;
+
+            case 3:
+                found = joint_incremental_find(content, offset, joint_incremental_is_digit);
+
+                if (found < content->length) {
+                    edit->offset = found;
+                    edit->removed_length = 1;
+                    inserted[0] = (char) ('0' + joint_incremental_random(state) % 10);
+                    inserted[1] = '\0';
+                }
+                break;
+
+            default:
+                edit->offset = joint_incremental_boundary(content->data, content->length, offset);
+                edit->removed_length = joint_incremental_boundary(content->data, content->length, edit->offset + joint_incremental_random(state) % 9) - edit->offset;
+                strcpy(inserted, joint_incremental_fragments[joint_incremental_random(state) % JOINT_INCREMENTAL_LENGTH(joint_incremental_fragments)]);
+
+                undo->pending = true;
+                undo->offset = edit->offset;
+                undo->length = strlen(inserted);
+                memcpy(undo->removed, content->data + edit->offset, edit->removed_length);
+                undo->removed[edit->removed_length] = '\0';
+                break;
+        }
+    }
+
+    edit->inserted = inserted;
+    edit->inserted_length = strlen(inserted);
+}
+
+int main(int argc, char ** argv) {
+    int edits = argc > 1 ? atoi(argv[1]) : 2000;
+    uint64_t state = 42;
+
+    size_t length = 0;
+    char * source = malloc(64 * 1024);
+
+    if (source == NULL) {
+        perror("malloc");
+        return 1;
+    }
+
+    for (int i = 0; i < 60; i++) {
+        const char * statement = joint_incremental_statements[i % JOINT_INCREMENTAL_LENGTH(joint_incremental_statements)];
+        memcpy(source + length, statement, strlen(statement));
+        length += strlen(statement);
+    }
+
+    joint_incremental_buffer_t buffer;
+    joint_incremental_open(&buffer, source, length);
+
+    if (!buffer.parsed) {
+        joint_parser_print_error(buffer.parser);
+        return 1;
+    }
+
+    joint_incremental_t * incremental = joint_incremental_alloc(buffer.parser);
+    joint_incremental_undo_t undo = {.pending = false};
+    int failures = 0;
+
+    for (int i = 1; i <= edits && failures == 0; i++) {
+        joint_incremental_edit_t edit;
+        char inserted[64];
+
+        joint_incremental_next_edit(buffer.source_file->content, &state, &undo, &edit, inserted);
+
+        joint_incremental_result_t result;
+        bool parsed = joint_incremental_apply(incremental, &edit, &result);
+
+        joint_incremental_buffer_t fresh;
+        joint_incremental_open(&fresh, buffer.source_file->content->data, buffer.source_file->content->length);
+
+        if (parsed != fresh.parsed) {
+            fprintf(stderr, "Edit %d: incremental parse %s, fresh parse %s\n", i, parsed ? "succeeded" : "failed", fresh.parsed ? "succeeded" : "failed");
+            failures++;
+        } else if (i % JOINT_INCREMENTAL_FLUSH_EVERY == 0) {
+            joint_incremental_flush(incremental);
+
+            char * expected = joint_incremental_dump(&fresh, fresh.parsed);
+            char * actual = joint_incremental_dump(&buffer, parsed);
+
+            if (strcmp(expected, actual) != 0) {
+                fprintf(stderr, "Edit %d: incremental parse differs from a fresh parse of\n%s\n", i, buffer.source_file->content->data);
+                failures++;
+            }
+
+            free(expected);
+            free(actual);
+        }
+
+        joint_incremental_close(&fresh);
+    }
+
+    joint_incremental_free(incremental);
+    joint_incremental_close(&buffer);
+    free(source);
+
+    if (failures > 0) {
+        return 1;
+    }
+
+    printf("ok %d edits\n", edits);
+
+    return 0;
+}
@@ -0,0 +1,203 @@
+/* Copyright (c) 2014 Vyacheslav Slinko
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/* Tokenizes and parses a program placed after a sparse hole of several GiB,
+ * so that positions need 64 bits, then round-trips the tokens and the tree
+ * through the WIDE binary dump and compares their text dumps. The hole is
+ * skipped rather than read, so the test needs little memory and disk. */
+
+#include <assert.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "allocator.h"
+#include "dump.h"
+#include "parser.h"
+#include "source_file.h"
+#include "tokenizer.h"
+#include "writer.h"
+
+static const char joint_large_source_program[] =
+    "# Past the hole\n"
+    "let greeting:String = \"Привет\";\n"
+    "let answer:Number = 40 + 2;\n"
+    "printLine(greeting, answer);\n";
+
+static int joint_large_source_temporary(const char * directory, const char * name, char * path, size_t path_length) {
+    snprintf(path, path_length, "%s/%sXXXXXX", directory, name);
+
+    int fd = mkstemp(path);
+
+    if (fd < 0) {
+        perror(path);
+        exit(1);
+    }
+
+    return fd;
+}
+
+static void * joint_large_source_map(int fd, size_t * length) {
+    struct stat status;
+
+    if (fstat(fd, &status) != 0) {
+        perror("fstat");
+        exit(1);
+    }
+
+    *length = (size_t) status.st_size;
+
+    void * data = mmap(NULL, *length, PROT_READ, MAP_PRIVATE, fd, 0);
+
+    if (data == MAP_FAILED) {
+        perror("mmap");
+        exit(1);
+    }
+
+    return data;
+}
+
+/* Text dumps of the original and the reloaded results must be equal. */
+static void joint_large_source_compare(const char * directory, const joint_tokenizer_t * tokenizer, joint_node_t * program, const joint_tokenizer_t * loaded_tokenizer, joint_node_t * loaded_program) {
+    char paths[2][4096];
+    void * data[2];
+    size_t lengths[2];
+    int fds[2];
+
+    for (int i = 0; i < 2; i++) {
+        fds[i] = joint_large_source_temporary(directory, "joint-text-", paths[i], sizeof(paths[i]));
+
+        joint_writer_t * writer = joint_writer_alloc(fds[i], 1 << 16);
+        joint_dump_tokens(writer, i == 0 ? tokenizer : loaded_tokenizer, TEXT_DUMP_FORMAT);
+        joint_dump_node(writer, i == 0 ? program : loaded_program, TEXT_DUMP_FORMAT);
+        joint_writer_free(writer);
+
+        data[i] = joint_large_source_map(fds[i], &lengths[i]);
+    }
+
+    if (lengths[0] != lengths[1] || memcmp(data[0], data[1], lengths[0]) != 0) {
+        fprintf(stderr, "Text dumps differ, see \"%s\" and \"%s\"\n", paths[0], paths[1]);
+        exit(1);
+    }
+
+    for (int i = 0; i < 2; i++) {
+        munmap(data[i], lengths[i]);
+        close(fds[i]);
+        unlink(paths[i]);
+    }
+}
+
+int main(int argc, char ** argv) {
+    const char * directory = getenv("TMPDIR") != NULL ? getenv("TMPDIR") : "/tmp";
+    size_t hole_length = (size_t) (argc > 1 ? strtoull(argv[1], NULL, 10) : 5) << 30;
+    size_t program_length = sizeof(joint_large_source_program) - 1;
+
+    if (hole_length <= UINT32_MAX) {
+        fprintf(stderr, "The hole must be larger than 4 GiB\n");
+        return 1;
+    }
+
+    char source_path[4096];
+    int source_fd = joint_large_source_temporary(directory, "joint-large-", source_path, sizeof(source_path));
+
+    if (ftruncate(source_fd, (off_t) hole_length) != 0 || pwrite(source_fd, joint_large_source_program, program_length, (off_t) hole_length) != (ssize_t) program_length) {
+        perror(source_path);
+        unlink(source_path);
+        return 1;
+    }
+
+    size_t source_length;
+    const char * source = joint_large_source_map(source_fd, &source_length);
+    joint_allocator_t * allocator = joint_allocator_system();
+
+    joint_source_file_t * source_file = joint_source_file_alloc_borrowed(allocator, source_path, source, source_length);
+    source_file->ascii = false;
+
+    joint_tokenizer_t * tokenizer = joint_tokenizer_alloc(allocator, source_file);
+    tokenizer->current_position = hole_length;
+    tokenizer->current_line_start_position = hole_length;
+    joint_tokenizer_tokenize(tokenizer);
+
+    joint_parser_t * parser = joint_parser_alloc(allocator, tokenizer);
+    bool parsed = joint_parser_parse(parser);
+    assert(parsed);
+
+    assert(tokenizer->tokens_length > 0);
+    assert(tokenizer->tokens[0]->start_position->position == hole_length);
+    assert(tokenizer->tokens[tokenizer->tokens_length - 1]->end_position->position > UINT32_MAX);
+
+    size_t tokens_count = tokenizer->tokens_length;
+
+    char dump_path[4096];
+    int dump_fd = joint_large_source_temporary(directory, "joint-dump-", dump_path, sizeof(dump_path));
+
+    joint_writer_t * writer = joint_writer_alloc(dump_fd, 1 << 16);
+    joint_dump_tokens(writer, tokenizer, BINARY_DUMP_FORMAT);
+    joint_dump_node(writer, parser->program, BINARY_DUMP_FORMAT);
+    joint_writer_free(writer);
+
+    size_t dump_length;
+    const char * dump = joint_large_source_map(dump_fd, &dump_length);
+    uint32_t flags;
+
+    memcpy(&flags, dump + 12, sizeof(flags));
+    assert(memcmp(dump, JOINT_DUMP_BINARY_MAGIC, 4) == 0);
+    assert(flags & JOINT_DUMP_BINARY_WIDE);
+
+    size_t tokens_length = 0;
+    size_t program_dump_length = 0;
+    joint_tokenizer_t * loaded_tokenizer = joint_tokenizer_alloc(allocator, source_file);
+
+    if (!joint_dump_load_tokens(dump, dump_length, loaded_tokenizer, &tokens_length)) {
+        fprintf(stderr, "Unable to load tokens from \"%s\"\n", dump_path);
+        return 1;
+    }
+
+    joint_node_t * loaded_program = joint_dump_load_node(allocator, dump + tokens_length, dump_length - tokens_length, source_path, &program_dump_length);
+
+    if (loaded_program == NULL || tokens_length + program_dump_length != dump_length) {
+        fprintf(stderr, "Unable to load the tree from \"%s\"\n", dump_path);
+        return 1;
+    }
+
+    joint_large_source_compare(directory, tokenizer, parser->program, loaded_tokenizer, loaded_program);
+
+    joint_node_free(loaded_program);
+    joint_tokenizer_free(loaded_tokenizer);
+    joint_parser_free(parser);
+    joint_tokenizer_free(tokenizer);
+    joint_source_file_free(source_file);
+
+    munmap((void *) dump, dump_length);
+    close(dump_fd);
+    unlink(dump_path);
+    munmap((void *) source, source_length);
+    close(source_fd);
+    unlink(source_path);
+
+    printf("ok %zu tokens past %zu bytes\n", tokens_count, hole_length);
+
+    return 0;
+}